@@ -19,18 +19,24 @@
 #include "modbus/model/ModuleConfiguration.h"
 #include "modbus/module/ModbusBridge.h"
 #include "modbus/module/WolkaboutTemplateFactory.h"
+#include "modbus/module/outbound/OutboundPublisher.h"
+#include "modbus/module/outbound/StoreAndForwardRing.h"
 #include "modbus/module/persistence/JsonFilePersistence.h"
+#include "modbus/module/transport/EpollTcpTransport.h"
+#include "modbus/module/transport/LibModbusClient.h"
+#include "modbus/module/transport/ModbusClientTransport.h"
 #include "modbus/utilities/JsonReaderParser.h"
 #include "more_modbus/mappings/StringMapping.h"
-#include "more_modbus/modbus/LibModbusSerialRtuClient.h"
-#include "more_modbus/modbus/LibModbusTcpIpClient.h"
 #include "wolk/WolkMulti.h"
 #include "wolk/api/PlatformStatusListener.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <csignal>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <utility>
@@ -45,12 +51,19 @@ const std::string REPEATED_WRITE_PERSISTENCE_FILE = "./repeat-write.json";
 const std::string SAFE_MODE_WRITE_PERSISTENCE_FILE = "./safe-mode.json";
 
 using RegistrationDataMap = std::map<std::string, std::unique_ptr<DeviceRegistrationData>>;
-using DeviceMap = std::map<std::uint16_t, std::unique_ptr<Device>>;
-using DeviceTypeMap = std::map<std::string, std::vector<std::uint16_t>>;
+using DeviceMap = std::map<std::string, std::unique_ptr<DeviceInformation>>;
+using DeviceTypeMap = std::map<std::string, std::vector<std::string>>;
+using ModbusTransportMap = std::map<std::string, std::shared_ptr<ModbusTransport>>;
 
 namespace
 {
 const auto LOG_FILE = "/var/log/modbusModule/wolkgatewaymodule-modbus.log";
+// The highest slave address that can be assigned to a device
+const std::uint16_t MAX_SLAVE_ADDRESS = 247;
+// The unit identifier used for a TCP/IP device that doesn't state one
+const std::uint16_t TCP_DEFAULT_UNIT_ID = 255;
+// The count of pushes every thread handing over values can have waiting for the publisher
+const std::size_t OUTBOUND_LANE_CAPACITY = 4096;
 }
 
 RegistrationDataMap generateRegistrationData(const DevicesConfiguration& devicesConfiguration)
@@ -69,28 +82,61 @@ std::pair<DeviceMap, DeviceTypeMap> generateDevices(const ModuleConfiguration& m
     // Make place for the values we are going to return.
     auto deviceMap = DeviceMap{};
     auto deviceTypeMap = DeviceTypeMap{};
+    const auto& buses = moduleConfiguration.getBuses();
+
+    // Every device needs to be on a bus. If there's only one bus, the devices don't need to state it.
+    for (const auto& deviceInformation : devicesConfiguration.getDevices())
+    {
+        auto& info = *deviceInformation.second;
+        if (info.getBus().empty() && buses.size() == 1)
+            info.setBus(buses.cbegin()->first);
+    }
 
     // Parse devices with templates to Device
-    // We need to check, in the SERIAL/RTU, that all devices have a slave address
-    // and that they're different from one another. In TCP/IP mode, we can have only
-    // one device, so we need to check for that (and assign it a slaveAddress, because -1 is an invalid address).
+    // We need to check that all devices have a valid slave address and that they're different from one another
+    // on the same bus. In TCP/IP mode, the slave address is the unit identifier, used by TCP-to-RTU gateways to address
+    // the devices behind them. A single TCP/IP device on a bus doesn't need to state it, and is assigned the unit
+    // identifier 255.
+    auto occupiedAddresses = std::set<std::pair<std::string, std::uint16_t>>{};
 
     // Go through the devices from the config
     for (const auto& deviceInformation : devicesConfiguration.getDevices())
     {
-        // Check the slave address
+        // Check the bus
         auto& info = *deviceInformation.second;
-        // If it doesn't at all have a slaveAddress or if the slaveAddress is already occupied
+        const auto busIt = buses.find(info.getBus());
+        if (busIt == buses.cend())
+        {
+            LOG(WARN) << "Device " << info.getName() << " is not on a valid bus. Ignoring device...";
+            continue;
+        }
+
+        // Check the slave address
+        const auto isTcpIp = busIt->second->getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP;
+        const auto devicesOnBus = std::count_if(
+          devicesConfiguration.getDevices().cbegin(), devicesConfiguration.getDevices().cend(),
+          [&](const std::pair<const std::string, std::unique_ptr<DeviceInformation>>& pair)
+          { return pair.second->getBus() == info.getBus(); });
+        if (info.getSlaveAddress() == 0 && isTcpIp && devicesOnBus == 1)
+            info.setSlaveAddress(TCP_DEFAULT_UNIT_ID);
+
+        // If it doesn't at all have a slaveAddress, the slaveAddress is out of range or already occupied
         // device is not valid.
         if (info.getSlaveAddress() == 0)
         {
             LOG(WARN) << "Device " << info.getName() << " is missing a slave address. Ignoring device...";
             continue;
         }
-        const auto deviceIt = deviceMap.find(info.getSlaveAddress());
-        if (deviceIt != deviceMap.cend())
+        if (info.getSlaveAddress() > MAX_SLAVE_ADDRESS && !(isTcpIp && info.getSlaveAddress() == TCP_DEFAULT_UNIT_ID))
+        {
+            LOG(WARN) << "Device " << info.getName() << " has an invalid slave address " << info.getSlaveAddress()
+                      << ". Ignoring device...";
+            continue;
+        }
+        if (occupiedAddresses.find({info.getBus(), info.getSlaveAddress()}) != occupiedAddresses.cend())
         {
             LOG(WARN) << "Device " << info.getName() << " has a conflicting slave address. Ignoring device...";
+            continue;
         }
 
         // Assign the DeviceRegistrationData
@@ -98,16 +144,12 @@ std::pair<DeviceMap, DeviceTypeMap> generateDevices(const ModuleConfiguration& m
         const auto& pair = deviceRegistrationData.find(templateName);
         if (pair != deviceRegistrationData.end())
         {
-            // Create the device with the registration data, push the slave address as occupied
-            auto registrationData = *pair->second;
-            deviceMap.emplace(info.getSlaveAddress(), std::unique_ptr<Device>{new Device{
-                                                        info.getKey(), "", OutboundDataMode::PUSH, info.getName()}});
-
-            // Emplace the template name in usedTemplates array for modbusBridge, and the slaveAddress
-            if (deviceTypeMap.find(templateName) != deviceTypeMap.end())
-                deviceTypeMap[templateName].emplace_back(info.getSlaveAddress());
-            else
-                deviceTypeMap.emplace(templateName, std::vector<std::uint16_t>{info.getSlaveAddress()});
+            // Create the device, push the slave address as occupied
+            deviceMap.emplace(info.getKey(), std::unique_ptr<DeviceInformation>{new DeviceInformation{info}});
+            occupiedAddresses.emplace(info.getBus(), info.getSlaveAddress());
+
+            // Emplace the template name in usedTemplates array for modbusBridge, and the device key
+            deviceTypeMap[templateName].emplace_back(info.getKey());
         }
         else
         {
@@ -119,6 +161,67 @@ std::pair<DeviceMap, DeviceTypeMap> generateDevices(const ModuleConfiguration& m
     return std::make_pair(std::move(deviceMap), std::move(deviceTypeMap));
 }
 
+std::unique_ptr<AdaptiveTimeoutConfiguration> copyAdaptiveTimeout(
+  const std::unique_ptr<AdaptiveTimeoutConfiguration>& adaptiveTimeout)
+{
+    return adaptiveTimeout != nullptr ?
+             std::unique_ptr<AdaptiveTimeoutConfiguration>(new AdaptiveTimeoutConfiguration(*adaptiveTimeout)) :
+             nullptr;
+}
+
+ModbusTransportMap generateModbusTransports(const ModuleConfiguration& moduleConfiguration)
+{
+    // Create the modbus transport for every bus based on parsed information
+    // Pass configuration parameters necessary to initialize the connection
+    // according to the type of connection that the user required and setup.
+    // All the non-blocking buses share a single event loop.
+    auto modbusTransports = ModbusTransportMap{};
+    auto epollTransport = std::shared_ptr<EpollTcpTransport>{};
+    for (const auto& bus : moduleConfiguration.getBuses())
+    {
+        const auto& busConfiguration = *bus.second;
+        if (busConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP &&
+            busConfiguration.isNonBlocking())
+        {
+            if (epollTransport == nullptr)
+                epollTransport = std::make_shared<EpollTcpTransport>();
+            const auto& tcpConfiguration = busConfiguration.getTcpIpConfiguration();
+            epollTransport->addEndpoint(bus.first, tcpConfiguration->getIp(),
+                                        static_cast<std::uint16_t>(tcpConfiguration->getPort()),
+                                        busConfiguration.getResponseTimeout(),
+                                        copyAdaptiveTimeout(busConfiguration.getAdaptiveTimeoutConfiguration()));
+            modbusTransports.emplace(bus.first, epollTransport);
+        }
+        else if (busConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP)
+        {
+            const auto& tcpConfiguration = busConfiguration.getTcpIpConfiguration();
+            modbusTransports.emplace(
+              bus.first, std::make_shared<ModbusClientTransport>(
+                           std::make_shared<LibModbusClient>(tcpConfiguration->getIp(), tcpConfiguration->getPort(),
+                                                             busConfiguration.getResponseTimeout()),
+                           busConfiguration.getResponseTimeout(),
+                           copyAdaptiveTimeout(busConfiguration.getAdaptiveTimeoutConfiguration())));
+        }
+        else if (busConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::SERIAL_RTU)
+        {
+            const auto& serialConfiguration = busConfiguration.getSerialRtuConfiguration();
+            modbusTransports.emplace(
+              bus.first, std::make_shared<ModbusClientTransport>(
+                           std::make_shared<LibModbusClient>(
+                             serialConfiguration->getSerialPort(), serialConfiguration->getBaudRate(),
+                             serialConfiguration->getDataBits(), serialConfiguration->getStopBits(),
+                             serialConfiguration->getBitParity(), busConfiguration.getResponseTimeout()),
+                           busConfiguration.getResponseTimeout(),
+                           copyAdaptiveTimeout(busConfiguration.getAdaptiveTimeoutConfiguration())));
+        }
+        else
+        {
+            throw std::logic_error("Unsupported Modbus implementation specified in module configuration file");
+        }
+    }
+    return modbusTransports;
+}
+
 class StateHandler : public PlatformStatusListener
 {
 public:
@@ -137,12 +240,10 @@ public:
 
     void changeConnected(bool connected)
     {
+        // The devices are still read while the connection is lost, and their readings are kept until it's back
         m_connected = connected;
-        if (!connected)
-            m_modbusBridge.stop();
-        else if (connected)
-            if (m_registered)
-                m_modbusBridge.start();
+        if (connected && m_registered)
+            m_modbusBridge.start();
     }
 
     void changeRegistered(bool registered)
@@ -165,8 +266,8 @@ private:
     ModbusBridge& m_modbusBridge;
     std::function<void(bool)> m_platformStatusCallback;
 
-    bool m_connected;
-    bool m_registered;
+    std::atomic_bool m_connected;
+    std::atomic_bool m_registered;
 };
 
 wolkabout::legacy::LogLevel parseLogLevel(const std::string& levelStr)
@@ -199,6 +300,13 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    // The termination signals are blocked before any thread is started, so they are only taken by the wait at the end
+    auto terminationSignals = sigset_t{};
+    sigemptyset(&terminationSignals);
+    sigaddset(&terminationSignals, SIGINT);
+    sigaddset(&terminationSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &terminationSignals, nullptr);
+
     // Setup logger
     const auto level = [&] {
         if (argc > 3)
@@ -238,44 +346,8 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    // Cut the execution right away if the user wants multiple TCP/IP devices.
-    if (moduleConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP &&
-        devicesConfiguration.getDevices().size() != 1)
-    {
-        LOG(ERROR) << "Application supports exactly one device in TCP/IP mode.";
-        return 1;
-    }
-
-    // Warn the user if they're using more templates in TCP/IP.
-    // Since TCP/IP supports only one device, you should have only one template.
-    if (moduleConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP &&
-        devicesConfiguration.getTemplates().size() != 1)
-    {
-        LOG(WARN) << "Using more than 1 template in TCP/IP mode is unnecessary. There can only be 1 TCP/IP device "
-                  << "per module, which can use only one template.";
-    }
-
-    // Create the modbus client based on parsed information
-    // Pass configuration parameters necessary to initialize the connection
-    // according to the type of connection that the user required and setup.
-    auto libModbusClient = [&]() -> std::shared_ptr<ModbusClient> {
-        if (moduleConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::TCP_IP)
-        {
-            const auto& tcpConfiguration = moduleConfiguration.getTcpIpConfiguration();
-            return std::make_shared<LibModbusTcpIpClient>(tcpConfiguration->getIp(), tcpConfiguration->getPort(),
-                                                          moduleConfiguration.getResponseTimeout());
-        }
-        else if (moduleConfiguration.getConnectionType() == ModuleConfiguration::ConnectionType::SERIAL_RTU)
-        {
-            const auto& serialConfiguration = moduleConfiguration.getSerialRtuConfiguration();
-            return std::make_shared<LibModbusSerialRtuClient>(
-              serialConfiguration->getSerialPort(), serialConfiguration->getBaudRate(),
-              serialConfiguration->getDataBits(), serialConfiguration->getStopBits(),
-              serialConfiguration->getBitParity(), moduleConfiguration.getResponseTimeout());
-        }
-
-        throw std::logic_error("Unsupported Modbus implementation specified in module configuration file");
-    }();
+    // Create the modbus transports, one for every bus
+    auto modbusTransports = generateModbusTransports(moduleConfiguration);
     auto registrationData = generateRegistrationData(devicesConfiguration);
 
     // Execute linking logic
@@ -301,7 +373,10 @@ int main(int argc, char** argv)
     // Pass everything necessary to initialize the bridge
     LOG(DEBUG) << "Initializing the bridge...";
     auto modbusBridge = std::make_shared<ModbusBridge>(
-      libModbusClient, moduleConfiguration.getRegisterReadPeriod(),
+      modbusTransports, moduleConfiguration.getRegisterReadPeriod(), moduleConfiguration.getReadGapTolerance(),
+      HealthPolicy{moduleConfiguration.getFailuresBeforeQuarantine(), moduleConfiguration.getProbeInterval(),
+                   moduleConfiguration.getMaxProbeInterval()},
+      moduleConfiguration.getReadAfterWriteWindow(),
       std::unique_ptr<JsonFilePersistence>{new JsonFilePersistence(DEFAULT_VALUE_PERSISTENCE_FILE)},
       std::unique_ptr<JsonFilePersistence>{new JsonFilePersistence(REPEATED_WRITE_PERSISTENCE_FILE)},
       std::unique_ptr<JsonFilePersistence>{new JsonFilePersistence(SAFE_MODE_WRITE_PERSISTENCE_FILE)});
@@ -318,19 +393,47 @@ int main(int argc, char** argv)
                   .withRegistration()
                   .buildWolkMulti();
 
+    // The values are handed over to the publisher thread, so the polling never waits for the Wolk instance
+    auto outboundPublisher = std::make_shared<OutboundPublisher>(
+      [&](const std::string& deviceKey, const std::vector<Reading>& readings) {
+          wolk->addReadings(deviceKey, readings);
+      },
+      [&](const std::string& deviceKey, const std::vector<Attribute>& attributes) {
+          for (const auto& attribute : attributes)
+              wolk->addAttribute(deviceKey, attribute);
+      },
+      [&] { return stateHandler->isConnected() && stateHandler->isRegistered(); }, [&] { wolk->publish(); },
+      std::unique_ptr<OutboundBuffer>{new OutboundBuffer(
+        moduleConfiguration.getOutboundBufferLimit(),
+        [&](const std::string& deviceKey, const std::string& reference) {
+            return modbusBridge->isLossless(deviceKey, reference);
+        })},
+      moduleConfiguration.getPublishValueCount(), moduleConfiguration.getPublishLatency(), OUTBOUND_LANE_CAPACITY);
+
+    // The readings made while the platform can't be reached are kept in a file, if there's one configured
+    const auto& storeAndForward = moduleConfiguration.getStoreAndForwardConfiguration();
+    if (storeAndForward != nullptr)
+    {
+        auto ring = std::unique_ptr<StoreAndForwardRing>{new StoreAndForwardRing(
+          storeAndForward->getPath(), storeAndForward->getSize(), storeAndForward->getCommitInterval())};
+        if (ring->open())
+            outboundPublisher->setStoreAndForward(
+              std::move(ring), storeAndForward->getReplayRate(),
+              [&](const std::string& deviceKey, const std::map<std::uint64_t, std::vector<Reading>>& readings) {
+                  wolk->addReadings(deviceKey, readings);
+              });
+        else
+            LOG(ERROR) << "Failed to open the store and forward file - the readings will only be kept in memory.";
+    }
+
     // Setup all the necessary callbacks for value changes from inside the modbusBridge
     modbusBridge->setFeedValueCallback([&](const std::string& deviceKey, const std::vector<Reading>& readings) {
-        wolk->addReadings(deviceKey, readings);
+        outboundPublisher->pushReadings(deviceKey, readings);
     });
-    modbusBridge->setAttributeCallback(
-      [&](const std::string& deviceKey, const Attribute& attribute) { wolk->addAttribute(deviceKey, attribute); });
-
-    // Track if we registered or not
-    auto connected = false;
-    auto registered = false;
-    std::mutex mutex;
-    std::condition_variable variable;
-    std::unique_lock<std::mutex> lock{mutex};
+    modbusBridge->setAttributeCallback([&](const std::string& deviceKey, const std::vector<Attribute>& attributes) {
+        outboundPublisher->pushAttributes(deviceKey, attributes);
+    });
+    outboundPublisher->start();
 
     // Set up the connection status listener to trigger states
     auto devicesToRegister = std::vector<DeviceRegistrationData>{};
@@ -391,12 +494,16 @@ int main(int argc, char** argv)
     });
 
     wolk->connect();
-    while (modbusBridge != nullptr)
-    {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        if (stateHandler->isConnected() && stateHandler->isRegistered())
-            wolk->publish();
-    }
-
+    // Everything is driven by the threads of the bridge, the publisher and the Wolk instance until the module is told
+    // to terminate
+    auto signal = 0;
+    sigwait(&terminationSignals, &signal);
+    LOG(INFO) << "Received signal " << signal << ". Stopping the module...";
+
+    // The devices are no longer read first, so the publisher hands over everything they produced before it stops
+    modbusBridge->stop();
+    outboundPublisher->stop();
+    wolk->publish();
+    wolk->disconnect();
     return 0;
 }
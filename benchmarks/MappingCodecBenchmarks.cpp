@@ -0,0 +1,153 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/model/ModuleMapping.h"
+#include "modbus/module/MappingCodec.h"
+#include "modbus/module/RegisterMappingFactory.h"
+#include "more_modbus/utilities/DataParsers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace wolkabout;
+using namespace wolkabout::modbus;
+using Endian = more_modbus::DataParsers::Endian;
+
+namespace
+{
+std::shared_ptr<more_modbus::RegisterMapping> makeMapping(const std::string& dataType, const std::string& operationType)
+{
+    return RegisterMappingFactory::fromJSONMapping(ModuleMapping{nlohmann::json{{"name", "Value"},
+                                                                                {"reference", "V"},
+                                                                                {"registerType", "HOLDING_REGISTER"},
+                                                                                {"dataType", dataType},
+                                                                                {"operationType", operationType},
+                                                                                {"address", 0}}});
+}
+
+Endian endianOf(const more_modbus::RegisterMapping& mapping)
+{
+    return mapping.getOperationType() == more_modbus::OperationType::MERGE_LITTLE_ENDIAN ||
+               mapping.getOperationType() == more_modbus::OperationType::MERGE_FLOAT_LITTLE_ENDIAN ?
+             Endian::LITTLE :
+             Endian::BIG;
+}
+
+// The conversions as they were done before the codecs, going through the types of the mapping for every value
+Reading switchDecodeReading(const more_modbus::RegisterMapping& mapping, const std::vector<std::uint16_t>& registers)
+{
+    const auto endian = endianOf(mapping);
+    switch (mapping.getOutputType())
+    {
+    case more_modbus::OutputType::UINT16:
+        return {mapping.getReference(), static_cast<std::uint64_t>(registers.at(0))};
+    case more_modbus::OutputType::INT16:
+        return {mapping.getReference(), static_cast<std::int64_t>(static_cast<std::int16_t>(registers.at(0)))};
+    case more_modbus::OutputType::UINT32:
+        return {mapping.getReference(),
+                static_cast<std::uint64_t>(more_modbus::DataParsers::registersToUint32(registers, endian))};
+    case more_modbus::OutputType::INT32:
+        return {mapping.getReference(),
+                static_cast<std::int64_t>(more_modbus::DataParsers::registersToInt32(registers, endian))};
+    case more_modbus::OutputType::FLOAT:
+        return {mapping.getReference(), more_modbus::DataParsers::registersToFloat(registers, endian)};
+    default:
+        return {"", false};
+    }
+}
+
+MappingCodec::EncodedValue switchEncode(const more_modbus::RegisterMapping& mapping, const std::string& value)
+{
+    const auto endian = endianOf(mapping);
+    switch (mapping.getOutputType())
+    {
+    case more_modbus::OutputType::UINT16:
+        return {{static_cast<std::uint16_t>(std::stoul(value))}, false};
+    case more_modbus::OutputType::INT16:
+        return {{static_cast<std::uint16_t>(static_cast<std::int16_t>(std::stoi(value)))}, false};
+    case more_modbus::OutputType::UINT32:
+        return {more_modbus::DataParsers::uint32ToRegisters(static_cast<std::uint32_t>(std::stoul(value)), endian),
+                false};
+    case more_modbus::OutputType::INT32:
+        return {more_modbus::DataParsers::int32ToRegisters(std::stoi(value), endian), false};
+    case more_modbus::OutputType::FLOAT:
+        return {more_modbus::DataParsers::floatToRegisters(std::stof(value), endian), false};
+    default:
+        throw std::runtime_error("The mapping has an unknown output type.");
+    }
+}
+
+void decodeFloatReadingWithSwitch(benchmark::State& state)
+{
+    const auto mapping = makeMapping("FLOAT", "MERGE_FLOAT_BIG_ENDIAN");
+    const auto registers = std::vector<std::uint16_t>{0x4148, 0x0000};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(switchDecodeReading(*mapping, registers));
+}
+
+void decodeFloatReadingWithCodec(benchmark::State& state)
+{
+    const auto mapping = makeMapping("FLOAT", "MERGE_FLOAT_BIG_ENDIAN");
+    const auto& codec = MappingCodec::forMapping(*mapping);
+    const auto registers = std::vector<std::uint16_t>{0x4148, 0x0000};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(codec.decodeReading(mapping->getReference(), registers));
+}
+
+void decodeInt32ReadingWithSwitch(benchmark::State& state)
+{
+    const auto mapping = makeMapping("INT32", "MERGE_LITTLE_ENDIAN");
+    const auto registers = std::vector<std::uint16_t>{0xFFFE, 0xFFFF};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(switchDecodeReading(*mapping, registers));
+}
+
+void decodeInt32ReadingWithCodec(benchmark::State& state)
+{
+    const auto mapping = makeMapping("INT32", "MERGE_LITTLE_ENDIAN");
+    const auto& codec = MappingCodec::forMapping(*mapping);
+    const auto registers = std::vector<std::uint16_t>{0xFFFE, 0xFFFF};
+    for (auto _ : state)
+        benchmark::DoNotOptimize(codec.decodeReading(mapping->getReference(), registers));
+}
+
+void encodeFloatWithSwitch(benchmark::State& state)
+{
+    const auto mapping = makeMapping("FLOAT", "MERGE_FLOAT_BIG_ENDIAN");
+    for (auto _ : state)
+        benchmark::DoNotOptimize(switchEncode(*mapping, "12.5"));
+}
+
+void encodeFloatWithCodec(benchmark::State& state)
+{
+    const auto mapping = makeMapping("FLOAT", "MERGE_FLOAT_BIG_ENDIAN");
+    const auto& codec = MappingCodec::forMapping(*mapping);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(codec.encode("12.5"));
+}
+}    // namespace
+
+BENCHMARK(decodeFloatReadingWithSwitch);
+BENCHMARK(decodeFloatReadingWithCodec);
+BENCHMARK(decodeInt32ReadingWithSwitch);
+BENCHMARK(decodeInt32ReadingWithCodec);
+BENCHMARK(encodeFloatWithSwitch);
+BENCHMARK(encodeFloatWithCodec);
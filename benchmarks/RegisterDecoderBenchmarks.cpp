@@ -0,0 +1,98 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/utilities/RegisterDecoder.h"
+#include "more_modbus/utilities/DataParsers.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace wolkabout;
+using Endian = more_modbus::DataParsers::Endian;
+
+namespace
+{
+// A single read request carries at most 125 registers, which is 62 values of 32 bits
+const std::size_t VALUE_COUNT = 62;
+
+std::vector<std::uint16_t> makeRegisters()
+{
+    auto registers = std::vector<std::uint16_t>(2 * VALUE_COUNT);
+    for (auto i = std::size_t{0}; i < registers.size(); ++i)
+        registers[i] = static_cast<std::uint16_t>(i * 7919);
+    return registers;
+}
+
+// The values decoded one at a time, the way they were decoded before the decoder
+void decodeFloatsWithDataParsers(benchmark::State& state)
+{
+    const auto registers = makeRegisters();
+    auto values = std::vector<double>(VALUE_COUNT);
+    for (auto _ : state)
+    {
+        for (auto i = std::size_t{0}; i < VALUE_COUNT; ++i)
+            values[i] = more_modbus::DataParsers::registersToFloat({registers[2 * i], registers[2 * i + 1]},
+                                                                   Endian::BIG);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * VALUE_COUNT));
+}
+
+void decodeFloatsWithRegisterDecoder(benchmark::State& state)
+{
+    const auto registers = makeRegisters();
+    auto values = std::vector<double>(VALUE_COUNT);
+    for (auto _ : state)
+    {
+        RegisterDecoder::decodeFloat(registers.data(), VALUE_COUNT, true, values.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * VALUE_COUNT));
+}
+
+void decodeInt32sWithDataParsers(benchmark::State& state)
+{
+    const auto registers = makeRegisters();
+    auto values = std::vector<double>(VALUE_COUNT);
+    for (auto _ : state)
+    {
+        for (auto i = std::size_t{0}; i < VALUE_COUNT; ++i)
+            values[i] = more_modbus::DataParsers::registersToInt32({registers[2 * i], registers[2 * i + 1]},
+                                                                   Endian::LITTLE);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * VALUE_COUNT));
+}
+
+void decodeInt32sWithRegisterDecoder(benchmark::State& state)
+{
+    const auto registers = makeRegisters();
+    auto values = std::vector<double>(VALUE_COUNT);
+    for (auto _ : state)
+    {
+        RegisterDecoder::decodeInt32(registers.data(), VALUE_COUNT, false, values.data());
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * VALUE_COUNT));
+}
+}    // namespace
+
+BENCHMARK(decodeFloatsWithDataParsers);
+BENCHMARK(decodeFloatsWithRegisterDecoder);
+BENCHMARK(decodeInt32sWithDataParsers);
+BENCHMARK(decodeInt32sWithRegisterDecoder);
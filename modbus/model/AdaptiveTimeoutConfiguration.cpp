@@ -0,0 +1,81 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/model/AdaptiveTimeoutConfiguration.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+namespace modbus
+{
+AdaptiveTimeoutConfiguration::AdaptiveTimeoutConfiguration(nlohmann::json j,
+                                                           std::chrono::milliseconds defaultMaxTimeout)
+{
+    try
+    {
+        m_factor = j.at("factor").get<double>();
+    }
+    catch (std::exception&)
+    {
+        m_factor = 3.0;
+    }
+    if (m_factor < 1.0)
+        throw std::logic_error("Adaptive timeout factor can not be less than 1.");
+
+    try
+    {
+        m_minTimeout = std::chrono::milliseconds(j.at("minMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_minTimeout = std::chrono::milliseconds(20);
+    }
+
+    try
+    {
+        m_maxTimeout = std::chrono::milliseconds(j.at("maxMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_maxTimeout = defaultMaxTimeout;
+    }
+    m_maxTimeout = std::max(m_maxTimeout, m_minTimeout);
+}
+
+AdaptiveTimeoutConfiguration::AdaptiveTimeoutConfiguration(double factor, std::chrono::milliseconds minTimeout,
+                                                           std::chrono::milliseconds maxTimeout)
+: m_factor(factor), m_minTimeout(minTimeout), m_maxTimeout(maxTimeout)
+{
+}
+
+double AdaptiveTimeoutConfiguration::getFactor() const
+{
+    return m_factor;
+}
+
+const std::chrono::milliseconds& AdaptiveTimeoutConfiguration::getMinTimeout() const
+{
+    return m_minTimeout;
+}
+
+const std::chrono::milliseconds& AdaptiveTimeoutConfiguration::getMaxTimeout() const
+{
+    return m_maxTimeout;
+}
+}    // namespace modbus
+}    // namespace wolkabout
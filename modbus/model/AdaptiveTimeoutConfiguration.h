@@ -0,0 +1,63 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_ADAPTIVETIMEOUTCONFIGURATION_H
+#define WOLKGATEWAYMODBUSMODULE_ADAPTIVETIMEOUTCONFIGURATION_H
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+
+namespace wolkabout
+{
+namespace modbus
+{
+using nlohmann::json;
+
+/**
+ * @brief Model class representing the rules by which the response timeout of every device on a bus is derived from
+ *        the measured latency of the device - the 99th percentile multiplied by the factor, within the bounds.
+ */
+class AdaptiveTimeoutConfiguration
+{
+public:
+    /**
+     * Constructor that parses the configuration out of a json object.
+     *
+     * @param j The json object.
+     * @param defaultMaxTimeout The upper bound used if the json doesn't state its own.
+     */
+    AdaptiveTimeoutConfiguration(nlohmann::json j, std::chrono::milliseconds defaultMaxTimeout);
+
+    AdaptiveTimeoutConfiguration(double factor, std::chrono::milliseconds minTimeout,
+                                 std::chrono::milliseconds maxTimeout);
+
+    double getFactor() const;
+
+    const std::chrono::milliseconds& getMinTimeout() const;
+
+    const std::chrono::milliseconds& getMaxTimeout() const;
+
+private:
+    double m_factor;
+    std::chrono::milliseconds m_minTimeout;
+    std::chrono::milliseconds m_maxTimeout;
+};
+}    // namespace modbus
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_ADAPTIVETIMEOUTCONFIGURATION_H
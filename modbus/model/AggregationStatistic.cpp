@@ -0,0 +1,57 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/model/AggregationStatistic.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace wolkabout::modbus
+{
+AggregationStatistic aggregationStatisticFromString(std::string value)
+{
+    std::transform(value.cbegin(), value.cend(), value.begin(), ::toupper);
+    if (value == "MIN")
+        return AggregationStatistic::Minimum;
+    else if (value == "MAX")
+        return AggregationStatistic::Maximum;
+    else if (value == "AVG")
+        return AggregationStatistic::Average;
+    else if (value == "LAST")
+        return AggregationStatistic::Last;
+    else if (value == "COUNT")
+        return AggregationStatistic::Count;
+    throw std::runtime_error("Unknown aggregation statistic '" + value + "'.");
+}
+
+std::string toString(AggregationStatistic statistic)
+{
+    switch (statistic)
+    {
+    case AggregationStatistic::Minimum:
+        return "MIN";
+    case AggregationStatistic::Maximum:
+        return "MAX";
+    case AggregationStatistic::Average:
+        return "AVG";
+    case AggregationStatistic::Last:
+        return "LAST";
+    case AggregationStatistic::Count:
+        return "COUNT";
+    }
+    return {};
+}
+}    // namespace wolkabout::modbus
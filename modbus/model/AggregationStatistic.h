@@ -0,0 +1,51 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_AGGREGATIONSTATISTIC_H
+#define WOLKGATEWAYMODBUSMODULE_AGGREGATIONSTATISTIC_H
+
+#include <string>
+
+namespace wolkabout::modbus
+{
+// This is the enumeration that describes a statistic sent out for every window of an aggregated mapping.
+enum class AggregationStatistic
+{
+    Minimum,
+    Maximum,
+    Average,
+    Last,
+    Count
+};
+
+/**
+ * Helper method used to convert a string value into the enumeration value for an AggregationStatistic.
+ *
+ * @param value The string value.
+ * @return The parsed AggregationStatistic value. Throws if the value is not a statistic.
+ */
+AggregationStatistic aggregationStatisticFromString(std::string value);
+
+/**
+ * Helper method used to convert an AggregationStatistic into the prefix of the reference of its feed.
+ *
+ * @param statistic The AggregationStatistic value.
+ * @return The prefix, such as "AVG".
+ */
+std::string toString(AggregationStatistic statistic);
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_AGGREGATIONSTATISTIC_H
@@ -0,0 +1,139 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/model/BusConfiguration.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+namespace modbus
+{
+using nlohmann::json;
+
+BusConfiguration::BusConfiguration(std::string name, std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration,
+                                   std::chrono::milliseconds responseTimeout)
+: m_name(std::move(name))
+, m_connectionType(ConnectionType::SERIAL_RTU)
+, m_serialRtuConfiguration(std::move(serialRtuConfiguration))
+, m_tcpIpConfiguration(nullptr)
+, m_responseTimeout(responseTimeout)
+, m_nonBlocking(false)
+{
+}
+
+BusConfiguration::BusConfiguration(std::string name, std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
+                                   std::chrono::milliseconds responseTimeout, bool nonBlocking)
+: m_name(std::move(name))
+, m_connectionType(ConnectionType::TCP_IP)
+, m_serialRtuConfiguration(nullptr)
+, m_tcpIpConfiguration(std::move(tcpIpConfiguration))
+, m_responseTimeout(responseTimeout)
+, m_nonBlocking(nonBlocking)
+{
+}
+
+BusConfiguration::BusConfiguration(nlohmann::json j, std::chrono::milliseconds defaultResponseTimeout)
+: m_nonBlocking(false)
+{
+    try
+    {
+        m_name = j.at("name").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        throw std::logic_error("Missing bus configuration field : name");
+    }
+
+    std::string connectionTypeStr;
+    try
+    {
+        connectionTypeStr = j.at("connectionType").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        throw std::logic_error("Missing bus configuration field : connectionType");
+    }
+
+    if (connectionTypeStr == "TCP/IP")
+    {
+        m_tcpIpConfiguration = std::unique_ptr<TcpIpConfiguration>(new TcpIpConfiguration(j["tcp/ip"]));
+        m_connectionType = ConnectionType::TCP_IP;
+    }
+    else if (connectionTypeStr == "SERIAL/RTU")
+    {
+        m_serialRtuConfiguration = std::unique_ptr<SerialRtuConfiguration>(new SerialRtuConfiguration(j["serial/rtu"]));
+        m_connectionType = ConnectionType::SERIAL_RTU;
+    }
+    else
+    {
+        throw std::logic_error("Unknown modbus connection type : " + connectionTypeStr);
+    }
+
+    try
+    {
+        m_responseTimeout = std::chrono::milliseconds(j.at("responseTimeoutMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_responseTimeout = defaultResponseTimeout;
+    }
+
+    // Only a TCP/IP bus can be driven by the event loop
+    if (m_connectionType == ConnectionType::TCP_IP && j.contains("nonBlocking"))
+        m_nonBlocking = j["nonBlocking"].get<bool>();
+
+    if (j.contains("adaptiveTimeout"))
+        m_adaptiveTimeoutConfiguration = std::unique_ptr<AdaptiveTimeoutConfiguration>(
+          new AdaptiveTimeoutConfiguration(j["adaptiveTimeout"], m_responseTimeout));
+}
+
+const std::string& BusConfiguration::getName() const
+{
+    return m_name;
+}
+
+BusConfiguration::ConnectionType BusConfiguration::getConnectionType() const
+{
+    return m_connectionType;
+}
+
+const std::unique_ptr<SerialRtuConfiguration>& BusConfiguration::getSerialRtuConfiguration() const
+{
+    return m_serialRtuConfiguration;
+}
+
+const std::unique_ptr<TcpIpConfiguration>& BusConfiguration::getTcpIpConfiguration() const
+{
+    return m_tcpIpConfiguration;
+}
+
+const std::chrono::milliseconds& BusConfiguration::getResponseTimeout() const
+{
+    return m_responseTimeout;
+}
+
+bool BusConfiguration::isNonBlocking() const
+{
+    return m_nonBlocking;
+}
+
+const std::unique_ptr<AdaptiveTimeoutConfiguration>& BusConfiguration::getAdaptiveTimeoutConfiguration() const
+{
+    return m_adaptiveTimeoutConfiguration;
+}
+}    // namespace modbus
+}    // namespace wolkabout
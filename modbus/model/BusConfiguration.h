@@ -0,0 +1,105 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_BUSCONFIGURATION_H
+#define WOLKGATEWAYMODBUSMODULE_BUSCONFIGURATION_H
+
+#include <nlohmann/json.hpp>
+#include "modbus/model/AdaptiveTimeoutConfiguration.h"
+#include "modbus/model/SerialRtuConfiguration.h"
+#include "modbus/model/TcpIpConfiguration.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace wolkabout
+{
+namespace modbus
+{
+using nlohmann::json;
+
+/**
+ * @brief Model class representing a single Modbus bus - a serial port or a TCP/IP endpoint, with the devices on it
+ *        being read through a single connection.
+ */
+class BusConfiguration
+{
+public:
+    enum class ConnectionType
+    {
+        TCP_IP,
+        SERIAL_RTU
+    };
+
+    BusConfiguration(std::string name, std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration,
+                     std::chrono::milliseconds responseTimeout);
+
+    BusConfiguration(std::string name, std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
+                     std::chrono::milliseconds responseTimeout, bool nonBlocking = false);
+
+    /**
+     * Constructor that parses the bus out of a json object.
+     *
+     * @param j The json object of the bus.
+     * @param defaultResponseTimeout The response timeout used if the bus doesn't state its own.
+     */
+    BusConfiguration(nlohmann::json j, std::chrono::milliseconds defaultResponseTimeout);
+
+    const std::string& getName() const;
+
+    ConnectionType getConnectionType() const;
+
+    const std::unique_ptr<SerialRtuConfiguration>& getSerialRtuConfiguration() const;
+
+    const std::unique_ptr<TcpIpConfiguration>& getTcpIpConfiguration() const;
+
+    const std::chrono::milliseconds& getResponseTimeout() const;
+
+    /**
+     * This is the method that returns whether the TCP/IP bus is driven by the shared non-blocking event loop,
+     * instead of a blocking client with its own thread.
+     *
+     * @return Whether the bus is non-blocking.
+     */
+    bool isNonBlocking() const;
+
+    /**
+     * This is the method that returns the rules by which the response timeout adapts to the latency of the devices.
+     * Only the non-blocking buses adapt the timeout.
+     *
+     * @return The adaptive timeout configuration, nullptr if the response timeout is always used.
+     */
+    const std::unique_ptr<AdaptiveTimeoutConfiguration>& getAdaptiveTimeoutConfiguration() const;
+
+private:
+    std::string m_name;
+
+    ConnectionType m_connectionType;
+
+    std::unique_ptr<SerialRtuConfiguration> m_serialRtuConfiguration;
+    std::unique_ptr<TcpIpConfiguration> m_tcpIpConfiguration;
+
+    std::chrono::milliseconds m_responseTimeout;
+
+    bool m_nonBlocking;
+
+    std::unique_ptr<AdaptiveTimeoutConfiguration> m_adaptiveTimeoutConfiguration;
+};
+}    // namespace modbus
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_BUSCONFIGURATION_H
@@ -16,6 +16,7 @@
 
 #include "modbus/model/DeviceInformation.h"
 
+#include <algorithm>
 #include <utility>
 
 namespace wolkabout
@@ -27,6 +28,8 @@ DeviceInformation::DeviceInformation(std::string name, std::string key, const De
 : m_name(std::move(name))
 , m_key(std::move(key))
 , m_slaveAddress(slaveAddress)
+, m_bus()
+, m_maxInFlight(1)
 , m_templateString()
 , m_template(deviceTemplate)
 {
@@ -75,6 +78,26 @@ DeviceInformation::DeviceInformation(nlohmann::json j, const DeviceTemplate& dev
     {
         m_slaveAddress = static_cast<std::uint16_t>(0);
     }
+
+    // The bus is optional if the module has only one bus
+    try
+    {
+        m_bus = j.at("bus").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        m_bus = std::string{};
+    }
+
+    // Pipelining is opt-in, as not every device accepts more than one request at a time
+    try
+    {
+        m_maxInFlight = std::max(j.at("maxInFlight").get<std::uint16_t>(), static_cast<std::uint16_t>(1));
+    }
+    catch (std::exception&)
+    {
+        m_maxInFlight = static_cast<std::uint16_t>(1);
+    }
 }
 
 const std::string& DeviceInformation::getName() const
@@ -97,6 +120,21 @@ void DeviceInformation::setSlaveAddress(std::uint16_t slaveAddress)
     m_slaveAddress = slaveAddress;
 }
 
+const std::string& DeviceInformation::getBus() const
+{
+    return m_bus;
+}
+
+void DeviceInformation::setBus(const std::string& bus)
+{
+    m_bus = bus;
+}
+
+std::uint16_t DeviceInformation::getMaxInFlight() const
+{
+    return m_maxInFlight;
+}
+
 const std::string& DeviceInformation::getTemplateString() const
 {
     return m_templateString;
@@ -47,6 +47,12 @@ public:
 
     void setSlaveAddress(std::uint16_t slaveAddress);
 
+    const std::string& getBus() const;
+
+    void setBus(const std::string& bus);
+
+    std::uint16_t getMaxInFlight() const;
+
     const std::string& getTemplateString() const;
 
     const DeviceTemplate& getTemplate() const;
@@ -55,6 +61,8 @@ private:
     std::string m_name;
     std::string m_key;
     std::uint16_t m_slaveAddress;
+    std::string m_bus;
+    std::uint16_t m_maxInFlight;
     std::string m_templateString;
     const DeviceTemplate& m_template;
 };
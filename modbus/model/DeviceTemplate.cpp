@@ -24,17 +24,18 @@ namespace modbus
 {
 using nlohmann::json;
 
-DeviceTemplate::DeviceTemplate(std::string name, std::vector<ModuleMapping> mappings)
-: m_name(std::move(name)), m_mappings(std::move(mappings))
+DeviceTemplate::DeviceTemplate(std::string name, std::vector<ModuleMapping> mappings,
+                               std::chrono::milliseconds pollPeriod)
+: m_name(std::move(name)), m_mappings(std::move(mappings)), m_pollPeriod(pollPeriod)
 {
 }
 
 DeviceTemplate::DeviceTemplate(const DeviceTemplate& instance)
-: m_name(instance.getName()), m_mappings(instance.getMappings())
+: m_name(instance.getName()), m_mappings(instance.getMappings()), m_pollPeriod(instance.getPollPeriod())
 {
 }
 
-DeviceTemplate::DeviceTemplate(nlohmann::json j)
+DeviceTemplate::DeviceTemplate(nlohmann::json j) : m_pollPeriod(0)
 {
     try
     {
@@ -45,6 +46,15 @@ DeviceTemplate::DeviceTemplate(nlohmann::json j)
         throw std::logic_error("Missing device template field - name");
     }
 
+    try
+    {
+        m_pollPeriod = std::chrono::milliseconds(j.at("pollPeriodMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_pollPeriod = std::chrono::milliseconds(0);
+    }
+
     for (json::object_t mapping : j["mappings"].get<json::array_t>())
     {
         m_mappings.emplace_back(ModuleMapping(mapping));
@@ -65,5 +75,10 @@ const std::vector<ModuleMapping>& DeviceTemplate::getMappings() const
 {
     return m_mappings;
 }
+
+std::chrono::milliseconds DeviceTemplate::getPollPeriod() const
+{
+    return m_pollPeriod;
+}
 }    // namespace modbus
 }    // namespace wolkabout
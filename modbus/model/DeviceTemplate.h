@@ -32,7 +32,8 @@ using nlohmann::json;
 class DeviceTemplate
 {
 public:
-    DeviceTemplate(std::string name, std::vector<ModuleMapping> mappings);
+    DeviceTemplate(std::string name, std::vector<ModuleMapping> mappings,
+                   std::chrono::milliseconds pollPeriod = std::chrono::milliseconds{0});
 
     DeviceTemplate(const DeviceTemplate& instance);
 
@@ -42,9 +43,14 @@ public:
 
     const std::vector<ModuleMapping>& getMappings() const;
 
+    std::chrono::milliseconds getPollPeriod() const;
+
 private:
     std::string m_name;
     std::vector<ModuleMapping> m_mappings;
+
+    // Polling period for mappings that don't state their own, zero means the module period is used
+    std::chrono::milliseconds m_pollPeriod;
 };
 }    // namespace modbus
 }    // namespace wolkabout
@@ -19,39 +19,66 @@
 #include "core/utilities/FileSystemUtils.h"
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+
 namespace wolkabout
 {
 namespace modbus
 {
 using nlohmann::json;
 
-ModuleConfiguration::ModuleConfiguration(std::string mqttHost, ConnectionType connectionType,
+const std::string ModuleConfiguration::DEFAULT_BUS_NAME = "default";
+
+ModuleConfiguration::ModuleConfiguration(std::string mqttHost,
                                          std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration,
                                          std::chrono::milliseconds responseTimeout,
                                          std::chrono::milliseconds registerReadPeriod)
 : m_mqttHost(std::move(mqttHost))
-, m_connectionType(connectionType)
-, m_serialRtuConfiguration(std::move(serialRtuConfiguration))
-, m_tcpIpConfiguration(nullptr)
 , m_responseTimeout(responseTimeout)
 , m_registerReadPeriod(registerReadPeriod)
+, m_readGapTolerance(0)
+, m_failuresBeforeQuarantine(3)
+, m_probeInterval(1000)
+, m_maxProbeInterval(60000)
+, m_readAfterWriteWindow(50)
+, m_publishValueCount(100)
+, m_publishLatency(1000)
+, m_outboundBufferLimit(16 * 1024 * 1024)
 {
+    m_buses.emplace(DEFAULT_BUS_NAME,
+                    std::unique_ptr<BusConfiguration>(
+                      new BusConfiguration(DEFAULT_BUS_NAME, std::move(serialRtuConfiguration), responseTimeout)));
 }
 
-ModuleConfiguration::ModuleConfiguration(std::string mqttHost, ConnectionType connectionType,
-                                         std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
+ModuleConfiguration::ModuleConfiguration(std::string mqttHost, std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
                                          std::chrono::milliseconds responseTimeout,
                                          std::chrono::milliseconds registerReadPeriod)
 : m_mqttHost(std::move(mqttHost))
-, m_connectionType(connectionType)
-, m_serialRtuConfiguration(nullptr)
-, m_tcpIpConfiguration(std::move(tcpIpConfiguration))
 , m_responseTimeout(responseTimeout)
 , m_registerReadPeriod(registerReadPeriod)
+, m_readGapTolerance(0)
+, m_failuresBeforeQuarantine(3)
+, m_probeInterval(1000)
+, m_maxProbeInterval(60000)
+, m_readAfterWriteWindow(50)
+, m_publishValueCount(100)
+, m_publishLatency(1000)
+, m_outboundBufferLimit(16 * 1024 * 1024)
 {
+    m_buses.emplace(DEFAULT_BUS_NAME,
+                    std::unique_ptr<BusConfiguration>(
+                      new BusConfiguration(DEFAULT_BUS_NAME, std::move(tcpIpConfiguration), responseTimeout)));
 }
 
 ModuleConfiguration::ModuleConfiguration(nlohmann::json j)
+: m_readGapTolerance(0)
+, m_failuresBeforeQuarantine(3)
+, m_probeInterval(1000)
+, m_maxProbeInterval(60000)
+, m_readAfterWriteWindow(50)
+, m_publishValueCount(100)
+, m_publishLatency(1000)
+, m_outboundBufferLimit(16 * 1024 * 1024)
 {
     try
     {
@@ -62,51 +89,129 @@ ModuleConfiguration::ModuleConfiguration(nlohmann::json j)
         m_mqttHost = "tcp://localhost:1883";
     }
 
-    std::string connectionTypeStr;
     try
     {
-        connectionTypeStr = j.at("connectionType").get<std::string>();
+        m_responseTimeout = std::chrono::milliseconds(j.at("responseTimeoutMs").get<long long>());
     }
     catch (std::exception&)
     {
-        throw std::logic_error("Missing configuration field : connectionType");
+        m_responseTimeout = std::chrono::milliseconds(200);
     }
 
-    [&]() {
-        if (connectionTypeStr == "TCP/IP")
-        {
-            m_tcpIpConfiguration = std::unique_ptr<TcpIpConfiguration>(new TcpIpConfiguration(j["tcp/ip"]));
-            m_connectionType = ConnectionType::TCP_IP;
-        }
-        else if (connectionTypeStr == "SERIAL/RTU")
-        {
-            m_serialRtuConfiguration =
-              std::unique_ptr<SerialRtuConfiguration>(new SerialRtuConfiguration(j["serial/rtu"]));
-            m_connectionType = ConnectionType::SERIAL_RTU;
-        }
-        else
+    // The buses can be listed, or a single connection can be stated directly in the configuration
+    if (j.find("buses") != j.end())
+    {
+        for (json::object_t busJson : j["buses"].get<json::array_t>())
         {
-            throw std::logic_error("Unknown modbus connection type : " + connectionTypeStr);
+            auto bus = std::unique_ptr<BusConfiguration>(new BusConfiguration(busJson, m_responseTimeout));
+            const auto name = bus->getName();
+            if (!m_buses.emplace(name, std::move(bus)).second)
+                throw std::logic_error("Duplicate bus name : " + name);
         }
-    }();
+        if (m_buses.empty())
+            throw std::logic_error("The configuration field `buses` does not contain any buses.");
+    }
+    else
+    {
+        auto busJson = j;
+        busJson["name"] = DEFAULT_BUS_NAME;
+        m_buses.emplace(DEFAULT_BUS_NAME,
+                        std::unique_ptr<BusConfiguration>(new BusConfiguration(busJson, m_responseTimeout)));
+    }
 
     try
     {
-        m_responseTimeout = std::chrono::milliseconds(j.at("responseTimeoutMs").get<long long>());
+        m_registerReadPeriod = std::chrono::milliseconds(j.at("registerReadPeriodMs").get<long long>());
     }
     catch (std::exception&)
     {
-        m_responseTimeout = std::chrono::milliseconds(200);
+        m_registerReadPeriod = std::chrono::milliseconds(500);
     }
 
     try
     {
-        m_registerReadPeriod = std::chrono::milliseconds(j.at("registerReadPeriodMs").get<long long>());
+        m_readGapTolerance = j.at("readGapTolerance").get<std::uint16_t>();
     }
     catch (std::exception&)
     {
-        m_registerReadPeriod = std::chrono::milliseconds(500);
+        m_readGapTolerance = 0;
+    }
+
+    try
+    {
+        m_failuresBeforeQuarantine = j.at("failuresBeforeQuarantine").get<std::uint16_t>();
+    }
+    catch (std::exception&)
+    {
+        m_failuresBeforeQuarantine = 3;
+    }
+
+    try
+    {
+        m_probeInterval = std::chrono::milliseconds(j.at("probeIntervalMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_probeInterval = std::chrono::milliseconds(1000);
+    }
+
+    try
+    {
+        m_maxProbeInterval = std::chrono::milliseconds(j.at("maxProbeIntervalMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_maxProbeInterval = std::chrono::milliseconds(60000);
+    }
+    if (m_probeInterval.count() <= 0)
+        m_probeInterval = std::chrono::milliseconds(1000);
+    m_maxProbeInterval = std::max(m_maxProbeInterval, m_probeInterval);
+
+    try
+    {
+        m_readAfterWriteWindow = std::chrono::milliseconds(j.at("readAfterWriteWindowMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_readAfterWriteWindow = std::chrono::milliseconds(50);
     }
+    if (m_readAfterWriteWindow.count() < 0)
+        m_readAfterWriteWindow = std::chrono::milliseconds(0);
+
+    try
+    {
+        m_publishValueCount = j.at("publishValueCount").get<std::uint16_t>();
+    }
+    catch (std::exception&)
+    {
+        m_publishValueCount = 100;
+    }
+    if (m_publishValueCount == 0)
+        m_publishValueCount = 1;
+
+    try
+    {
+        m_publishLatency = std::chrono::milliseconds(j.at("publishLatencyMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_publishLatency = std::chrono::milliseconds(1000);
+    }
+    if (m_publishLatency.count() < 0)
+        m_publishLatency = std::chrono::milliseconds(0);
+
+    try
+    {
+        m_outboundBufferLimit = j.at("outboundBufferLimitKb").get<std::size_t>() * 1024;
+    }
+    catch (std::exception&)
+    {
+        m_outboundBufferLimit = 16 * 1024 * 1024;
+    }
+
+    if (j.contains("storeAndForward"))
+        m_storeAndForwardConfiguration = std::unique_ptr<StoreAndForwardConfiguration>(
+          new StoreAndForwardConfiguration(j["storeAndForward"]));
 }
 
 const std::string& ModuleConfiguration::getMqttHost() const
@@ -114,39 +219,64 @@ const std::string& ModuleConfiguration::getMqttHost() const
     return m_mqttHost;
 }
 
-ModuleConfiguration::ConnectionType ModuleConfiguration::getConnectionType() const
+const std::map<std::string, std::unique_ptr<BusConfiguration>>& ModuleConfiguration::getBuses() const
 {
-    return m_connectionType;
+    return m_buses;
 }
 
-const std::unique_ptr<SerialRtuConfiguration>& ModuleConfiguration::getSerialRtuConfiguration() const
+const std::chrono::milliseconds& ModuleConfiguration::getResponseTimeout() const
 {
-    return m_serialRtuConfiguration;
+    return m_responseTimeout;
 }
 
-const std::unique_ptr<TcpIpConfiguration>& ModuleConfiguration::getTcpIpConfiguration() const
+const std::chrono::milliseconds& ModuleConfiguration::getRegisterReadPeriod() const
 {
-    return m_tcpIpConfiguration;
+    return m_registerReadPeriod;
 }
 
-const std::chrono::milliseconds& ModuleConfiguration::getResponseTimeout() const
+std::uint16_t ModuleConfiguration::getReadGapTolerance() const
 {
-    return m_responseTimeout;
+    return m_readGapTolerance;
 }
 
-const std::chrono::milliseconds& ModuleConfiguration::getRegisterReadPeriod() const
+std::uint16_t ModuleConfiguration::getFailuresBeforeQuarantine() const
 {
-    return m_registerReadPeriod;
+    return m_failuresBeforeQuarantine;
+}
+
+const std::chrono::milliseconds& ModuleConfiguration::getProbeInterval() const
+{
+    return m_probeInterval;
+}
+
+const std::chrono::milliseconds& ModuleConfiguration::getMaxProbeInterval() const
+{
+    return m_maxProbeInterval;
+}
+
+const std::chrono::milliseconds& ModuleConfiguration::getReadAfterWriteWindow() const
+{
+    return m_readAfterWriteWindow;
+}
+
+std::uint16_t ModuleConfiguration::getPublishValueCount() const
+{
+    return m_publishValueCount;
+}
+
+const std::chrono::milliseconds& ModuleConfiguration::getPublishLatency() const
+{
+    return m_publishLatency;
 }
 
-void ModuleConfiguration::setSerialRtuConfiguration(std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration)
+std::size_t ModuleConfiguration::getOutboundBufferLimit() const
 {
-    m_serialRtuConfiguration = std::move(serialRtuConfiguration);
+    return m_outboundBufferLimit;
 }
 
-void ModuleConfiguration::setTcpIpConfiguration(std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration)
+const std::unique_ptr<StoreAndForwardConfiguration>& ModuleConfiguration::getStoreAndForwardConfiguration() const
 {
-    m_tcpIpConfiguration = std::move(tcpIpConfiguration);
+    return m_storeAndForwardConfiguration;
 }
 }    // namespace modbus
 }    // namespace wolkabout
@@ -18,10 +18,14 @@
 #define MODULECONFIGURATION_H
 
 #include <nlohmann/json.hpp>
+#include "modbus/model/BusConfiguration.h"
 #include "modbus/model/SerialRtuConfiguration.h"
+#include "modbus/model/StoreAndForwardConfiguration.h"
 #include "modbus/model/TcpIpConfiguration.h"
 
 #include <chrono>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -33,54 +37,79 @@ using nlohmann::json;
 
 /**
  * @brief Model class containing information for assembling the moduleConfiguration.json file,
- *        one that sets up the module with the modbus connection, and connection to the MQTT
+ *        one that sets up the module with the modbus connections, and connection to the MQTT
  *        broker, and some other miscellaneous things.
  */
 class ModuleConfiguration
 {
 public:
-    enum class ConnectionType
-    {
-        TCP_IP,
-        SERIAL_RTU
-    };
-
-    ModuleConfiguration(std::string mqttHost, ConnectionType connectionType,
-                        std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration,
+    using ConnectionType = BusConfiguration::ConnectionType;
+
+    // The name of the bus created out of the connection stated directly in the configuration
+    static const std::string DEFAULT_BUS_NAME;
+
+    ModuleConfiguration(std::string mqttHost, std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration,
                         std::chrono::milliseconds responseTimeout, std::chrono::milliseconds registerReadPeriod);
 
-    ModuleConfiguration(std::string mqttHost, ConnectionType connectionType,
-                        std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
+    ModuleConfiguration(std::string mqttHost, std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration,
                         std::chrono::milliseconds responseTimeout, std::chrono::milliseconds registerReadPeriod);
 
     explicit ModuleConfiguration(nlohmann::json j);
 
     const std::string& getMqttHost() const;
 
-    ModuleConfiguration::ConnectionType getConnectionType() const;
-
-    const std::unique_ptr<SerialRtuConfiguration>& getSerialRtuConfiguration() const;
-
-    const std::unique_ptr<TcpIpConfiguration>& getTcpIpConfiguration() const;
+    const std::map<std::string, std::unique_ptr<BusConfiguration>>& getBuses() const;
 
     const std::chrono::milliseconds& getResponseTimeout() const;
 
     const std::chrono::milliseconds& getRegisterReadPeriod() const;
 
-    void setSerialRtuConfiguration(std::unique_ptr<SerialRtuConfiguration> serialRtuConfiguration);
+    std::uint16_t getReadGapTolerance() const;
+
+    std::uint16_t getFailuresBeforeQuarantine() const;
+
+    const std::chrono::milliseconds& getProbeInterval() const;
+
+    const std::chrono::milliseconds& getMaxProbeInterval() const;
+
+    const std::chrono::milliseconds& getReadAfterWriteWindow() const;
+
+    std::uint16_t getPublishValueCount() const;
 
-    void setTcpIpConfiguration(std::unique_ptr<TcpIpConfiguration> tcpIpConfiguration);
+    const std::chrono::milliseconds& getPublishLatency() const;
+
+    std::size_t getOutboundBufferLimit() const;
+
+    const std::unique_ptr<StoreAndForwardConfiguration>& getStoreAndForwardConfiguration() const;
 
 private:
     std::string m_mqttHost;
 
-    ConnectionType m_connectionType;
-
-    std::unique_ptr<SerialRtuConfiguration> m_serialRtuConfiguration;
-    std::unique_ptr<TcpIpConfiguration> m_tcpIpConfiguration;
+    std::map<std::string, std::unique_ptr<BusConfiguration>> m_buses;
 
     std::chrono::milliseconds m_responseTimeout;
     std::chrono::milliseconds m_registerReadPeriod;
+
+    // Count of unused registers that are read to merge two mappings into one request
+    std::uint16_t m_readGapTolerance;
+
+    // Consecutive failed reads after which a device is only probed, and the bounds of the probe interval
+    std::uint16_t m_failuresBeforeQuarantine;
+    std::chrono::milliseconds m_probeInterval;
+    std::chrono::milliseconds m_maxProbeInterval;
+
+    // Time in which the reads after writes into a device are collected, to be read together
+    std::chrono::milliseconds m_readAfterWriteWindow;
+
+    // Count of pending values, and the time the oldest of them can wait, after which the values are published
+    std::uint16_t m_publishValueCount;
+    std::chrono::milliseconds m_publishLatency;
+
+    // Bytes the values waiting to be published can take up before they are compacted
+    std::size_t m_outboundBufferLimit;
+
+    // The file keeping the readings while the platform can't be reached, nullptr if they're only kept in memory
+    std::unique_ptr<StoreAndForwardConfiguration> m_storeAndForwardConfiguration;
 };
 }    // namespace modbus
 }    // namespace wolkabout
@@ -19,6 +19,7 @@
 #include "core/utilities/Logger.h"
 #include "modbus/utilities/JsonReaderParser.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 
@@ -42,12 +43,15 @@ ModuleMapping::ModuleMapping(nlohmann::json j)
 , m_addressCount{JsonReaderParser::readOrDefault<std::uint16_t>(j, "addressCount", static_cast<std::uint16_t>(-1))}
 , m_deadbandValue{JsonReaderParser::readOrDefault(j, "deadbandValue", 0.0)}
 , m_frequencyFilterValue{JsonReaderParser::readOrDefault(j, "frequencyFilterValue", 0)}
+, m_pollPeriod{JsonReaderParser::readOrDefault(j, "pollPeriodMs", 0)}
 , m_repeat{JsonReaderParser::readOrDefault(j, "repeat", 0)}
 , m_defaultValue{JsonReaderParser::readTypedValue(j, "defaultValue")}
 , m_safeMode{j.find("safeMode") != j.end()}
 , m_safeModeValue{JsonReaderParser::readTypedValue(j, "safeMode")}
 , m_autoLocalUpdate{JsonReaderParser::readOrDefault(j, "autoLocalUpdate", false)}
 , m_autoReadAfterWrite{JsonReaderParser::readOrDefault(j, "autoReadAfterWrite", true)}
+, m_lossless{JsonReaderParser::readOrDefault(j, "lossless", false)}
+, m_aggregationWindow{0}
 {
     // Now attempt to read the repeat and default value
     if (m_repeat.count() > 0 && j.find("defaultValue") == j.end())
@@ -57,6 +61,26 @@ ModuleMapping::ModuleMapping(nlohmann::json j)
     if (m_safeMode && (m_registerType == more_modbus::RegisterType::INPUT_REGISTER ||
                        m_registerType == more_modbus::RegisterType::INPUT_CONTACT))
         throw std::runtime_error("You can not create a `safeMode` mapping with a read-only register.");
+
+    // Read the window and the statistics of an aggregated mapping
+    if (j.find("aggregation") != j.end())
+    {
+        const auto aggregation = JsonReaderParser::read<json::object_t>(j, "aggregation");
+        m_aggregationWindow = std::chrono::milliseconds(JsonReaderParser::read<std::uint32_t>(aggregation, "windowMs"));
+        for (const auto& statistic : JsonReaderParser::read<std::vector<std::string>>(aggregation, "statistics"))
+        {
+            const auto parsed = aggregationStatisticFromString(statistic);
+            if (std::find(m_aggregationStatistics.cbegin(), m_aggregationStatistics.cend(), parsed) ==
+                m_aggregationStatistics.cend())
+                m_aggregationStatistics.emplace_back(parsed);
+        }
+
+        if (m_aggregationWindow.count() == 0 || m_aggregationStatistics.empty())
+            throw std::runtime_error("You can not create an `aggregation` without a `windowMs` and `statistics`.");
+        if (m_mappingType == MappingType::Attribute || m_dataType == more_modbus::OutputType::BOOL ||
+            m_dataType == more_modbus::OutputType::STRING)
+            throw std::runtime_error("You can only create an `aggregation` for a numeric feed mapping.");
+    }
 }
 
 const std::string& ModuleMapping::getName() const
@@ -94,6 +118,11 @@ std::chrono::milliseconds ModuleMapping::getFrequencyFilterValue() const
     return m_frequencyFilterValue;
 }
 
+std::chrono::milliseconds ModuleMapping::getPollPeriod() const
+{
+    return m_pollPeriod;
+}
+
 int ModuleMapping::getAddress() const
 {
     return m_address;
@@ -106,8 +135,14 @@ int ModuleMapping::getBitIndex() const
 
 int ModuleMapping::getRegisterCount() const
 {
-    if (m_addressCount > 1)
+    // The `addressCount` is defaulted to -1 when it is not stated
+    if (m_addressCount > 1 && m_addressCount != static_cast<std::uint16_t>(-1))
         return m_addressCount;
+
+    // The merged values always take up two registers
+    if (m_dataType == more_modbus::OutputType::UINT32 || m_dataType == more_modbus::OutputType::INT32 ||
+        m_dataType == more_modbus::OutputType::FLOAT)
+        return 2;
     return 1;
 }
 
@@ -150,5 +185,25 @@ bool ModuleMapping::isAutoReadAfterWrite() const
 {
     return m_autoReadAfterWrite;
 }
+
+bool ModuleMapping::isLossless() const
+{
+    return m_lossless;
+}
+
+bool ModuleMapping::isAggregated() const
+{
+    return m_aggregationWindow.count() > 0;
+}
+
+std::chrono::milliseconds ModuleMapping::getAggregationWindow() const
+{
+    return m_aggregationWindow;
+}
+
+const std::vector<AggregationStatistic>& ModuleMapping::getAggregationStatistics() const
+{
+    return m_aggregationStatistics;
+}
 }    // namespace modbus
 }    // namespace wolkabout
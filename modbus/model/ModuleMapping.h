@@ -18,6 +18,7 @@
 #define MODBUSREGISTERMAPPING_H
 
 #include <nlohmann/json.hpp>
+#include "modbus/model/AggregationStatistic.h"
 #include "modbus/model/MappingType.h"
 #include "more_modbus/RegisterMapping.h"
 
@@ -54,6 +55,8 @@ public:
     double getDeadbandValue() const;
     std::chrono::milliseconds getFrequencyFilterValue() const;
 
+    std::chrono::milliseconds getPollPeriod() const;
+
     int getAddress() const;
     int getBitIndex() const;
     int getRegisterCount() const;
@@ -67,6 +70,12 @@ public:
 
     [[nodiscard]] bool isAutoReadAfterWrite() const;
 
+    [[nodiscard]] bool isLossless() const;
+
+    [[nodiscard]] bool isAggregated() const;
+    std::chrono::milliseconds getAggregationWindow() const;
+    const std::vector<AggregationStatistic>& getAggregationStatistics() const;
+
 private:
     // Identifying information
     std::string m_name;
@@ -87,6 +96,9 @@ private:
     double m_deadbandValue;
     std::chrono::milliseconds m_frequencyFilterValue;
 
+    // Polling information, zero means the period is inherited from the template/module
+    std::chrono::milliseconds m_pollPeriod;
+
     // Repeat write information
     std::chrono::milliseconds m_repeat;
     std::string m_defaultValue;
@@ -100,6 +112,13 @@ private:
 
     // Automatic Read after write
     bool m_autoReadAfterWrite;
+
+    // Whether every value is sent, even when only the newest ones can be kept while the platform is unreachable
+    bool m_lossless;
+
+    // Aggregation information, zero window means every value is sent out as it is
+    std::chrono::milliseconds m_aggregationWindow;
+    std::vector<AggregationStatistic> m_aggregationStatistics;
 };
 }    // namespace modbus
 }    // namespace wolkabout
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#ifndef SERIALRTUCONFIGURATION_H
+#define SERIALRTUCONFIGURATION_H
+
 #include <nlohmann/json.hpp>
 #include "more_modbus/modbus/LibModbusSerialRtuClient.h"
 
@@ -55,3 +58,5 @@ private:
 };
 }    // namespace modbus
 }    // namespace wolkabout
+
+#endif    // SERIALRTUCONFIGURATION_H
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/model/StoreAndForwardConfiguration.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+namespace modbus
+{
+StoreAndForwardConfiguration::StoreAndForwardConfiguration(nlohmann::json j)
+{
+    try
+    {
+        m_path = j.at("path").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        m_path = "./store-and-forward.bin";
+    }
+
+    try
+    {
+        m_size = j.at("sizeMb").get<std::uint64_t>() * 1024 * 1024;
+    }
+    catch (std::exception&)
+    {
+        m_size = 64 * 1024 * 1024;
+    }
+    if (m_size == 0)
+        throw std::logic_error("Store and forward file can not be empty.");
+
+    try
+    {
+        m_replayRate = j.at("replayRate").get<std::uint32_t>();
+    }
+    catch (std::exception&)
+    {
+        m_replayRate = 1000;
+    }
+    if (m_replayRate == 0)
+        throw std::logic_error("Store and forward replay rate can not be zero.");
+
+    try
+    {
+        m_commitInterval = std::chrono::milliseconds(j.at("commitIntervalMs").get<long long>());
+    }
+    catch (std::exception&)
+    {
+        m_commitInterval = std::chrono::milliseconds(5000);
+    }
+}
+
+StoreAndForwardConfiguration::StoreAndForwardConfiguration(std::string path, std::uint64_t size,
+                                                           std::uint32_t replayRate,
+                                                           std::chrono::milliseconds commitInterval)
+: m_path(std::move(path)), m_size(size), m_replayRate(replayRate), m_commitInterval(commitInterval)
+{
+}
+
+const std::string& StoreAndForwardConfiguration::getPath() const
+{
+    return m_path;
+}
+
+std::uint64_t StoreAndForwardConfiguration::getSize() const
+{
+    return m_size;
+}
+
+std::uint32_t StoreAndForwardConfiguration::getReplayRate() const
+{
+    return m_replayRate;
+}
+
+const std::chrono::milliseconds& StoreAndForwardConfiguration::getCommitInterval() const
+{
+    return m_commitInterval;
+}
+}    // namespace modbus
+}    // namespace wolkabout
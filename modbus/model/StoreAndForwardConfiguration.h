@@ -0,0 +1,70 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDCONFIGURATION_H
+#define WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDCONFIGURATION_H
+
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace wolkabout
+{
+namespace modbus
+{
+using nlohmann::json;
+
+/**
+ * @brief Model class representing the file in which the readings are stored while the platform can't be reached,
+ *        and the rate at which they are sent once it can be again.
+ */
+class StoreAndForwardConfiguration
+{
+public:
+    /**
+     * Constructor that parses the configuration out of a json object.
+     *
+     * @param j The json object.
+     */
+    explicit StoreAndForwardConfiguration(nlohmann::json j);
+
+    StoreAndForwardConfiguration(std::string path, std::uint64_t size, std::uint32_t replayRate,
+                                 std::chrono::milliseconds commitInterval);
+
+    const std::string& getPath() const;
+
+    std::uint64_t getSize() const;
+
+    std::uint32_t getReplayRate() const;
+
+    const std::chrono::milliseconds& getCommitInterval() const;
+
+private:
+    std::string m_path;
+    std::uint64_t m_size;
+
+    // Readings sent every second while replaying
+    std::uint32_t m_replayRate;
+
+    // Time between two writes of the stored readings to the storage, the readings after the last one can be lost
+    std::chrono::milliseconds m_commitInterval;
+};
+}    // namespace modbus
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDCONFIGURATION_H
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#ifndef TCPIPCONFIGURATION_H
+#define TCPIPCONFIGURATION_H
+
 #include <nlohmann/json.hpp>
 
 #include <string>
@@ -44,3 +47,5 @@ private:
 };
 }    // namespace modbus
 }    // namespace wolkabout
+
+#endif    // TCPIPCONFIGURATION_H
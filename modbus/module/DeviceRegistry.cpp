@@ -0,0 +1,82 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/DeviceRegistry.h"
+
+namespace wolkabout::modbus
+{
+std::optional<DeviceRegistry::DeviceId> DeviceRegistry::add(const std::string& key, const std::string& bus,
+                                                            const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                                            PollScheduler* pollScheduler)
+{
+    const auto busIt = m_busByName.emplace(bus, static_cast<std::uint32_t>(m_busByName.size())).first;
+    const auto address = addressKey(busIt->second, static_cast<std::uint16_t>(device->getSlaveAddress()));
+    if (m_idByKey.find(key) != m_idByKey.cend() || m_addresses.find(address) != m_addresses.cend())
+        return {};
+
+    const auto id = static_cast<DeviceId>(m_keys.size());
+    m_keys.emplace_back(key);
+    m_devices.emplace_back(device);
+    m_pollSchedulers.emplace_back(pollScheduler);
+
+    m_idByKey.emplace(key, id);
+    m_addresses.emplace(address);
+    m_idByDevice.emplace(device.get(), id);
+    return id;
+}
+
+std::optional<DeviceRegistry::DeviceId> DeviceRegistry::find(const std::string& key) const
+{
+    const auto it = m_idByKey.find(key);
+    if (it == m_idByKey.cend())
+        return {};
+    return it->second;
+}
+
+std::optional<DeviceRegistry::DeviceId> DeviceRegistry::find(const more_modbus::ModbusDevice& device) const
+{
+    const auto it = m_idByDevice.find(&device);
+    if (it == m_idByDevice.cend())
+        return {};
+    return it->second;
+}
+
+std::size_t DeviceRegistry::size() const
+{
+    return m_keys.size();
+}
+
+const std::string& DeviceRegistry::getKey(DeviceId id) const
+{
+    return m_keys[id];
+}
+
+const std::shared_ptr<more_modbus::ModbusDevice>& DeviceRegistry::getDevice(DeviceId id) const
+{
+    return m_devices[id];
+}
+
+PollScheduler* DeviceRegistry::getPollScheduler(DeviceId id) const
+{
+    return m_pollSchedulers[id];
+}
+
+std::uint32_t DeviceRegistry::addressKey(std::uint32_t bus, std::uint16_t slaveAddress)
+{
+    return (bus << 16) | slaveAddress;
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,111 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_DEVICEREGISTRY_H
+#define WOLKGATEWAYMODBUSMODULE_DEVICEREGISTRY_H
+
+#include "more_modbus/ModbusDevice.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+class PollScheduler;
+
+/**
+ * @brief Registry of all the devices of the bridge, indexed both by the device key, and by the Modbus device.
+ * @details Every device gets a dense identifier once it's added, and every lookup is a single hash lookup, so the
+ *          platform messages and the values reported by the devices are resolved in constant time. The devices are
+ *          added while the bridge is being initialized, and don't change afterwards.
+ */
+class DeviceRegistry
+{
+public:
+    using DeviceId = std::uint32_t;
+
+    /**
+     * This is the method that adds a device into the registry.
+     *
+     * @param key The key of the device.
+     * @param bus The name of the bus the device is on.
+     * @param device The Modbus device, holding the slave address.
+     * @param pollScheduler The scheduler reading the bus of the device.
+     * @return The identifier of the device, empty if the key or the slave address on the bus is already taken.
+     */
+    std::optional<DeviceId> add(const std::string& key, const std::string& bus,
+                                const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                PollScheduler* pollScheduler);
+
+    /**
+     * This is the method that finds a device by its key.
+     *
+     * @param key The key of the device.
+     * @return The identifier of the device, empty if the device is not known.
+     */
+    std::optional<DeviceId> find(const std::string& key) const;
+
+    /**
+     * This is the method that finds a device by its Modbus device.
+     *
+     * @param device The Modbus device.
+     * @return The identifier of the device, empty if the device is not known.
+     */
+    std::optional<DeviceId> find(const more_modbus::ModbusDevice& device) const;
+
+    /**
+     * This is the method that returns the count of the devices. The identifiers go from zero up to the count.
+     *
+     * @return The count of the devices.
+     */
+    std::size_t size() const;
+
+    const std::string& getKey(DeviceId id) const;
+
+    const std::shared_ptr<more_modbus::ModbusDevice>& getDevice(DeviceId id) const;
+
+    PollScheduler* getPollScheduler(DeviceId id) const;
+
+private:
+    /**
+     * This is a helper method that combines the bus and the slave address into a single key.
+     *
+     * @param bus The index of the bus.
+     * @param slaveAddress The slave address.
+     * @return The key.
+     */
+    static std::uint32_t addressKey(std::uint32_t bus, std::uint16_t slaveAddress);
+
+    // The columns, indexed by the identifier of the device
+    std::vector<std::string> m_keys;
+    std::vector<std::shared_ptr<more_modbus::ModbusDevice>> m_devices;
+    std::vector<PollScheduler*> m_pollSchedulers;
+
+    // The indexes of the buses, the taken slave addresses, and the indexes by which the devices are found
+    std::unordered_map<std::string, std::uint32_t> m_busByName;
+    std::unordered_set<std::uint32_t> m_addresses;
+    std::unordered_map<std::string, DeviceId> m_idByKey;
+    std::unordered_map<const more_modbus::ModbusDevice*, DeviceId> m_idByDevice;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_DEVICEREGISTRY_H
@@ -0,0 +1,150 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/MappingCodec.h"
+
+#include "more_modbus/utilities/DataParsers.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace wolkabout::modbus
+{
+namespace
+{
+using Endian = more_modbus::DataParsers::Endian;
+using OutputType = more_modbus::OutputType;
+
+// The codec of a single kind of mappings, where everything that depends on the kind is resolved while compiling
+template <OutputType Type, Endian Order, bool Unicode = false> class TypedCodec : public MappingCodec
+{
+public:
+    Reading decodeReading(const std::string& reference, const std::vector<std::uint16_t>& registers) const override
+    {
+        if constexpr (Type == OutputType::BOOL)
+            return {"", false};
+        else if constexpr (Type == OutputType::STRING)
+            return {reference, decodeString(registers)};
+        else
+            return {reference, decodeNumber(registers)};
+    }
+
+    Attribute decodeAttribute(const std::string& reference,
+                              const std::vector<std::uint16_t>& registers) const override
+    {
+        if constexpr (Type == OutputType::BOOL)
+            return {"", DataType::BOOLEAN, ""};
+        else if constexpr (Type == OutputType::STRING)
+            return {reference, DataType::STRING, decodeString(registers)};
+        else
+            return {reference, DataType::NUMERIC, std::to_string(decodeNumber(registers))};
+    }
+
+    EncodedValue encode(const std::string& value) const override
+    {
+        if constexpr (Type == OutputType::BOOL)
+        {
+            auto valueCopy = std::string{value};
+            std::transform(valueCopy.cbegin(), valueCopy.cend(), valueCopy.begin(), ::tolower);
+            if (valueCopy == "true")
+                return {{}, true};
+            else if (valueCopy == "false")
+                return {{}, false};
+            throw std::runtime_error("The mapping value is not a valid bool value.");
+        }
+        else if constexpr (Type == OutputType::UINT16)
+            return {{static_cast<std::uint16_t>(std::stoul(value))}, false};
+        else if constexpr (Type == OutputType::INT16)
+            return {{static_cast<std::uint16_t>(static_cast<std::int16_t>(std::stoi(value)))}, false};
+        else if constexpr (Type == OutputType::UINT32)
+            return {more_modbus::DataParsers::uint32ToRegisters(static_cast<std::uint32_t>(std::stoul(value)), Order),
+                    false};
+        else if constexpr (Type == OutputType::INT32)
+            return {more_modbus::DataParsers::int32ToRegisters(std::stoi(value), Order), false};
+        else if constexpr (Type == OutputType::FLOAT)
+            return {more_modbus::DataParsers::floatToRegisters(std::stof(value), Order), false};
+        else if constexpr (Unicode)
+            return {more_modbus::DataParsers::unicodeStringToRegisters(value, Order), false};
+        else
+            return {more_modbus::DataParsers::asciiStringToRegisters(value, Order), false};
+    }
+
+private:
+    static auto decodeNumber(const std::vector<std::uint16_t>& registers)
+    {
+        if constexpr (Type == OutputType::UINT16)
+            return static_cast<std::uint64_t>(registers.at(0));
+        else if constexpr (Type == OutputType::INT16)
+            return static_cast<std::int64_t>(static_cast<std::int16_t>(registers.at(0)));
+        else if constexpr (Type == OutputType::UINT32)
+            return static_cast<std::uint64_t>(more_modbus::DataParsers::registersToUint32(registers, Order));
+        else if constexpr (Type == OutputType::INT32)
+            return static_cast<std::int64_t>(more_modbus::DataParsers::registersToInt32(registers, Order));
+        else
+            return more_modbus::DataParsers::registersToFloat(registers, Order);
+    }
+
+    static std::string decodeString(const std::vector<std::uint16_t>& registers)
+    {
+        if constexpr (Unicode)
+            return more_modbus::DataParsers::registersToUnicodeString(registers, Order);
+        else
+            return more_modbus::DataParsers::registersToAsciiString(registers, Order);
+    }
+};
+
+template <OutputType Type, bool Unicode = false> const MappingCodec& select(bool littleEndian)
+{
+    static const TypedCodec<Type, Endian::BIG, Unicode> big;
+    static const TypedCodec<Type, Endian::LITTLE, Unicode> little;
+    if (littleEndian)
+        return little;
+    return big;
+}
+}    // namespace
+
+const MappingCodec& MappingCodec::forMapping(const more_modbus::RegisterMapping& mapping)
+{
+    const auto operation = mapping.getOperationType();
+    const auto littleEndian = operation == more_modbus::OperationType::MERGE_LITTLE_ENDIAN ||
+                              operation == more_modbus::OperationType::MERGE_FLOAT_LITTLE_ENDIAN ||
+                              operation == more_modbus::OperationType::STRINGIFY_ASCII_LITTLE_ENDIAN ||
+                              operation == more_modbus::OperationType::STRINGIFY_UNICODE_LITTLE_ENDIAN;
+    const auto unicode = operation == more_modbus::OperationType::STRINGIFY_UNICODE_BIG_ENDIAN ||
+                         operation == more_modbus::OperationType::STRINGIFY_UNICODE_LITTLE_ENDIAN;
+
+    switch (mapping.getOutputType())
+    {
+    case OutputType::UINT16:
+        return select<OutputType::UINT16>(littleEndian);
+    case OutputType::INT16:
+        return select<OutputType::INT16>(littleEndian);
+    case OutputType::UINT32:
+        return select<OutputType::UINT32>(littleEndian);
+    case OutputType::INT32:
+        return select<OutputType::INT32>(littleEndian);
+    case OutputType::FLOAT:
+        return select<OutputType::FLOAT>(littleEndian);
+    case OutputType::STRING:
+        return unicode ? select<OutputType::STRING, true>(littleEndian) :
+                         select<OutputType::STRING, false>(littleEndian);
+    case OutputType::BOOL:
+    default:
+        return select<OutputType::BOOL>(littleEndian);
+    }
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_MAPPINGCODEC_H
+#define WOLKGATEWAYMODBUSMODULE_MAPPINGCODEC_H
+
+#include "core/Types.h"
+#include "more_modbus/RegisterMapping.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Converter between the registers of a mapping and the values exchanged with the platform.
+ * @details A codec is chosen once per mapping, by its output type, its byte order and its string encoding, so
+ *          converting a value takes a single virtual call, without going through the types of the mapping again.
+ *          The codecs are stateless, and shared by all the mappings of the same kind.
+ */
+class MappingCodec
+{
+public:
+    // A value encoded for a mapping, as registers, or as a bit for boolean mappings
+    struct EncodedValue
+    {
+        std::vector<std::uint16_t> registers;
+        bool bit;
+    };
+
+    /**
+     * Default virtual destructor.
+     */
+    virtual ~MappingCodec() = default;
+
+    /**
+     * This is the method that returns the codec for a mapping.
+     *
+     * @param mapping The mapping.
+     * @return The codec, valid for as long as the program runs.
+     */
+    static const MappingCodec& forMapping(const more_modbus::RegisterMapping& mapping);
+
+    /**
+     * This is the method that decodes registers into a reading.
+     *
+     * @param reference The reference of the mapping.
+     * @param registers The registers of the mapping.
+     * @return The reading, with an empty reference if the registers can not be decoded.
+     */
+    virtual Reading decodeReading(const std::string& reference, const std::vector<std::uint16_t>& registers) const = 0;
+
+    /**
+     * This is the method that decodes registers into an attribute.
+     *
+     * @param reference The reference of the mapping.
+     * @param registers The registers of the mapping.
+     * @return The attribute, with an empty name if the registers can not be decoded.
+     */
+    virtual Attribute decodeAttribute(const std::string& reference,
+                                      const std::vector<std::uint16_t>& registers) const = 0;
+
+    /**
+     * This is the method that parses a value received from the platform, and encodes it for the mapping.
+     *
+     * @param value The value.
+     * @return The encoded value. Throws if the value is not valid for the mapping.
+     */
+    virtual EncodedValue encode(const std::string& value) const = 0;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_MAPPINGCODEC_H
@@ -0,0 +1,163 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/MappingRegistry.h"
+
+#include <utility>
+
+namespace wolkabout::modbus
+{
+const char MappingRegistry::SEPARATOR = '.';
+
+MappingRegistry::MappingRegistry(const DeviceRegistry& deviceRegistry) : m_deviceRegistry(deviceRegistry) {}
+
+MappingRegistry::Slot MappingRegistry::add(DeviceRegistry::DeviceId device,
+                                           const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
+                                           MappingType mappingType, bool autoReadAfterWrite, bool lossless)
+{
+    if (m_slotByReference.size() <= device)
+        m_slotByReference.resize(device + 1);
+
+    const auto slot = static_cast<Slot>(m_mappings.size());
+    m_devices.emplace_back(device);
+    m_mappings.emplace_back(mapping);
+    m_mappingTypes.emplace_back(mappingType);
+    m_codecs.emplace_back(&MappingCodec::forMapping(*mapping));
+    m_flags.emplace_back(static_cast<std::uint8_t>((autoReadAfterWrite ? AUTO_READ_AFTER_WRITE : 0) |
+                                                   (lossless ? LOSSLESS : 0)));
+    m_defaultValues.emplace_back();
+    m_repeats.emplace_back(0);
+    m_safeModeValues.emplace_back();
+
+    m_slotByReference[device][mapping->getReference()] = slot;
+    m_slotByMapping[mapping.get()] = slot;
+    return slot;
+}
+
+std::optional<MappingRegistry::Slot> MappingRegistry::find(DeviceRegistry::DeviceId device,
+                                                           const std::string& reference) const
+{
+    if (device >= m_slotByReference.size())
+        return {};
+    const auto& slots = m_slotByReference[device];
+    const auto slotIt = slots.find(reference);
+    if (slotIt == slots.cend())
+        return {};
+    return slotIt->second;
+}
+
+std::optional<MappingRegistry::Slot> MappingRegistry::find(const more_modbus::RegisterMapping& mapping) const
+{
+    const auto slotIt = m_slotByMapping.find(&mapping);
+    if (slotIt == m_slotByMapping.cend())
+        return {};
+    return slotIt->second;
+}
+
+std::size_t MappingRegistry::size() const
+{
+    return m_mappings.size();
+}
+
+DeviceRegistry::DeviceId MappingRegistry::getDevice(Slot slot) const
+{
+    return m_devices[slot];
+}
+
+const std::string& MappingRegistry::getDeviceKey(Slot slot) const
+{
+    return m_deviceRegistry.getKey(m_devices[slot]);
+}
+
+const std::shared_ptr<more_modbus::RegisterMapping>& MappingRegistry::getMapping(Slot slot) const
+{
+    return m_mappings[slot];
+}
+
+MappingType MappingRegistry::getMappingType(Slot slot) const
+{
+    return m_mappingTypes[slot];
+}
+
+const MappingCodec& MappingRegistry::getCodec(Slot slot) const
+{
+    return *m_codecs[slot];
+}
+
+bool MappingRegistry::isAutoReadAfterWrite(Slot slot) const
+{
+    return (m_flags[slot] & AUTO_READ_AFTER_WRITE) != 0;
+}
+
+bool MappingRegistry::isLossless(Slot slot) const
+{
+    return (m_flags[slot] & LOSSLESS) != 0;
+}
+
+std::string MappingRegistry::getPersistenceKey(Slot slot) const
+{
+    return getDeviceKey(slot) + SEPARATOR + m_mappings[slot]->getReference();
+}
+
+bool MappingRegistry::hasDefaultValue(Slot slot) const
+{
+    return (m_flags[slot] & DEFAULT_VALUE) != 0;
+}
+
+const std::string& MappingRegistry::getDefaultValue(Slot slot) const
+{
+    return m_defaultValues[slot];
+}
+
+void MappingRegistry::setDefaultValue(Slot slot, std::string defaultValue)
+{
+    m_defaultValues[slot] = std::move(defaultValue);
+    m_flags[slot] |= DEFAULT_VALUE;
+}
+
+bool MappingRegistry::hasRepeat(Slot slot) const
+{
+    return (m_flags[slot] & REPEAT) != 0;
+}
+
+std::chrono::milliseconds MappingRegistry::getRepeat(Slot slot) const
+{
+    return m_repeats[slot];
+}
+
+void MappingRegistry::setRepeat(Slot slot, std::chrono::milliseconds repeat)
+{
+    m_repeats[slot] = repeat;
+    m_flags[slot] |= REPEAT;
+}
+
+bool MappingRegistry::hasSafeModeValue(Slot slot) const
+{
+    return (m_flags[slot] & SAFE_MODE_VALUE) != 0;
+}
+
+const std::string& MappingRegistry::getSafeModeValue(Slot slot) const
+{
+    return m_safeModeValues[slot];
+}
+
+void MappingRegistry::setSafeModeValue(Slot slot, std::string safeModeValue)
+{
+    m_safeModeValues[slot] = std::move(safeModeValue);
+    m_flags[slot] |= SAFE_MODE_VALUE;
+}
+}    // namespace wolkabout::modbus
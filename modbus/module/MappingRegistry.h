@@ -0,0 +1,167 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_MAPPINGREGISTRY_H
+#define WOLKGATEWAYMODBUSMODULE_MAPPINGREGISTRY_H
+
+#include "modbus/model/MappingType.h"
+#include "modbus/module/DeviceRegistry.h"
+#include "modbus/module/MappingCodec.h"
+#include "more_modbus/RegisterMapping.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Table of all the mappings of all the devices, where every pair of a device and a mapping has its own slot.
+ * @details The slots are dense integers, assigned while the bridge is being initialized, and every property of the
+ *          mappings is kept in its own column indexed by the slot. A mapping reporting a value is found by its
+ *          pointer, and a platform message by the device and the reference, so neither needs to build a key.
+ *          The devices are the ones of the DeviceRegistry the mapping registry is created with. The codec of every
+ *          mapping is chosen once it's added.
+ *          Slots are not added once the devices are running, only the default, repeat and safe mode values change.
+ */
+class MappingRegistry
+{
+public:
+    using Slot = std::uint32_t;
+
+    // Separator between the device key and the reference in the persisted keys
+    static const char SEPARATOR;
+
+    /**
+     * Default constructor for the registry.
+     *
+     * @param deviceRegistry The registry of the devices the mappings belong to.
+     */
+    explicit MappingRegistry(const DeviceRegistry& deviceRegistry);
+
+    /**
+     * This is the method that adds a mapping of a device into the registry.
+     *
+     * @param device The device.
+     * @param mapping The mapping of the device.
+     * @param mappingType The type of the mapping, describing how it's presented to the platform.
+     * @param autoReadAfterWrite Whether the mapping is read back after it's written.
+     * @param lossless Whether every value of the mapping is sent, and none of them are compacted away.
+     * @return The slot of the mapping.
+     */
+    Slot add(DeviceRegistry::DeviceId device, const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
+             MappingType mappingType, bool autoReadAfterWrite, bool lossless);
+
+    /**
+     * This is the method that finds the slot of a mapping by the device and the reference.
+     *
+     * @param device The device.
+     * @param reference The reference of the mapping.
+     * @return The slot, empty if the mapping is not known.
+     */
+    std::optional<Slot> find(DeviceRegistry::DeviceId device, const std::string& reference) const;
+
+    /**
+     * This is the method that finds the slot of a mapping.
+     *
+     * @param mapping The mapping.
+     * @return The slot, empty if the mapping is not known.
+     */
+    std::optional<Slot> find(const more_modbus::RegisterMapping& mapping) const;
+
+    /**
+     * This is the method that returns the count of the slots. The slots go from zero up to the count.
+     *
+     * @return The count of the slots.
+     */
+    std::size_t size() const;
+
+    DeviceRegistry::DeviceId getDevice(Slot slot) const;
+
+    const std::string& getDeviceKey(Slot slot) const;
+
+    const std::shared_ptr<more_modbus::RegisterMapping>& getMapping(Slot slot) const;
+
+    MappingType getMappingType(Slot slot) const;
+
+    const MappingCodec& getCodec(Slot slot) const;
+
+    bool isAutoReadAfterWrite(Slot slot) const;
+
+    bool isLossless(Slot slot) const;
+
+    /**
+     * This is the method that returns the key under which the values of the mapping are persisted.
+     *
+     * @param slot The slot of the mapping.
+     * @return The key, the device key and the reference joined by the separator.
+     */
+    std::string getPersistenceKey(Slot slot) const;
+
+    bool hasDefaultValue(Slot slot) const;
+
+    const std::string& getDefaultValue(Slot slot) const;
+
+    void setDefaultValue(Slot slot, std::string defaultValue);
+
+    bool hasRepeat(Slot slot) const;
+
+    std::chrono::milliseconds getRepeat(Slot slot) const;
+
+    void setRepeat(Slot slot, std::chrono::milliseconds repeat);
+
+    bool hasSafeModeValue(Slot slot) const;
+
+    const std::string& getSafeModeValue(Slot slot) const;
+
+    void setSafeModeValue(Slot slot, std::string safeModeValue);
+
+private:
+    // The bits of the flags column
+    enum Flag : std::uint8_t
+    {
+        AUTO_READ_AFTER_WRITE = 1 << 0,
+        DEFAULT_VALUE = 1 << 1,
+        REPEAT = 1 << 2,
+        SAFE_MODE_VALUE = 1 << 3,
+        LOSSLESS = 1 << 4
+    };
+
+    // The devices
+    const DeviceRegistry& m_deviceRegistry;
+
+    // The columns, indexed by the slot
+    std::vector<DeviceRegistry::DeviceId> m_devices;
+    std::vector<std::shared_ptr<more_modbus::RegisterMapping>> m_mappings;
+    std::vector<MappingType> m_mappingTypes;
+    std::vector<const MappingCodec*> m_codecs;
+    std::vector<std::uint8_t> m_flags;
+    std::vector<std::string> m_defaultValues;
+    std::vector<std::chrono::milliseconds> m_repeats;
+    std::vector<std::string> m_safeModeValues;
+
+    // The indexes by which the slots are found, the references are indexed per device
+    std::vector<std::unordered_map<std::string, Slot>> m_slotByReference;
+    std::unordered_map<const more_modbus::RegisterMapping*, Slot> m_slotByMapping;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_MAPPINGREGISTRY_H
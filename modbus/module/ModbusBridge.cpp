@@ -16,24 +16,18 @@
 
 #include "modbus/module/ModbusBridge.h"
 
-#include "MoreModbus/more_modbus/mappings/FloatMapping.h"
-#include "MoreModbus/more_modbus/mappings/Int16Mapping.h"
-#include "MoreModbus/more_modbus/mappings/Int32Mapping.h"
-#include "MoreModbus/more_modbus/mappings/StringMapping.h"
-#include "MoreModbus/more_modbus/mappings/UInt16Mapping.h"
-#include "MoreModbus/more_modbus/mappings/UInt32Mapping.h"
 #include "core/utilities/Logger.h"
 #include "modbus/module/RegisterMappingFactory.h"
+#include "modbus/module/WolkaboutTemplateFactory.h"
 #include "more_modbus/ModbusDevice.h"
-#include "more_modbus/mappings/BoolMapping.h"
-#include "more_modbus/modbus/ModbusClient.h"
-#include "more_modbus/utilities/DataParsers.h"
 
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <utility>
@@ -41,17 +35,19 @@
 
 namespace wolkabout::modbus
 {
-const char ModbusBridge::SEPARATOR = '.';
-
-ModbusBridge::ModbusBridge(std::shared_ptr<more_modbus::ModbusClient> modbusClient,
-                           std::chrono::milliseconds registerReadPeriod,
+ModbusBridge::ModbusBridge(std::map<std::string, std::shared_ptr<ModbusTransport>> transports,
+                           std::chrono::milliseconds registerReadPeriod, std::uint16_t readGapTolerance,
+                           HealthPolicy healthPolicy, std::chrono::milliseconds readAfterWriteWindow,
                            std::unique_ptr<KeyValuePersistence> defaultValuePersistence,
                            std::unique_ptr<KeyValuePersistence> repeatValuePersistence,
                            std::unique_ptr<KeyValuePersistence> safeModePersistence)
-: m_modbusClient(std::move(modbusClient))
+: m_transports(std::move(transports))
 , m_registerReadPeriod(registerReadPeriod)
-, m_deviceKeyBySlaveAddress()
-, m_registerMappingByReference()
+, m_readGapTolerance(readGapTolerance)
+, m_healthPolicy(healthPolicy)
+, m_readAfterWriteWindow(readAfterWriteWindow)
+, m_deviceRegistry()
+, m_mappingRegistry(m_deviceRegistry)
 , m_connectivityStatus(ConnectivityStatus::NONE)
 , m_defaultValuePersistence(std::move(defaultValuePersistence))
 , m_repeatValuePersistence(std::move(repeatValuePersistence))
@@ -62,163 +58,156 @@ ModbusBridge::ModbusBridge(std::shared_ptr<more_modbus::ModbusClient> modbusClie
 ModbusBridge::~ModbusBridge()
 {
     stop();
-    if (m_modbusClient != nullptr)
-        m_modbusClient->disconnect();
+    for (const auto& transport : m_transports)
+        transport.second->stop();
 }
 
 void ModbusBridge::initialize(const std::map<std::string, std::unique_ptr<DeviceTemplate>>& templates,
-                              const std::map<std::string, std::vector<std::uint16_t>>& deviceAddressesByTemplate,
-                              const std::map<std::uint16_t, std::unique_ptr<Device>>& devices)
+                              const std::map<std::string, std::vector<std::string>>& deviceKeysByTemplate,
+                              const std::map<std::string, std::unique_ptr<DeviceInformation>>& devices)
 {
-    // Create the reader
-    m_modbusReader = std::make_shared<more_modbus::ModbusReader>(*m_modbusClient, m_registerReadPeriod);
+    // Create a scheduler for every transport, each one issues the requests of its buses from its own thread
+    auto pollSchedulerByTransport = std::map<const ModbusTransport*, PollScheduler*>{};
+    for (const auto& transport : m_transports)
+    {
+        auto& pollScheduler = pollSchedulerByTransport[transport.second.get()];
+        if (pollScheduler == nullptr)
+        {
+            m_pollSchedulers.emplace_back(std::unique_ptr<PollScheduler>{new PollScheduler{
+              transport.second, ReadPlanner{m_readGapTolerance}, m_healthPolicy, m_readAfterWriteWindow}});
+            pollScheduler = m_pollSchedulers.back().get();
+        }
+        m_pollSchedulerByBus.emplace(transport.first, pollScheduler);
+    }
 
-    // Create the list of devices we're going to add to the reader
-    auto modbusDevices = std::vector<std::shared_ptr<more_modbus::ModbusDevice>>{};
+    // Load the persisted values
     auto defaultValues = m_defaultValuePersistence->loadValues();
     auto repeatedValues = m_repeatValuePersistence->loadValues();
     auto safeModeValues = m_safeModePersistence->loadValues();
 
     // Go through the list of devices for every template, and copy the data for the template to each device.
-    for (const auto& templateRegistered : deviceAddressesByTemplate)
+    for (const auto& templateRegistered : deviceKeysByTemplate)
     {
         // Create an initial list of mappings for the template.
         const auto& templateInfo = *(templates.at(templateRegistered.first));
-        auto mappings = std::vector<std::shared_ptr<more_modbus::RegisterMapping>>{};
-        auto defaultValueMappings = std::map<std::string, std::string>{};
-        auto repeatValueMappings = std::map<std::string, std::chrono::milliseconds>{};
-        auto safeMappings = std::map<std::string, std::string>{};
-        auto mappingTypeByReference = std::map<std::string, MappingType>{};
-        auto autoReadMappings = std::map<std::string, bool>{};
-
-        // Go through the mappings of the template
-        for (const auto& mapping : templateInfo.getMappings())
-        {
-            mappingTypeByReference.emplace(mapping.getReference(), mapping.getMappingType());
-            autoReadMappings.emplace(mapping.getReference(), mapping.isAutoReadAfterWrite());
-
-            // If any of the mappings are in the special categories
-            if (!mapping.getDefaultValue().empty())
-                defaultValueMappings.emplace(mapping.getReference(), mapping.getDefaultValue());
-            if (mapping.getRepeat().count() > 0)
-                repeatValueMappings.emplace(mapping.getReference(), mapping.getRepeat());
-            if (mapping.hasSafeMode())
-                safeMappings.emplace(mapping.getReference(), mapping.getSafeModeValue());
-        }
+        auto mappings = std::vector<std::shared_ptr<PolledMapping>>{};
 
-        // Foreach device slaveAddress, copy over the mappings to create the device.
-        for (const auto& slaveAddress : templateRegistered.second)
+        // Foreach device, copy over the mappings to create the device.
+        auto planLogged = false;
+        for (const auto& key : templateRegistered.second)
         {
-            const auto key = devices.at(slaveAddress)->getKey();
-
-            // Filter out the default, repeat and safe mode values for this device
-            const auto defaultValuesForDevice = [&]()
-            {
-                auto map = std::map<std::string, std::string>{};
-                std::copy_if(defaultValues.cbegin(), defaultValues.cend(), std::inserter(map, map.end()),
-                             [&](const std::pair<std::string, std::string>& pair)
-                             { return pair.first.find(key + SEPARATOR) != std::string::npos; });
-                return map;
-            }();
-            const auto repeatValuesForDevice = [&]()
-            {
-                auto map = std::map<std::string, std::string>{};
-                std::copy_if(repeatedValues.cbegin(), repeatedValues.cend(), std::inserter(map, map.end()),
-                             [&](const std::pair<std::string, std::string>& pair)
-                             { return pair.first.find(key + SEPARATOR) != std::string::npos; });
-                return map;
-            }();
-            const auto safeModeValueForDevice = [&]()
+            const auto& deviceInformation = *devices.at(key);
+            const auto schedulerIt = m_pollSchedulerByBus.find(deviceInformation.getBus());
+            if (schedulerIt == m_pollSchedulerByBus.cend())
             {
-                auto map = std::map<std::string, std::string>{};
-                std::copy_if(safeModeValues.cbegin(), safeModeValues.cend(), std::inserter(map, map.end()),
-                             [&](const std::pair<std::string, std::string>& pair)
-                             { return pair.first.find(key + SEPARATOR) != std::string::npos; });
-                return map;
-            }();
+                LOG(WARN) << TAG << "Device '" << key << "' is on bus '" << deviceInformation.getBus()
+                          << "' that does not exist. Ignoring device...";
+                continue;
+            }
+            auto& pollScheduler = *schedulerIt->second;
 
-            const auto device = std::make_shared<more_modbus::ModbusDevice>(key, slaveAddress);
+            const auto device = std::make_shared<more_modbus::ModbusDevice>(key, deviceInformation.getSlaveAddress());
+            const auto deviceId = m_deviceRegistry.add(key, deviceInformation.getBus(), device, &pollScheduler);
+            if (!deviceId)
+            {
+                LOG(WARN) << TAG << "Device '" << key << "' conflicts with a device that is already registered. "
+                          << "Ignoring device...";
+                continue;
+            }
 
+            // The mappings are read in their own period, or the period of the template, or the period of the module
             mappings.clear();
             for (const auto& mapping : templateInfo.getMappings())
             {
-                mappings.emplace_back(RegisterMappingFactory::fromJSONMapping(mapping));
+                const auto pollPeriod =
+                  mapping.getPollPeriod().count() > 0 ?
+                    mapping.getPollPeriod() :
+                    (templateInfo.getPollPeriod().count() > 0 ? templateInfo.getPollPeriod() : m_registerReadPeriod);
+                mappings.emplace_back(std::make_shared<PolledMapping>(
+                  PolledMapping{device, RegisterMappingFactory::fromJSONMapping(mapping), mapping, pollPeriod}));
             }
+            const auto groups =
+              pollScheduler.addDevice(device, deviceInformation.getBus(), mappings, deviceInformation.getMaxInFlight());
 
-            device->createGroups(mappings);
-            modbusDevices.emplace_back(device);
-
-            m_deviceKeyBySlaveAddress.emplace(slaveAddress, key);
+            // All devices of a template have the same plan, so it's enough to show it once
+            if (!planLogged)
+            {
+                LOG(INFO) << TAG << "Template '" << templateInfo.getName() << "' is read with " << groups.size()
+                          << " read request(s):\n"
+                          << ReadPlanner::describe(groups);
+                planLogged = true;
+            }
 
-            // Register all the mappings into a map, keep configuration mappings special too.
-            for (const auto& group : device->getGroups())
+            // Register all the mappings into the registry, keep configuration mappings special too.
+            // The persisted values of the device take precedence over the ones from the template.
+            for (const auto& polledMapping : mappings)
             {
-                for (const auto& mapping : group->getMappings())
+                const auto& mapping = polledMapping->mapping;
+                const auto& configuration = polledMapping->configuration;
+                const auto slot =
+                  m_mappingRegistry.add(*deviceId, mapping, configuration.getMappingType(),
+                                        configuration.isAutoReadAfterWrite(), configuration.isLossless());
+                const auto persistenceKey = m_mappingRegistry.getPersistenceKey(slot);
+
+                if (configuration.isAggregated())
+                    m_windowAggregator.add(*deviceId, slot, configuration.getReference(),
+                                           configuration.getAggregationWindow(),
+                                           configuration.getAggregationStatistics());
+
+                if (!configuration.getDefaultValue().empty())
                 {
-                    m_registerMappingByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                         mapping.second);
-                    m_registerMappingTypeByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                             mappingTypeByReference[mapping.second->getReference()]);
-
-                    const auto defaultValueIt = defaultValueMappings.find(mapping.second->getReference());
-                    if (defaultValueIt != defaultValueMappings.cend())
-                    {
-                        auto defaultValue = defaultValueIt->second;
-                        const auto it = defaultValuesForDevice.find(key + SEPARATOR + mapping.second->getReference());
-                        if (it != defaultValuesForDevice.cend())
-                            defaultValue = it->second;
-                        m_defaultValueMappingByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                                 defaultValue);
-                    }
+                    const auto it = defaultValues.find(persistenceKey);
+                    m_mappingRegistry.setDefaultValue(
+                      slot, it != defaultValues.cend() ? it->second : configuration.getDefaultValue());
+                }
 
-                    const auto repeatIt = repeatValueMappings.find(mapping.second->getReference());
-                    if (repeatIt != repeatValueMappings.cend())
+                if (configuration.getRepeat().count() > 0)
+                {
+                    auto repeatValue = configuration.getRepeat();
+                    const auto it = repeatedValues.find(persistenceKey);
+                    if (it != repeatedValues.cend())
                     {
-                        auto repeatValue = repeatIt->second;
-                        const auto it = repeatValuesForDevice.find(key + SEPARATOR + mapping.second->getReference());
-                        if (it != repeatValuesForDevice.cend())
+                        try
                         {
-                            try
-                            {
-                                repeatValue = std::chrono::milliseconds(std::stoull(it->second));
-                            }
-                            catch (const std::exception& exception)
-                            {
-                                LOG(WARN) << "Found invalid persisted `repeat` value for '" << key << "'/'"
-                                          << mapping.second->getReference() << "'.";
-                            }
+                            repeatValue = std::chrono::milliseconds(std::stoull(it->second));
+                        }
+                        catch (const std::exception& exception)
+                        {
+                            LOG(WARN) << "Found invalid persisted `repeat` value for '" << key << "'/'"
+                                      << mapping->getReference() << "'.";
                         }
-                        m_repeatedWriteMappingByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                                  repeatValue);
-
-                        mapping.second->setRepeatedWrite(repeatValue);
-                    }
-
-                    const auto safeIt = safeMappings.find(mapping.second->getReference());
-                    if (safeIt != safeMappings.cend())
-                    {
-                        auto safeModeValue = safeIt->second;
-                        const auto it = safeModeValueForDevice.find(key + SEPARATOR + mapping.second->getReference());
-                        if (it != safeModeValueForDevice.cend())
-                            safeModeValue = it->second;
-                        m_safeModeMappingByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                             safeModeValue);
                     }
+                    m_mappingRegistry.setRepeat(slot, repeatValue);
+                    pollScheduler.setRepeatedWrite(*mapping, repeatValue);
+                }
 
-                    m_autoReadByReference.emplace(key + SEPARATOR + mapping.second->getReference(),
-                                                  autoReadMappings[mapping.second->getReference()]);
+                if (configuration.hasSafeMode())
+                {
+                    const auto it = safeModeValues.find(persistenceKey);
+                    m_mappingRegistry.setSafeModeValue(
+                      slot, it != safeModeValues.cend() ? it->second : configuration.getSafeModeValue());
                 }
             }
         }
     }
 
-    m_modbusReader->addDevices(modbusDevices);
-    initializeSetUpDeviceCallback(modbusDevices);
+    m_valueBatches.resize(m_deviceRegistry.size());
+    initializeSetUpDeviceCallback();
 }
 
 bool ModbusBridge::isRunning() const
 {
-    return m_modbusReader->isRunning();
+    return std::any_of(m_pollSchedulers.cbegin(), m_pollSchedulers.cend(),
+                       [](const std::unique_ptr<PollScheduler>& pollScheduler) { return pollScheduler->isRunning(); });
+}
+
+bool ModbusBridge::isLossless(const std::string& deviceKey, const std::string& reference) const
+{
+    const auto device = m_deviceRegistry.find(deviceKey);
+    if (!device)
+        return true;
+    const auto slot = m_mappingRegistry.find(*device, reference);
+    return !slot || m_mappingRegistry.isLossless(*slot);
 }
 
 void ModbusBridge::setFeedValueCallback(
@@ -228,41 +217,37 @@ void ModbusBridge::setFeedValueCallback(
 }
 
 void ModbusBridge::setAttributeCallback(
-  const std::function<void(const std::string&, const Attribute&)>& attributeCallback)
+  const std::function<void(const std::string&, const std::vector<Attribute>&)>& attributeCallback)
 {
     m_attributeCallback = attributeCallback;
 }
 
-int ModbusBridge::getSlaveAddress(const std::string& deviceKey)
-{
-    const auto iterator =
-      std::find_if(m_deviceKeyBySlaveAddress.begin(), m_deviceKeyBySlaveAddress.end(),
-                   [deviceKey](const std::pair<int, std::string>& element) { return element.second == deviceKey; });
-    return iterator != m_deviceKeyBySlaveAddress.end() ? iterator->first : -1;
-}
-
 // methods for the running logic of modbusBridge
 void ModbusBridge::start()
 {
-    m_modbusReader->start();
+    for (const auto& pollScheduler : m_pollSchedulers)
+        pollScheduler->start();
     LOG(DEBUG) << "Writing in DefaultValues into mappings.";
-    writeAMapOfValues(m_defaultValueMappingByReference);
+    auto defaultValues = std::vector<std::pair<MappingRegistry::Slot, std::string>>{};
+    for (auto slot = MappingRegistry::Slot{0}; slot < m_mappingRegistry.size(); ++slot)
+    {
+        if (m_mappingRegistry.hasDefaultValue(slot))
+            defaultValues.emplace_back(slot, m_mappingRegistry.getDefaultValue(slot));
+    }
+    writeValues(defaultValues);
 
     // Publish all the DefaultValues, RepeatWriteValues and SafeModeValues
     if (m_feedValueCallback)
     {
-        auto readings = std::map<std::string, std::vector<Reading>>{};
-        makeReadingsFromMap(readings, m_defaultValueMappingByReference, "DFV");
-        makeReadingsFromMap(readings, m_repeatedWriteMappingByReference, "RPW");
-        makeReadingsFromMap(readings, m_safeModeMappingByReference, "SMV");
-        for (const auto& pair : readings)
+        for (const auto& pair : makeConfigurationReadings())
             m_feedValueCallback(pair.first, pair.second);
     }
 }
 
 void ModbusBridge::stop()
 {
-    m_modbusReader->stop();
+    for (const auto& pollScheduler : m_pollSchedulers)
+        pollScheduler->stop();
 }
 
 void ModbusBridge::platformStatus(ConnectivityStatus status)
@@ -278,7 +263,17 @@ void ModbusBridge::platformStatus(ConnectivityStatus status)
     if (m_connectivityStatus == ConnectivityStatus::OFFLINE)
     {
         LOG(DEBUG) << "Writing in SafeModeValues into mappings.";
-        writeAMapOfValues(m_safeModeMappingByReference);
+        const auto start = std::chrono::steady_clock::now();
+        auto safeModeValues = std::vector<std::pair<MappingRegistry::Slot, std::string>>{};
+        for (auto slot = MappingRegistry::Slot{0}; slot < m_mappingRegistry.size(); ++slot)
+        {
+            if (m_mappingRegistry.hasSafeModeValue(slot))
+                safeModeValues.emplace_back(slot, m_mappingRegistry.getSafeModeValue(slot));
+        }
+        writeValues(safeModeValues);
+        const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        LOG(INFO) << TAG << "Reached the safe state in " << elapsed.count() << "ms.";
     }
 }
 
@@ -288,12 +283,13 @@ void ModbusBridge::handleUpdate(const std::string& deviceKey,
     LOG(TRACE) << METHOD_INFO;
 
     // Check the device key
-    auto slaveAddress = getSlaveAddress(deviceKey);
-    if (slaveAddress == -1 || m_deviceKeyBySlaveAddress.find(slaveAddress) == m_deviceKeyBySlaveAddress.end())
+    const auto device = m_deviceRegistry.find(deviceKey);
+    if (!device)
     {
         LOG(ERROR) << TAG << "No device with key '" << deviceKey << "'";
         return;
     }
+    const auto pollScheduler = m_deviceRegistry.getPollScheduler(*device);
 
     // Go through the sets of readings
     for (const auto& readingSet : readings)
@@ -304,37 +300,32 @@ void ModbusBridge::handleUpdate(const std::string& deviceKey,
             // Check if it is one of the special feeds
             if (isDefaultValueReading(reading))
             {
-                handleDefaultValueReading(deviceKey, reading);
+                handleDefaultValueReading(*device, reading);
                 continue;
             }
             else if (isRepeatWriteReading(reading))
             {
-                handleRepeatWriteReading(deviceKey, reading);
+                handleRepeatWriteReading(*device, reading);
                 continue;
             }
             else if (isSafeModeValueReading(reading))
             {
-                handleSafeModeValueReading(deviceKey, reading);
+                handleSafeModeValueReading(*device, reading);
                 continue;
             }
 
-            // Check whether we're supposed to read the register right after
-            const auto readAfter = [&]
-            {
-                const auto ref = m_autoReadByReference.find(deviceKey + SEPARATOR + reading.getReference());
-                return ref != m_autoReadByReference.cend() && ref->second;
-            }();
-
             // Handle it like a normal feed
-            const auto mappingIt = m_registerMappingByReference.find(deviceKey + SEPARATOR + reading.getReference());
-            if (mappingIt == m_registerMappingByReference.cend())
+            const auto slot = m_mappingRegistry.find(*device, reading.getReference());
+            if (!slot)
             {
                 LOG(ERROR) << "Received reading for a mapping that could not be found.";
                 continue;
             }
-            writeToMapping(mappingIt->second, reading.getStringValue());
-            if (readAfter)
-                m_modbusReader->forceReadOfMapping(*mappingIt->second);
+            writeToMapping(*slot, reading.getStringValue());
+
+            // Check whether we're supposed to read the register right after
+            if (m_mappingRegistry.isAutoReadAfterWrite(*slot))
+                pollScheduler->forceReadOfMapping(*m_mappingRegistry.getMapping(*slot));
         }
     }
 
@@ -346,8 +337,7 @@ void ModbusBridge::handleUpdate(const std::string& deviceKey, const std::vector<
     LOG(TRACE) << METHOD_INFO;
 
     // Check the device key
-    auto slaveAddress = getSlaveAddress(deviceKey);
-    if (slaveAddress == -1 || m_deviceKeyBySlaveAddress.find(slaveAddress) == m_deviceKeyBySlaveAddress.end())
+    if (!m_deviceRegistry.find(deviceKey))
     {
         LOG(ERROR) << TAG << "Received parameters update for device '" << deviceKey
                    << "' but the device key was not found.";
@@ -360,330 +350,271 @@ void ModbusBridge::handleUpdate(const std::string& deviceKey, const std::vector<
                   << "' | Value: '" << parameter.second << "'";
 }
 
-void ModbusBridge::initializeSetUpDeviceCallback(const std::vector<std::shared_ptr<more_modbus::ModbusDevice>>& devices)
+void ModbusBridge::initializeSetUpDeviceCallback()
 {
     // Set up the device mapping value change logic.
-    for (const auto& device : devices)
+    for (const auto& pollScheduler : m_pollSchedulers)
     {
-        device->setOnStatusChange(
-          [device](bool status)
+        pollScheduler->setOnStatusChange(
+          [this](const std::shared_ptr<more_modbus::ModbusDevice>& device, DeviceStatus status)
           {
-              LOG(INFO) << "Device status '" << device->getName() << "' changed to '"
-                        << (status ? "CONNECTED" : "DISCONNECTED") << "'.";
+              LOG(INFO) << "Device status '" << device->getName() << "' changed to '" << toString(status) << "'.";
+              if (m_feedValueCallback)
+                  m_feedValueCallback(device->getName(),
+                                      {Reading{WolkaboutTemplateFactory::DEVICE_STATUS_REFERENCE, toString(status)}});
           });
 
-        device->setOnMappingValueChange([this, device](const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                                       const std::vector<std::uint16_t>& bytes)
-                                        { sendOutMappingValue(device, mapping, bytes); });
+        pollScheduler->setOnMappingValueChange(
+          PollScheduler::BytesCallback{[this](const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                              const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
+                                              const std::vector<std::uint16_t>& bytes)
+                                       { sendOutMappingValue(device, mapping, bytes); }});
 
-        device->setOnMappingValueChange([this, device](const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                                       bool data) { sendOutMappingValue(device, mapping, data); });
+        pollScheduler->setOnMappingValueChange(
+          PollScheduler::BoolCallback{[this](const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                             const std::shared_ptr<more_modbus::RegisterMapping>& mapping, bool data)
+                                      { sendOutMappingValue(device, mapping, data); }});
+
+        pollScheduler->setOnCycleComplete([this](const std::shared_ptr<more_modbus::ModbusDevice>& device)
+                                          { sendOutDeviceValues(device); });
     }
 }
 
-void ModbusBridge::writeAMapOfValues(const std::map<std::string, std::string>& mapOfValues)
+void ModbusBridge::writeValues(const std::vector<std::pair<MappingRegistry::Slot, std::string>>& values)
 {
-    for (const auto& pair : mapOfValues)
+    // Group the values by the poll scheduler, so each of them can batch the writes of its devices
+    auto writesByScheduler = std::map<PollScheduler*, std::vector<PollScheduler::MappingWrite>>{};
+    auto slotsByScheduler = std::map<PollScheduler*, std::vector<MappingRegistry::Slot>>{};
+    for (const auto& pair : values)
     {
-        const auto& mapping = m_registerMappingByReference[pair.first];
-        writeToMapping(mapping, pair.second);
-        if (mapping->getOutputType() == more_modbus::OutputType::BOOL)
-            triggerGroupValueChangeBool(mapping);
-        else
-            triggerGroupValueChangeBytes(mapping);
+        const auto pollScheduler = m_deviceRegistry.getPollScheduler(m_mappingRegistry.getDevice(pair.first));
+        try
+        {
+            writesByScheduler[pollScheduler].emplace_back(encodeValue(pair.first, pair.second));
+            slotsByScheduler[pollScheduler].emplace_back(pair.first);
+        }
+        catch (const std::exception& exception)
+        {
+            LOG(ERROR) << TAG << "Failed to write in a value into the mapping '"
+                       << m_mappingRegistry.getPersistenceKey(pair.first) << "'. The value is not valid -> '"
+                       << exception.what() << "'.";
+        }
     }
-}
 
-void ModbusBridge::triggerGroupValueChangeBool(const std::shared_ptr<more_modbus::RegisterMapping>& mapping)
-{
-    if (auto group = mapping->getGroup().lock())
+    // The buses are independent, so they are written at the same time
+    auto results = std::vector<std::pair<PollScheduler*, std::future<std::vector<bool>>>>{};
+    for (const auto& pair : writesByScheduler)
+    {
+        const auto pollScheduler = pair.first;
+        const auto& writes = pair.second;
+        results.emplace_back(pollScheduler, std::async(std::launch::async, [pollScheduler, &writes] {
+                                 return pollScheduler->writeMappings(writes);
+                             }));
+    }
+
+    // The values that were written are sent out to the platform, without reading them back
+    auto written = std::size_t{0};
+    auto total = std::size_t{0};
+    auto writtenDevices = std::set<DeviceRegistry::DeviceId>{};
+    for (auto& result : results)
     {
-        if (auto device = group->getDevice().lock())
+        const auto pollScheduler = result.first;
+        const auto& writes = writesByScheduler.at(pollScheduler);
+        const auto& slots = slotsByScheduler.at(pollScheduler);
+        const auto successes = result.second.get();
+        total += writes.size();
+        for (auto i = std::size_t{0}; i < writes.size(); ++i)
         {
-            device->triggerOnMappingValueChange(mapping, mapping->getBoolValue());
-            sendOutMappingValue(device, mapping, mapping->getBoolValue());
+            if (!successes[i])
+                continue;
+            ++written;
+            const auto deviceId = m_mappingRegistry.getDevice(slots[i]);
+            const auto& device = m_deviceRegistry.getDevice(deviceId);
+            const auto& write = writes[i];
+            if (write.mapping->getOutputType() == more_modbus::OutputType::BOOL)
+                sendOutMappingValue(device, write.mapping, write.bit);
+            else
+                sendOutMappingValue(device, write.mapping, write.registers);
+            writtenDevices.emplace(deviceId);
         }
     }
+    for (const auto deviceId : writtenDevices)
+        sendOutDeviceValues(m_deviceRegistry.getDevice(deviceId));
+    LOG(DEBUG) << TAG << "Wrote " << written << " out of " << total << " value(s) into mappings.";
 }
 
-void ModbusBridge::triggerGroupValueChangeBytes(const std::shared_ptr<more_modbus::RegisterMapping>& mapping)
+std::map<std::string, std::vector<Reading>> ModbusBridge::makeConfigurationReadings() const
 {
-    if (auto group = mapping->getGroup().lock())
+    auto readings = std::map<std::string, std::vector<Reading>>{};
+    for (auto slot = MappingRegistry::Slot{0}; slot < m_mappingRegistry.size(); ++slot)
     {
-        if (auto device = group->getDevice().lock())
-        {
-            device->triggerOnMappingValueChange(mapping, mapping->getBytesValues());
-            sendOutMappingValue(device, mapping, mapping->getBytesValues());
-        }
+        const auto& reference = m_mappingRegistry.getMapping(slot)->getReference();
+        auto& deviceReadings = readings[m_mappingRegistry.getDeviceKey(slot)];
+        if (m_mappingRegistry.hasDefaultValue(slot))
+            deviceReadings.emplace_back("DFV(" + reference + ")", m_mappingRegistry.getDefaultValue(slot));
+        if (m_mappingRegistry.hasRepeat(slot))
+            deviceReadings.emplace_back("RPW(" + reference + ")",
+                                        std::to_string(m_mappingRegistry.getRepeat(slot).count()));
+        if (m_mappingRegistry.hasSafeModeValue(slot))
+            deviceReadings.emplace_back("SMV(" + reference + ")", m_mappingRegistry.getSafeModeValue(slot));
     }
+
+    // Devices without any configuration values are not published
+    for (auto it = readings.begin(); it != readings.end();)
+        it = it->second.empty() ? readings.erase(it) : std::next(it);
+    return readings;
 }
 
-void ModbusBridge::writeToMapping(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                  const std::string& value)
+PollScheduler::MappingWrite ModbusBridge::encodeValue(MappingRegistry::Slot slot, const std::string& value) const
+{
+    auto encoded = m_mappingRegistry.getCodec(slot).encode(value);
+    return {m_mappingRegistry.getMapping(slot), std::move(encoded.registers), encoded.bit};
+}
+
+bool ModbusBridge::writeToMapping(MappingRegistry::Slot slot, const std::string& value)
 {
     LOG(TRACE) << TAG << METHOD_INFO;
 
+    const auto& mapping = m_mappingRegistry.getMapping(slot);
+    const auto pollScheduler = m_deviceRegistry.getPollScheduler(m_mappingRegistry.getDevice(slot));
     try
     {
-        switch (mapping->getOutputType())
-        {
-        case more_modbus::OutputType::BOOL:
-        {
-            auto boolValue = [&]
-            {
-                auto valueCopy = std::string{value};
-                std::transform(valueCopy.cbegin(), valueCopy.cend(), valueCopy.begin(), ::tolower);
-                if (valueCopy == "true")
-                    return true;
-                else if (valueCopy == "false")
-                    return false;
-                throw std::runtime_error("The mapping value is not a valid bool value.");
-            }();
-            writeToMappingSpecific<more_modbus::BoolMapping, bool>(mapping, boolValue);
-            return;
-        }
-        case more_modbus::OutputType::UINT16:
-            writeToMappingSpecific<more_modbus::UInt16Mapping, std::uint16_t>(
-              mapping, static_cast<std::uint16_t>(std::stoul(value)));
-            break;
-        case more_modbus::OutputType::INT16:
-            writeToMappingSpecific<more_modbus::Int16Mapping, std::int16_t>(
-              mapping, static_cast<std::int16_t>(std::stoi(value)));
-            break;
-        case more_modbus::OutputType::UINT32:
-            writeToMappingSpecific<more_modbus::UInt32Mapping, std::uint32_t>(
-              mapping, static_cast<std::uint32_t>(std::stoul(value)));
-            break;
-        case more_modbus::OutputType::INT32:
-            writeToMappingSpecific<more_modbus::Int32Mapping, std::int32_t>(mapping, std::stoi(value));
-            break;
-        case more_modbus::OutputType::FLOAT:
-            writeToMappingSpecific<more_modbus::FloatMapping, float>(mapping, std::stof(value));
-            break;
-        case more_modbus::OutputType::STRING:
-            writeToMappingSpecific<more_modbus::StringMapping, std::string>(mapping, value);
-            break;
-        }
+        const auto write = encodeValue(slot, value);
+        if (mapping->getOutputType() == more_modbus::OutputType::BOOL)
+            return pollScheduler->writeMapping(*mapping, write.bit);
+        return pollScheduler->writeMapping(*mapping, write.registers);
     }
     catch (const std::exception& exception)
     {
         LOG(ERROR) << TAG << "Failed to write in a value into the mapping. The value is not valid -> '"
                    << exception.what() << "'.";
     }
+    return false;
 }
 
 void ModbusBridge::sendOutMappingValue(const std::shared_ptr<more_modbus::ModbusDevice>& device,
                                        const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
                                        const std::vector<std::uint16_t>& bytes)
 {
-    // Find the device key of the device that had a value update
-    const auto deviceKeyIt = m_deviceKeyBySlaveAddress.find(device->getSlaveAddress());
-    if (deviceKeyIt == m_deviceKeyBySlaveAddress.cend())
-    {
-        LOG(WARN) << TAG << "Received value update from device with a slave address that is not in the registry.";
-        return;
-    }
-    const auto deviceKey = deviceKeyIt->second;
-
-    // Check that there is a callback
-    if (!m_feedValueCallback)
+    // The name of the device is its key
+    const auto& deviceKey = device->getName();
+    const auto slot = m_mappingRegistry.find(*mapping);
+    if (!slot)
     {
-        LOG(WARN) << TAG << "Received value update for '" << deviceKey << "'/'" << mapping->getReference()
-                  << "' but the callback is not set.";
-        return;
-    }
-
-    // Check the type of the mapping
-    const auto mappingTypeIt = m_registerMappingTypeByReference.find(deviceKey + SEPARATOR + mapping->getReference());
-    if (mappingTypeIt == m_registerMappingTypeByReference.cend())
-    {
-        LOG(WARN) << TAG << "Received value update for '" << deviceKey << "'/'" << mapping->getReference()
-                  << "' but the mapping type for this mapping is unknown.";
+        LOG(WARN) << TAG << "Received value update from device '" << deviceKey << "' that is not in the registry.";
         return;
     }
 
     // Check if it as an attribute
-    if (mappingTypeIt->second == MappingType::Attribute)
+    const auto& codec = m_mappingRegistry.getCodec(*slot);
+    if (m_mappingRegistry.getMappingType(*slot) == MappingType::Attribute)
     {
         // Form the attribute for this value
-        const auto attribute = formAttributeForMappingValue(mapping, bytes);
+        auto attribute = Attribute{"", DataType::BOOLEAN, ""};
+        try
+        {
+            attribute = codec.decodeAttribute(mapping->getReference(), bytes);
+        }
+        catch (const std::exception& exception)
+        {
+            LOG(ERROR) << TAG << "Failed to form an attribute for the mapping '" << mapping->getReference()
+                       << "' -> '" << exception.what() << "'.";
+        }
         if (attribute.getName().empty())
         {
             LOG(WARN) << TAG << "Received value update for '" << deviceKey << "'/'" << mapping->getReference()
                       << "' but failed to form the attribute.";
             return;
         }
-        m_attributeCallback(deviceKey, attribute);
+        std::lock_guard<std::mutex> lock{m_valueBatchMutex};
+        m_valueBatches[m_mappingRegistry.getDevice(*slot)].attributes.emplace_back(std::move(attribute));
         return;
     }
 
     // Form the reading for this value
-    const auto reading = formReadingForMappingValue(mapping, bytes);
+    auto reading = Reading{"", false};
+    try
+    {
+        reading = codec.decodeReading(mapping->getReference(), bytes);
+    }
+    catch (const std::exception& exception)
+    {
+        LOG(ERROR) << TAG << "Failed to form a reading for the mapping '" << mapping->getReference() << "' -> '"
+                   << exception.what() << "'.";
+    }
     if (reading.getReference().empty())
     {
         LOG(WARN) << TAG << "Received value update for '" << deviceKey << "'/'" << mapping->getReference()
                   << "' but failed to form the reading.";
         return;
     }
-    m_feedValueCallback(deviceKey, {reading});
-}
+    std::lock_guard<std::mutex> lock{m_valueBatchMutex};
+    auto& readings = m_valueBatches[m_mappingRegistry.getDevice(*slot)].readings;
 
-void ModbusBridge::sendOutMappingValue(const std::shared_ptr<more_modbus::ModbusDevice>& device,
-                                       const std::shared_ptr<more_modbus::RegisterMapping>& mapping, bool value)
-{
-    // Find the device key of the device that had a value update
-    const auto deviceKeyIt = m_deviceKeyBySlaveAddress.find(device->getSlaveAddress());
-    if (deviceKeyIt == m_deviceKeyBySlaveAddress.cend())
+    // Values of aggregated mappings only go into their window, the statistics are sent out once it's complete
+    if (m_windowAggregator.isAggregated(*slot))
     {
-        LOG(WARN) << TAG << "Received value update from device with a slave address that is not in the registry.";
+        const auto value = reading.isDouble() ? reading.getDoubleValue() :
+                           reading.isInt()    ? static_cast<double>(reading.getIntValue()) :
+                                                static_cast<double>(reading.getUIntValue());
+        const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::system_clock::now().time_since_epoch())
+                                 .count();
+        m_windowAggregator.sample(*slot, value, static_cast<std::uint64_t>(timestamp), readings);
         return;
     }
-    const auto deviceKey = deviceKeyIt->second;
+    readings.emplace_back(std::move(reading));
+}
 
-    // Check that there is a callback
-    if (!m_feedValueCallback)
+void ModbusBridge::sendOutMappingValue(const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                       const std::shared_ptr<more_modbus::RegisterMapping>& mapping, bool value)
+{
+    // The name of the device is its key
+    const auto& deviceKey = device->getName();
+    const auto slot = m_mappingRegistry.find(*mapping);
+    if (!slot)
     {
-        LOG(WARN) << TAG << "Received value update for '" << deviceKey << "'/'" << mapping->getReference()
-                  << "' but the callback is not set.";
+        LOG(WARN) << TAG << "Received value update from device '" << deviceKey << "' that is not in the registry.";
         return;
     }
 
-    // Form the reading for this value and call the callback
-    m_feedValueCallback(deviceKey, {Reading{mapping->getReference(), value}});
+    // Form the reading for this value and add it into the batch
+    std::lock_guard<std::mutex> lock{m_valueBatchMutex};
+    m_valueBatches[m_mappingRegistry.getDevice(*slot)].readings.emplace_back(mapping->getReference(), value);
 }
 
-Reading ModbusBridge::formReadingForMappingValue(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                                 const std::vector<std::uint16_t>& bytes)
+void ModbusBridge::sendOutDeviceValues(const std::shared_ptr<more_modbus::ModbusDevice>& device)
 {
-    try
-    {
-        switch (mapping->getOutputType())
-        {
-        case more_modbus::OutputType::UINT16:
-        {
-            const auto uint16Mapping = std::dynamic_pointer_cast<more_modbus::UInt16Mapping>(mapping);
-            return {mapping->getReference(), static_cast<std::uint64_t>(uint16Mapping->getValue())};
-        }
-        case more_modbus::OutputType::INT16:
-        {
-            const auto int16Mapping = std::dynamic_pointer_cast<more_modbus::Int16Mapping>(mapping);
-            return {mapping->getReference(), static_cast<std::int64_t>(int16Mapping->getValue())};
-        }
-        case more_modbus::OutputType::UINT32:
-        {
-            const auto uint32Mapping = std::dynamic_pointer_cast<more_modbus::UInt32Mapping>(mapping);
-            return {mapping->getReference(), static_cast<std::uint64_t>(uint32Mapping->getValue())};
-        }
-        case more_modbus::OutputType::INT32:
-        {
-            const auto int32Mapping = std::dynamic_pointer_cast<more_modbus::Int32Mapping>(mapping);
-            return {mapping->getReference(), static_cast<std::int64_t>(int32Mapping->getValue())};
-        }
-        case more_modbus::OutputType::FLOAT:
-        {
-            const auto floatMapping = std::dynamic_pointer_cast<more_modbus::FloatMapping>(mapping);
-            return {mapping->getReference(), floatMapping->getValue()};
-        }
-        case more_modbus::OutputType::STRING:
-        {
-            const auto stringMapping = std::dynamic_pointer_cast<more_modbus::StringMapping>(mapping);
-            return {mapping->getReference(), stringMapping->getValue()};
-        }
-        default:
-            return {"", false};
-        }
-    }
-    catch (const std::exception& exception)
+    const auto id = m_deviceRegistry.find(*device);
+    if (!id)
+        return;
+
+    // Take the batch out, so the callbacks are invoked without holding the lock.
+    // The windows that are over go with it, even if no sample came after them.
+    const auto timestamp =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+    auto batch = ValueBatch{};
     {
-        LOG(ERROR) << TAG << "Failed to form a reading for the mapping '" << mapping->getReference() << "' -> '"
-                   << exception.what() << "'.";
-        return {"", false};
+        std::lock_guard<std::mutex> lock{m_valueBatchMutex};
+        m_windowAggregator.closeDue(*id, static_cast<std::uint64_t>(timestamp), m_valueBatches[*id].readings);
+        std::swap(batch, m_valueBatches[*id]);
     }
-}
 
-Attribute ModbusBridge::formAttributeForMappingValue(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                                     const std::vector<std::uint16_t>& bytes)
-{
-    try
+    const auto& deviceKey = m_deviceRegistry.getKey(*id);
+    if (!batch.readings.empty())
     {
-        switch (mapping->getOutputType())
-        {
-        case more_modbus::OutputType::UINT16:
-            return {mapping->getReference(), DataType::NUMERIC, std::to_string(static_cast<std::uint64_t>(bytes[0]))};
-        case more_modbus::OutputType::INT16:
-            return {mapping->getReference(), DataType::NUMERIC, std::to_string(static_cast<std::int64_t>(bytes[0]))};
-        case more_modbus::OutputType::UINT32:
-            switch (mapping->getOperationType())
-            {
-            case more_modbus::OperationType::MERGE_BIG_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(static_cast<std::uint64_t>(
-                          more_modbus::DataParsers::registersToUint32(bytes, more_modbus::DataParsers::Endian::BIG)))};
-            case more_modbus::OperationType::MERGE_LITTLE_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(static_cast<std::uint64_t>(more_modbus::DataParsers::registersToUint32(
-                          bytes, more_modbus::DataParsers::Endian::LITTLE)))};
-            default:
-                return {"", DataType::BOOLEAN, ""};
-            }
-        case more_modbus::OutputType::INT32:
-            switch (mapping->getOperationType())
-            {
-            case more_modbus::OperationType::MERGE_BIG_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(static_cast<std::int64_t>(
-                          more_modbus::DataParsers::registersToInt32(bytes, more_modbus::DataParsers::Endian::BIG)))};
-            case more_modbus::OperationType::MERGE_LITTLE_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(static_cast<std::int64_t>(more_modbus::DataParsers::registersToInt32(
-                          bytes, more_modbus::DataParsers::Endian::LITTLE)))};
-            default:
-                return {"", DataType::BOOLEAN, ""};
-            }
-        case more_modbus::OutputType::FLOAT:
-            switch (mapping->getOperationType())
-            {
-            case more_modbus::OperationType::MERGE_FLOAT_BIG_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(
-                          more_modbus::DataParsers::registersToFloat(bytes, more_modbus::DataParsers::Endian::BIG))};
-            case more_modbus::OperationType::MERGE_FLOAT_LITTLE_ENDIAN:
-                return {mapping->getReference(), DataType::NUMERIC,
-                        std::to_string(
-                          more_modbus::DataParsers::registersToFloat(bytes, more_modbus::DataParsers::Endian::LITTLE))};
-            default:
-                return {"", DataType::NUMERIC, ""};
-            }
-        case more_modbus::OutputType::STRING:
-            switch (mapping->getOperationType())
-            {
-            case more_modbus::OperationType::STRINGIFY_ASCII_BIG_ENDIAN:
-                return {mapping->getReference(), DataType::STRING,
-                        more_modbus::DataParsers::registersToAsciiString(bytes, more_modbus::DataParsers::Endian::BIG)};
-            case more_modbus::OperationType::STRINGIFY_ASCII_LITTLE_ENDIAN:
-                return {
-                  mapping->getReference(), DataType::STRING,
-                  more_modbus::DataParsers::registersToAsciiString(bytes, more_modbus::DataParsers::Endian::LITTLE)};
-            case more_modbus::OperationType::STRINGIFY_UNICODE_BIG_ENDIAN:
-                return {
-                  mapping->getReference(), DataType::STRING,
-                  more_modbus::DataParsers::registersToUnicodeString(bytes, more_modbus::DataParsers::Endian::BIG)};
-            case more_modbus::OperationType::STRINGIFY_UNICODE_LITTLE_ENDIAN:
-                return {
-                  mapping->getReference(), DataType::STRING,
-                  more_modbus::DataParsers::registersToUnicodeString(bytes, more_modbus::DataParsers::Endian::LITTLE)};
-            default:
-                return {"", DataType::BOOLEAN, ""};
-            }
-        default:
-            return {"", DataType::BOOLEAN, ""};
-        }
+        if (m_feedValueCallback)
+            m_feedValueCallback(deviceKey, batch.readings);
+        else
+            LOG(WARN) << TAG << "Received value updates for '" << deviceKey << "' but the callback is not set.";
     }
-    catch (const std::exception& exception)
+    if (!batch.attributes.empty())
     {
-        LOG(ERROR) << TAG << "Failed to form an attribute for the mapping '" << mapping->getReference() << "' -> '"
-                   << exception.what() << "'.";
-        return {"", DataType::BOOLEAN, ""};
+        if (m_attributeCallback)
+            m_attributeCallback(deviceKey, batch.attributes);
+        else
+            LOG(WARN) << TAG << "Received attribute updates for '" << deviceKey << "' but the callback is not set.";
     }
 }
 
@@ -693,7 +624,7 @@ bool ModbusBridge::isDefaultValueReading(const Reading& reading)
     return reference.find("DFV(") == 0 && reference.rfind(')') == reference.length() - 1;
 }
 
-void ModbusBridge::handleDefaultValueReading(const std::string& deviceKey, const Reading& reading)
+void ModbusBridge::handleDefaultValueReading(DeviceRegistry::DeviceId device, const Reading& reading)
 {
     if (!isDefaultValueReading(reading))
         return;
@@ -703,9 +634,15 @@ void ModbusBridge::handleDefaultValueReading(const std::string& deviceKey, const
     const auto ref = reference.substr(reference.find("DFV(") + 4, reference.length() - 5);
     const auto& value = reading.getStringValue();
 
-    // Find all devices that have the same device type and change it for them all!
-    m_defaultValueMappingByReference[deviceKey + SEPARATOR + ref] = value;
-    m_defaultValuePersistence->storeValue(deviceKey + SEPARATOR + ref, value);
+    const auto slot = m_mappingRegistry.find(device, ref);
+    if (!slot)
+    {
+        LOG(ERROR) << "Received a `default` value for `" << m_deviceRegistry.getKey(device) << "`/`" << ref
+                   << "` - The mapping could not be found.";
+        return;
+    }
+    m_mappingRegistry.setDefaultValue(*slot, value);
+    m_defaultValuePersistence->storeValue(m_mappingRegistry.getPersistenceKey(*slot), value);
 }
 
 bool ModbusBridge::isRepeatWriteReading(const Reading& reading)
@@ -714,7 +651,7 @@ bool ModbusBridge::isRepeatWriteReading(const Reading& reading)
     return reference.find("RPW(") == 0 && reference.rfind(')') == reference.length() - 1;
 }
 
-void ModbusBridge::handleRepeatWriteReading(const std::string& deviceKey, const Reading& reading)
+void ModbusBridge::handleRepeatWriteReading(DeviceRegistry::DeviceId device, const Reading& reading)
 {
     if (!isRepeatWriteReading(reading))
         return;
@@ -723,20 +660,28 @@ void ModbusBridge::handleRepeatWriteReading(const std::string& deviceKey, const
     const auto& reference = reading.getReference();
     const auto ref = reference.substr(reference.find("RPW(") + 4, reference.length() - 5);
 
+    const auto slot = m_mappingRegistry.find(device, ref);
+    if (!slot)
+    {
+        LOG(ERROR) << "Received a `repeat` value for `" << m_deviceRegistry.getKey(device) << "`/`" << ref
+                   << "` - The mapping could not be found.";
+        return;
+    }
+
     try
     {
         // Check if the value can be parsed
         const auto value = reading.getUIntValue();
-        const auto milliseconds = std::chrono::milliseconds{};
+        const auto milliseconds = std::chrono::milliseconds{value};
 
-        // Find all devices that have the same device type and change it for them all!
-        m_repeatedWriteMappingByReference[deviceKey + SEPARATOR + ref] = milliseconds;
-        m_registerMappingByReference[deviceKey + SEPARATOR + ref]->setRepeatedWrite(milliseconds);
-        m_repeatValuePersistence->storeValue(deviceKey + SEPARATOR + ref, std::to_string(value));
+        // The scheduler of the device picks up the new period right away
+        m_mappingRegistry.setRepeat(*slot, milliseconds);
+        m_deviceRegistry.getPollScheduler(device)->setRepeatedWrite(*m_mappingRegistry.getMapping(*slot), milliseconds);
+        m_repeatValuePersistence->storeValue(m_mappingRegistry.getPersistenceKey(*slot), std::to_string(value));
     }
     catch (const std::exception& exception)
     {
-        LOG(ERROR) << "Failed to accept a new `repeat` value for `" << deviceKey << "`/`" << ref
+        LOG(ERROR) << "Failed to accept a new `repeat` value for `" << m_deviceRegistry.getKey(device) << "`/`" << ref
                    << "` - The value is not a valid number.";
         return;
     }
@@ -748,7 +693,7 @@ bool ModbusBridge::isSafeModeValueReading(const Reading& reading)
     return reference.find("SMV(") == 0 && reference.rfind(')') == reference.length() - 1;
 }
 
-void ModbusBridge::handleSafeModeValueReading(const std::string& deviceKey, const Reading& reading)
+void ModbusBridge::handleSafeModeValueReading(DeviceRegistry::DeviceId device, const Reading& reading)
 {
     if (!isSafeModeValueReading(reading))
         return;
@@ -758,8 +703,14 @@ void ModbusBridge::handleSafeModeValueReading(const std::string& deviceKey, cons
     const auto ref = reference.substr(reference.find("SMV(") + 4, reference.length() - 5);
     const auto& value = reading.getStringValue();
 
-    // Find all devices that have the same device type and change it for them all!
-    m_safeModeMappingByReference[deviceKey + SEPARATOR + ref] = value;
-    m_safeModePersistence->storeValue(deviceKey + SEPARATOR + ref, value);
+    const auto slot = m_mappingRegistry.find(device, ref);
+    if (!slot)
+    {
+        LOG(ERROR) << "Received a `safe mode` value for `" << m_deviceRegistry.getKey(device) << "`/`" << ref
+                   << "` - The mapping could not be found.";
+        return;
+    }
+    m_mappingRegistry.setSafeModeValue(*slot, value);
+    m_safeModePersistence->storeValue(m_mappingRegistry.getPersistenceKey(*slot), value);
 }
 }    // namespace wolkabout::modbus
@@ -20,9 +20,14 @@
 #include "WolkConnect-Cpp/WolkSDK-Cpp/core/utilities/StringUtils.h"
 #include "core/model/Device.h"
 #include "core/utilities/Logger.h"
+#include "modbus/model/DeviceInformation.h"
 #include "modbus/model/DeviceTemplate.h"
+#include "modbus/module/DeviceRegistry.h"
+#include "modbus/module/MappingRegistry.h"
+#include "modbus/module/WindowAggregator.h"
 #include "modbus/module/persistence/KeyValuePersistence.h"
-#include "more_modbus/ModbusReader.h"
+#include "modbus/module/polling/PollScheduler.h"
+#include "modbus/module/transport/ModbusTransport.h"
 #include "wolk/api/FeedUpdateHandler.h"
 #include "wolk/api/ParameterHandler.h"
 #include "wolk/api/PlatformStatusListener.h"
@@ -32,6 +37,7 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -41,11 +47,6 @@ using namespace wolkabout::legacy;
 
 namespace wolkabout
 {
-namespace more_modbus
-{
-class ModbusClient;
-}
-
 namespace modbus
 {
 class ModuleMapping;
@@ -68,20 +69,22 @@ public:
      *          -1 is created, and then copied over foreach device of such template.
      *          Value/status change listeners are also setup in here, next to all the maps of data/pointers
      *          that are necessary, such as mapping maps, status maps.
-     * @param modbusClient setup client that will be used for the modbus reader.
-     * @param configurationTemplates all configuration templates,
-     * @param deviceAddressesByTemplate
-     * @param devices
+     * @param transports setup transports by the name of their bus, every transport will have its own poll scheduler.
      * @param registerReadPeriod
+     * @param readGapTolerance count of unused registers that can be read to merge mappings into one request.
+     * @param healthPolicy the rules by which unresponsive devices are quarantined.
+     * @param readAfterWriteWindow time in which the reads after writes into a device are collected.
      */
-    ModbusBridge(std::shared_ptr<more_modbus::ModbusClient> modbusClient, std::chrono::milliseconds registerReadPeriod,
+    ModbusBridge(std::map<std::string, std::shared_ptr<ModbusTransport>> transports,
+                 std::chrono::milliseconds registerReadPeriod, std::uint16_t readGapTolerance,
+                 HealthPolicy healthPolicy, std::chrono::milliseconds readAfterWriteWindow,
                  std::unique_ptr<KeyValuePersistence> defaultValuePersistence,
                  std::unique_ptr<KeyValuePersistence> repeatValuePersistence,
                  std::unique_ptr<KeyValuePersistence> safeModePersistence);
 
     /**
      * Default overridden destructor.
-     * Will stop the modbus reader and disconnect the modbus client.
+     * Will stop the poll schedulers and the transports.
      */
     ~ModbusBridge() override;
 
@@ -91,19 +94,28 @@ public:
      *
      * @param templates This is the map containing the templates that are imported from the
      * DevicesConfiguration.
-     * @param deviceAddressesByTemplate This is the map containing the list of devices that belong to each template.
-     * @param devices This is the map of generated devices by the device generator.
+     * @param deviceKeysByTemplate This is the map containing the keys of devices that belong to each template.
+     * @param devices This is the map of devices, by their keys, that passed the validation of the device generator.
      */
     virtual void initialize(const std::map<std::string, std::unique_ptr<DeviceTemplate>>& templates,
-                            const std::map<std::string, std::vector<std::uint16_t>>& deviceAddressesByTemplate,
-                            const std::map<std::uint16_t, std::unique_ptr<Device>>& devices);
+                            const std::map<std::string, std::vector<std::string>>& deviceKeysByTemplate,
+                            const std::map<std::string, std::unique_ptr<DeviceInformation>>& devices);
 
     /**
-     * @brief Get the running status of the Modbus reader.
+     * @brief Get the running status of the poll schedulers.
      * @return
      */
     bool isRunning() const;
 
+    /**
+     * @brief Whether every value of a feed needs to be sent. Values of the mappings that aren't marked as lossless
+     *        can be compacted to the newest one while the platform is unreachable.
+     * @param deviceKey The key of the device.
+     * @param reference The reference of the feed.
+     * @return Whether the feed is lossless, true for the feeds that aren't mappings.
+     */
+    bool isLossless(const std::string& deviceKey, const std::string& reference) const;
+
     /**
      * @brief Setter for the callback which will be invoked once a feed value has been updated.
      * @param feedValueCallback The callback that will be invoked once a feed value has been updated.
@@ -112,18 +124,19 @@ public:
       const std::function<void(const std::string&, const std::vector<Reading>&)>& feedValueCallback);
 
     /**
-     * @brief Setter for the callback which will be invoked once an attribute value has been updated.
-     * @param attributeCallback The callback that will be invoked once an attribute value has been updated.
+     * @brief Setter for the callback which will be invoked once attribute values have been updated.
+     * @param attributeCallback The callback that will be invoked once attribute values have been updated.
      */
-    void setAttributeCallback(const std::function<void(const std::string&, const Attribute&)>& attributeCallback);
+    void setAttributeCallback(
+      const std::function<void(const std::string&, const std::vector<Attribute>&)>& attributeCallback);
 
     /**
-     * @brief Start the modbus reader logic.
+     * @brief Start the poll schedulers of all buses.
      */
     void start();
 
     /**
-     * @brief Stop the modbus reader logic.
+     * @brief Stop the poll schedulers of all buses.
      */
     void stop();
 
@@ -156,75 +169,53 @@ public:
 
 private:
     /**
-     * This is a part of the initialize that will set up the device callbacks.
-     *
-     * @param devices The devices for which the callbacks need to be set up.
-     */
-    void initializeSetUpDeviceCallback(const std::vector<std::shared_ptr<more_modbus::ModbusDevice>>& device);
-
-    /**
-     * This is a helper method that is used to write in a map of values into the mappings.
-     *
-     * @param mapOfValues A map containing references to mappings and values for them.
+     * This is a part of the initialize that will set up the device callbacks on the poll schedulers.
      */
-    void writeAMapOfValues(const std::map<std::string, std::string>& mapOfValues);
+    void initializeSetUpDeviceCallback();
 
     /**
-     * This is a helper method that is used for preparing DefaultValue, RepeatWriteValue and SafeModeValue maps to be
-     * sent out as Readings.
+     * This is a helper method that is used to write in values into the mappings.
+     * The values are written in blocks of adjacent addresses, and the buses are written at the same time. The values
+     * that were written are sent out to the platform.
      *
-     * @param readings The map of readings where they need to be inserted.
-     * @param map The map of values.
-     * @param prefix The prefix that is going to be put for the reading.
+     * @param values The slots of the mappings in the registry, with the values for them.
      */
-    template <typename T>
-    static void makeReadingsFromMap(std::map<std::string, std::vector<Reading>>& readings,
-                                    const std::map<std::string, T>& map, const std::string& prefix);
+    void writeValues(const std::vector<std::pair<MappingRegistry::Slot, std::string>>& values);
 
     /**
-     * This is a helper method that is used to go up a chain of weak pointers to attempt to notify a device of a mapping
-     * value change. This is used for when a boolean value has changed.
+     * This is a helper method that parses a value with the codec of the mapping, and encodes it into registers, or a
+     * bit for boolean mappings.
      *
-     * @param mapping The mapping that changed its value.
+     * @param slot The slot of the mapping for which the value is meant.
+     * @param value The value.
+     * @return The encoded value. Throws if the value is not valid for the mapping.
      */
-    void triggerGroupValueChangeBool(const std::shared_ptr<more_modbus::RegisterMapping>& mapping);
+    PollScheduler::MappingWrite encodeValue(MappingRegistry::Slot slot, const std::string& value) const;
 
     /**
-     * This is a helper method that is used to go up a chain of weak pointers to attempt to notify a device of a mapping
-     * value change. This is used for when a value in bytes has changed.
+     * This is a helper method that is used for preparing DefaultValues, RepeatWriteValues and SafeModeValues of all
+     * the mappings to be sent out as Readings.
      *
-     * @param mapping The mapping that changed its value.
+     * @return The readings, by the device key.
      */
-    void triggerGroupValueChangeBytes(const std::shared_ptr<more_modbus::RegisterMapping>& mapping);
+    std::map<std::string, std::vector<Reading>> makeConfigurationReadings() const;
 
     /**
      * This is a helper method that is used to initiate a value write into a mapping.
-     * This call routes the call to a downcast version of the mapping, where the specific `writeValue` method of the
-     * mapping type will be called.
+     * The value is encoded by `encodeValue`, and written through the poll scheduler of the device.
      *
-     * @param mapping The mapping pointer of the mapping that needs to change.
+     * @param slot The slot of the mapping that needs to change.
      * @param value The new value for the mapping.
+     * @return Whether the value was written.
      */
-    void writeToMapping(const std::shared_ptr<more_modbus::RegisterMapping>& mapping, const std::string& value);
-
-    /**
-     * This is a helper method that will downcast the pointer and invoke the right method for the specific mapping.
-     *
-     * @tparam RegisterMappingType The specific type for the mapping, a type that derives from
-     * `more_modbus::RegisterMapping` and contains a method `writeValue`.
-     * @tparam Value The type of the value that is passed to the `writeValue` call.
-     * @param mapping The mapping pointer of the mapping that needs to change.
-     * @param value The new value for the mapping already converted into the right type.
-     */
-    template <class RegisterMappingType, class Value>
-    void writeToMappingSpecific(const std::shared_ptr<more_modbus::RegisterMapping>& mapping, const Value& value);
+    bool writeToMapping(MappingRegistry::Slot slot, const std::string& value);
 
     /**
-     * This is a helper method that will go through all the steps necessary to invoke a callback to send out a value to
-     * either the feed value callback or the attribute callback.
+     * This is a helper method that will go through all the steps necessary to form a reading or an attribute out of
+     * a value, and add it into the batch of the device, which is sent out once the poll cycle of the device completes.
      *
      * @param device The device that is updating its value.
-     * @param mapping The mapping for which the callback needs to be invoked.
+     * @param mapping The mapping for which the value needs to be sent out.
      * @param value The value in bytes that needs to be sent out.
      */
     void sendOutMappingValue(const std::shared_ptr<more_modbus::ModbusDevice>& device,
@@ -232,37 +223,23 @@ private:
                              const std::vector<std::uint16_t>& bytes);
 
     /**
-     * This is a helper method that will go through all the steps necessary to invoke a callback to send out a value to
-     * either the feed value callback or the attribute callback.
+     * This is a helper method that will form a reading out of a value, and add it into the batch of the device, which
+     * is sent out once the poll cycle of the device completes.
      *
      * @param device The device that is updating its value.
-     * @param mapping The mapping for which the callback needs to be invoked.
+     * @param mapping The mapping for which the value needs to be sent out.
      * @param value The boolean value that needs to be sent out.
      */
     void sendOutMappingValue(const std::shared_ptr<more_modbus::ModbusDevice>& device,
                              const std::shared_ptr<more_modbus::RegisterMapping>& mapping, bool value);
 
     /**
-     * This is a helper method that will form a reading for the mapping based on its type. It will use the new data
-     * that has been read from the mapping.
-     *
-     * @param mapping The mapping from which the value needs to be obtained.
-     * @param bytes The bytes that form the data.
-     * @return The reading that has been formed for the new data.
-     */
-    Reading formReadingForMappingValue(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                       const std::vector<std::uint16_t>& bytes);
-
-    /**
-     * This is a helper method that will form an attribute for the mapping based on its type. It will use the new data
-     * that has been read from the mapping.
+     * This is a helper method that sends out the batch of values of a device, invoking the feed value callback and
+     * the attribute callback at most once each.
      *
-     * @param mapping The mapping from which the value needs to be obtained.
-     * @param bytes The bytes that form the data.
-     * @return The attribute that has been formed for the new data.
+     * @param device The device that completed its poll cycle.
      */
-    Attribute formAttributeForMappingValue(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                           const std::vector<std::uint16_t>& bytes);
+    void sendOutDeviceValues(const std::shared_ptr<more_modbus::ModbusDevice>& device);
 
     /**
      * This is a helper method for the `handleUpdate` method that returns whether a Reading is meant to change a
@@ -277,9 +254,10 @@ private:
      * This is a helper method for the `handleUpdate` method that handles a Reading meant to change a DefaultValue of a
      * different feed.
      *
+     * @param device The device for which the reading has been sent.
      * @param reading The reading that contains a new value for a DefaultValue of a feed.
      */
-    void handleDefaultValueReading(const std::string& deviceKey, const Reading& reading);
+    void handleDefaultValueReading(DeviceRegistry::DeviceId device, const Reading& reading);
 
     /**
      * This is a helper method for the `handleUpdate` method that returns whether a Reading is meant to change a
@@ -294,9 +272,10 @@ private:
      * This is a helper method for the `handleUpdate` method that handles a Reading meant to change a RepeatWrite of a
      * different feed.
      *
+     * @param device The device for which the reading has been sent.
      * @param reading The reading that contains a new value for a RepeatWrite of a feed.
      */
-    void handleRepeatWriteReading(const std::string& deviceKey, const Reading& reading);
+    void handleRepeatWriteReading(DeviceRegistry::DeviceId device, const Reading& reading);
 
     /**
      * This is a helper method for the `handleUpdate` method that returns whether a Reading is meant to change a
@@ -311,34 +290,41 @@ private:
      * This is a helper method for the `handleUpdate` method that handles a Reading meant to change a SafeModeValue of a
      * different feed.
      *
+     * @param device The device for which the reading has been sent.
      * @param reading The reading that contains a new value for a SafeModeValue of a feed.
      */
-    void handleSafeModeValueReading(const std::string& deviceKey, const Reading& reading);
+    void handleSafeModeValueReading(DeviceRegistry::DeviceId device, const Reading& reading);
 
-    // Methods to help with data query
-    int getSlaveAddress(const std::string& deviceKey);
-
-    // Separator used in maps for device key/reference combinations
-    static const char SEPARATOR;
     const std::string TAG = "[ModbusBridge] -> ";
 
-    // The client
-    std::shared_ptr<more_modbus::ModbusClient> m_modbusClient;
+    // The transports, by the name of their bus. Buses can share a transport.
+    std::map<std::string, std::shared_ptr<ModbusTransport>> m_transports;
 
-    // The reader
-    std::shared_ptr<more_modbus::ModbusReader> m_modbusReader;
+    // The schedulers reading the devices, one per transport
+    std::vector<std::unique_ptr<PollScheduler>> m_pollSchedulers;
+    std::map<std::string, PollScheduler*> m_pollSchedulerByBus;
     std::chrono::milliseconds m_registerReadPeriod;
+    std::uint16_t m_readGapTolerance;
+    HealthPolicy m_healthPolicy;
+    std::chrono::milliseconds m_readAfterWriteWindow;
+
+    // The values every device produced in its current poll cycle, by the device
+    struct ValueBatch
+    {
+        std::vector<Reading> readings;
+        std::vector<Attribute> attributes;
+    };
 
-    // Used to fast decode deviceKey by slaveAddress.
-    std::map<int, std::string> m_deviceKeyBySlaveAddress;
-    // Device status
+    // The registry of known devices, used to fast find a device by its key or its address, and its scheduler.
+    DeviceRegistry m_deviceRegistry;
     // Watcher for all the mappings. This is the shortcut for handle and get queries to get to the mapping they need.
-    std::map<std::string, std::shared_ptr<more_modbus::RegisterMapping>> m_registerMappingByReference;
-    std::map<std::string, std::string> m_defaultValueMappingByReference;
-    std::map<std::string, std::chrono::milliseconds> m_repeatedWriteMappingByReference;
-    std::map<std::string, std::string> m_safeModeMappingByReference;
-    std::map<std::string, MappingType> m_registerMappingTypeByReference;
-    std::map<std::string, bool> m_autoReadByReference;
+    MappingRegistry m_mappingRegistry;
+
+    // The batches of values, guarded by their own lock, as the devices on different buses report from other threads
+    std::vector<ValueBatch> m_valueBatches;
+    std::mutex m_valueBatchMutex;
+    // The windows of the aggregated mappings, guarded by the lock of the batches
+    WindowAggregator m_windowAggregator;
 
     // Store connectivity status
     ConnectivityStatus m_connectivityStatus;
@@ -350,60 +336,8 @@ private:
 
     // Callbacks that will be invoked with new values once they appear
     std::function<void(const std::string&, const std::vector<Reading>&)> m_feedValueCallback;
-    std::function<void(const std::string& deviceKey, const Attribute& attribute)> m_attributeCallback;
+    std::function<void(const std::string& deviceKey, const std::vector<Attribute>& attributes)> m_attributeCallback;
 };
-
-template <class RegisterMappingType, class Value>
-void ModbusBridge::writeToMappingSpecific(const std::shared_ptr<more_modbus::RegisterMapping>& mapping,
-                                          const Value& value)
-{
-    // Downcast the mapping pointer
-    const auto castMapping = std::dynamic_pointer_cast<RegisterMappingType>(mapping);
-    if (castMapping == nullptr)
-    {
-        LOG(WARN) << TAG << "Failed to downcast the RegisterMapping to '" << typeid(RegisterMappingType).name() << "'.";
-        return;
-    }
-
-    // Write in the value
-    try
-    {
-        castMapping->writeValue(value);
-    }
-    catch (const std::exception& exception)
-    {
-        LOG(WARN) << TAG << "Failed to write value to '" << typeid(RegisterMappingType).name() << "' -> '"
-                  << exception.what() << "'.";
-    }
-}
-
-template <class T> std::string toString(const T& value)
-{
-    return value;
-}
-
-template <> std::string toString(const std::chrono::milliseconds& value)
-{
-    return std::to_string(value.count());
-}
-
-template <class T>
-void ModbusBridge::makeReadingsFromMap(std::map<std::string, std::vector<Reading>>& readings,
-                                       const std::map<std::string, T>& map, const std::string& prefix)
-{
-    for (const auto& pair : map)
-    {
-        // Separate the key
-        const auto tokens = StringUtils::tokenize(pair.first, SEPARATOR);
-        if (tokens.empty())
-            continue;
-        const auto& deviceKey = tokens[0];
-        const auto& reference = tokens[1];
-
-        // Make a reading and push it into the array
-        readings[deviceKey].emplace_back(prefix + "(" + reference + ")", toString(pair.second));
-    }
-}
 }    // namespace modbus
 }    // namespace wolkabout
 
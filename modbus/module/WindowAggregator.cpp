@@ -0,0 +1,111 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/WindowAggregator.h"
+
+#include <algorithm>
+
+namespace wolkabout::modbus
+{
+void WindowAggregator::add(DeviceRegistry::DeviceId device, MappingRegistry::Slot slot, const std::string& reference,
+                           std::chrono::milliseconds window, const std::vector<AggregationStatistic>& statistics)
+{
+    if (m_windows.size() <= slot)
+        m_windows.resize(slot + std::size_t{1}, Window{0, 0, 0, 0.0, 0.0, 0.0, 0.0, {}});
+    if (m_slotsByDevice.size() <= device)
+        m_slotsByDevice.resize(device + std::size_t{1});
+
+    auto& slots = m_slotsByDevice[device];
+    if (std::find(slots.cbegin(), slots.cend(), slot) == slots.cend())
+        slots.emplace_back(slot);
+
+    auto& state = m_windows[slot];
+    state.length = static_cast<std::uint64_t>(window.count());
+    state.feeds.clear();
+    for (const auto statistic : statistics)
+        state.feeds.emplace_back(statistic, toString(statistic) + "(" + reference + ")");
+}
+
+bool WindowAggregator::isAggregated(MappingRegistry::Slot slot) const
+{
+    return slot < m_windows.size() && m_windows[slot].length > 0;
+}
+
+void WindowAggregator::sample(MappingRegistry::Slot slot, double value, std::uint64_t timestamp,
+                              std::vector<Reading>& readings)
+{
+    auto& state = m_windows[slot];
+
+    // Send out the window the sample is past
+    if (state.count > 0 && timestamp >= state.end)
+        close(state, readings);
+
+    // Start the window the sample is in
+    if (state.count == 0)
+    {
+        state.end = (timestamp / state.length + 1) * state.length;
+        state.sum = 0.0;
+        state.minimum = value;
+        state.maximum = value;
+    }
+
+    ++state.count;
+    state.sum += value;
+    state.minimum = std::min(state.minimum, value);
+    state.maximum = std::max(state.maximum, value);
+    state.last = value;
+}
+
+void WindowAggregator::closeDue(DeviceRegistry::DeviceId device, std::uint64_t timestamp,
+                                std::vector<Reading>& readings)
+{
+    if (m_slotsByDevice.size() <= device)
+        return;
+
+    for (const auto slot : m_slotsByDevice[device])
+    {
+        auto& state = m_windows[slot];
+        if (state.count > 0 && timestamp >= state.end)
+            close(state, readings);
+    }
+}
+
+void WindowAggregator::close(Window& window, std::vector<Reading>& readings)
+{
+    for (const auto& feed : window.feeds)
+    {
+        switch (feed.first)
+        {
+        case AggregationStatistic::Minimum:
+            readings.emplace_back(feed.second, window.minimum, window.end);
+            break;
+        case AggregationStatistic::Maximum:
+            readings.emplace_back(feed.second, window.maximum, window.end);
+            break;
+        case AggregationStatistic::Average:
+            readings.emplace_back(feed.second, window.sum / static_cast<double>(window.count), window.end);
+            break;
+        case AggregationStatistic::Last:
+            readings.emplace_back(feed.second, window.last, window.end);
+            break;
+        case AggregationStatistic::Count:
+            readings.emplace_back(feed.second, window.count, window.end);
+            break;
+        }
+    }
+    window.count = 0;
+}
+}    // namespace wolkabout::modbus
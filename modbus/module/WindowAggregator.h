@@ -0,0 +1,110 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_WINDOWAGGREGATOR_H
+#define WOLKGATEWAYMODBUSMODULE_WINDOWAGGREGATOR_H
+
+#include "core/Types.h"
+#include "modbus/model/AggregationStatistic.h"
+#include "modbus/module/MappingRegistry.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Running statistics of the aggregated mappings, over windows of time.
+ * @details Every sample of an aggregated mapping only updates the running count, sum, minimum, maximum and the last
+ *          value of its window, so a sample takes the same time however long the window is. The windows are aligned
+ *          to the wall clock, so a window of a minute starts at the full minute. Once the window is over, either when a
+ *          sample arrives after its end, or when its device completes a poll cycle after its end, the statistics of the
+ *          window are sent out as readings of the derived feeds, such as `AVG(reference)`, timestamped with the end of
+ *          the window. The next window starts with the next sample.
+ *          Must be used under the same lock as the values it produces.
+ */
+class WindowAggregator
+{
+public:
+    /**
+     * This is the method that sets up the aggregation of a mapping.
+     *
+     * @param device The device of the mapping.
+     * @param slot The slot of the mapping.
+     * @param reference The reference of the mapping.
+     * @param window The length of the window.
+     * @param statistics The statistics sent out for every window.
+     */
+    void add(DeviceRegistry::DeviceId device, MappingRegistry::Slot slot, const std::string& reference,
+             std::chrono::milliseconds window, const std::vector<AggregationStatistic>& statistics);
+
+    bool isAggregated(MappingRegistry::Slot slot) const;
+
+    /**
+     * This is the method that adds a sample into the window of a mapping. If the sample is past the end of the window,
+     * the statistics of the window are added to the readings first.
+     *
+     * @param slot The slot of the mapping.
+     * @param value The value of the sample.
+     * @param timestamp The time of the sample, in milliseconds since the epoch.
+     * @param readings The readings to which the statistics of a complete window are added.
+     */
+    void sample(MappingRegistry::Slot slot, double value, std::uint64_t timestamp, std::vector<Reading>& readings);
+
+    /**
+     * This is the method that adds the statistics of the windows of a device that are over to the readings, so a
+     * window is sent out even if no sample follows it.
+     *
+     * @param device The device.
+     * @param timestamp The current time, in milliseconds since the epoch.
+     * @param readings The readings to which the statistics of the complete windows are added.
+     */
+    void closeDue(DeviceRegistry::DeviceId device, std::uint64_t timestamp, std::vector<Reading>& readings);
+
+private:
+    // The running statistics of the current window of a mapping
+    struct Window
+    {
+        std::uint64_t length;
+        std::uint64_t end;
+        std::uint64_t count;
+        double sum;
+        double minimum;
+        double maximum;
+        double last;
+
+        // The statistics, with the references of their feeds
+        std::vector<std::pair<AggregationStatistic, std::string>> feeds;
+    };
+
+    /**
+     * This is a helper method that adds the statistics of a window to the readings, and empties the window.
+     *
+     * @param window The window.
+     * @param readings The readings to which the statistics are added.
+     */
+    static void close(Window& window, std::vector<Reading>& readings);
+
+    std::vector<Window> m_windows;
+    // The slots of the aggregated mappings, by the device
+    std::vector<std::vector<MappingRegistry::Slot>> m_slotsByDevice;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_WINDOWAGGREGATOR_H
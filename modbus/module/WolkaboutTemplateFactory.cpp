@@ -20,6 +20,8 @@ namespace wolkabout
 {
 namespace modbus
 {
+const std::string WolkaboutTemplateFactory::DEVICE_STATUS_REFERENCE = "DEVICE_STATUS";
+
 std::unique_ptr<wolkabout::DeviceRegistrationData>
 WolkaboutTemplateFactory::makeRegistrationDataFromDeviceConfigTemplate(const DeviceTemplate& configTemplate)
 {
@@ -66,8 +68,21 @@ WolkaboutTemplateFactory::makeRegistrationDataFromDeviceConfigTemplate(const Dev
                    mapping.getUnit().empty() ? toString(dataType) : mapping.getUnit()};
             feeds.emplace(defaultValueFeed.getReference(), std::move(defaultValueFeed));
         }
+        for (const auto statistic : mapping.getAggregationStatistics())
+        {
+            const auto unit = mapping.getUnit().empty() || statistic == AggregationStatistic::Count ?
+                                toString(DataType::NUMERIC) :
+                                mapping.getUnit();
+            auto statisticFeed = Feed{getStatisticName(statistic) + " of " + mapping.getName(),
+                                      toString(statistic) + "(" + mapping.getReference() + ")", FeedType::IN, unit};
+            feeds.emplace(statisticFeed.getReference(), std::move(statisticFeed));
+        }
     }
 
+    // Every device reports whether it responds
+    feeds.emplace(DEVICE_STATUS_REFERENCE,
+                  Feed{"Device status", DEVICE_STATUS_REFERENCE, FeedType::IN, toString(DataType::STRING)});
+
     // Return the empty DeviceRegistrationData value with the generated feeds and attributes.
     return std::unique_ptr<DeviceRegistrationData>(
       new DeviceRegistrationData{"", "", "", {{ParameterName::OUTBOUND_DATA_MODE, "PUSH"}}, feeds, attributes});
@@ -93,6 +108,24 @@ DataType WolkaboutTemplateFactory::getDataTypeFromMapping(const ModuleMapping& m
     }
 }
 
+std::string WolkaboutTemplateFactory::getStatisticName(AggregationStatistic statistic)
+{
+    switch (statistic)
+    {
+    case AggregationStatistic::Minimum:
+        return "Minimum";
+    case AggregationStatistic::Maximum:
+        return "Maximum";
+    case AggregationStatistic::Average:
+        return "Average";
+    case AggregationStatistic::Last:
+        return "Last value";
+    case AggregationStatistic::Count:
+        return "Sample count";
+    }
+    return {};
+}
+
 FeedType WolkaboutTemplateFactory::getFeedTypeFromMapping(const ModuleMapping& mapping)
 {
     switch (mapping.getMappingType())
@@ -19,6 +19,7 @@
 
 #include "core/Types.h"
 #include "core/model/messages/DeviceRegistrationMessage.h"
+#include "modbus/model/AggregationStatistic.h"
 #include "modbus/model/DeviceTemplate.h"
 #include "more_modbus/RegisterMapping.h"
 
@@ -33,6 +34,9 @@ namespace modbus
 class WolkaboutTemplateFactory
 {
 public:
+    // The reference of the feed every device reports its status into
+    static const std::string DEVICE_STATUS_REFERENCE;
+
     /**
      * @brief Return the entire DeviceTemplate necessary for the Wolk instance to register the device.
      * @param configTemplate template passed from the configuration file.
@@ -49,6 +53,13 @@ private:
      */
     static DataType getDataTypeFromMapping(const ModuleMapping& mapping);
 
+    /**
+     * @brief Return the name of a statistic, used in the names of the feeds of aggregated mappings.
+     * @param statistic The statistic for which the name needs to be obtained.
+     * @return The readable name of the statistic.
+     */
+    static std::string getStatisticName(AggregationStatistic statistic);
+
     /**
      * @brief Return the default feed type for the mapping.
      * @param mapping The mapping for which the feed type needs to be obtained.
@@ -0,0 +1,186 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/outbound/OutboundBuffer.h"
+
+#include "core/utilities/Logger.h"
+
+#include <unordered_set>
+#include <utility>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+OutboundBuffer::OutboundBuffer(std::size_t memoryLimit, LosslessCheck losslessCheck)
+: m_memoryLimit(memoryLimit)
+, m_losslessCheck(std::move(losslessCheck))
+, m_attributeCount(0)
+, m_memoryUsage(0)
+, m_compacted(0)
+, m_evicted(0)
+{
+}
+
+void OutboundBuffer::addReadings(const std::string& deviceKey, std::vector<Reading>&& readings,
+                                 std::uint64_t timestamp)
+{
+    const auto device = indexOf(deviceKey);
+    for (auto& reading : readings)
+    {
+        const auto lossless = !m_losslessCheck || m_losslessCheck(deviceKey, reading.getReference());
+        const auto bytes = sizeOf(reading);
+        m_readings.emplace_back(PendingReading{device, timestamp, std::move(reading), lossless, bytes});
+        m_memoryUsage += bytes;
+    }
+    enforceLimit();
+}
+
+void OutboundBuffer::addAttributes(const std::string& deviceKey, std::vector<Attribute>&& attributes)
+{
+    auto& deviceAttributes = m_attributes[indexOf(deviceKey)];
+    for (auto& attribute : attributes)
+    {
+        const auto it = deviceAttributes.find(attribute.getName());
+        if (it != deviceAttributes.cend())
+        {
+            m_memoryUsage -= sizeOf(it->second);
+            deviceAttributes.erase(it);
+            --m_attributeCount;
+        }
+        m_memoryUsage += sizeOf(attribute);
+        deviceAttributes.emplace(attribute.getName(), std::move(attribute));
+        ++m_attributeCount;
+    }
+}
+
+void OutboundBuffer::flush(const ReadingsCallback& readingsCallback, const AttributesCallback& attributesCallback)
+{
+    auto readingsByDevice = std::vector<std::vector<Reading>>(m_deviceKeys.size());
+    for (auto& pending : m_readings)
+        readingsByDevice[pending.device].emplace_back(std::move(pending.reading));
+    m_readings.clear();
+
+    for (auto device = std::size_t{0}; device < m_deviceKeys.size(); ++device)
+    {
+        if (!readingsByDevice[device].empty() && readingsCallback)
+            readingsCallback(m_deviceKeys[device], readingsByDevice[device]);
+        if (!m_attributes[device].empty() && attributesCallback)
+        {
+            auto attributes = std::vector<Attribute>{};
+            attributes.reserve(m_attributes[device].size());
+            for (auto& attribute : m_attributes[device])
+                attributes.emplace_back(std::move(attribute.second));
+            attributesCallback(m_deviceKeys[device], attributes);
+        }
+        m_attributes[device].clear();
+    }
+    m_attributeCount = 0;
+    m_memoryUsage = 0;
+}
+
+void OutboundBuffer::takeReadings(
+  const std::function<void(const std::string&, std::uint64_t, const Reading&)>& callback)
+{
+    for (const auto& pending : m_readings)
+    {
+        callback(m_deviceKeys[pending.device], pending.timestamp, pending.reading);
+        m_memoryUsage -= pending.bytes;
+    }
+    m_readings.clear();
+}
+
+std::size_t OutboundBuffer::size() const
+{
+    return m_readings.size() + m_attributeCount;
+}
+
+std::size_t OutboundBuffer::getMemoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+std::uint64_t OutboundBuffer::getCompactedCount() const
+{
+    return m_compacted;
+}
+
+std::uint64_t OutboundBuffer::getEvictedCount() const
+{
+    return m_evicted;
+}
+
+std::uint32_t OutboundBuffer::indexOf(const std::string& deviceKey)
+{
+    const auto it = m_deviceIndexes.find(deviceKey);
+    if (it != m_deviceIndexes.cend())
+        return it->second;
+
+    const auto index = static_cast<std::uint32_t>(m_deviceKeys.size());
+    m_deviceKeys.emplace_back(deviceKey);
+    m_attributes.emplace_back();
+    m_deviceIndexes.emplace(deviceKey, index);
+    return index;
+}
+
+void OutboundBuffer::enforceLimit()
+{
+    if (m_memoryUsage <= m_memoryLimit)
+        return;
+
+    // Go from the newest reading, and keep only the first one seen of every feed that isn't lossless
+    auto seen = std::vector<std::unordered_set<std::string>>(m_deviceKeys.size());
+    auto kept = std::deque<PendingReading>{};
+    auto compacted = std::uint64_t{0};
+    for (auto it = m_readings.rbegin(); it != m_readings.rend(); ++it)
+    {
+        if (!it->lossless && !seen[it->device].emplace(it->reading.getReference()).second)
+        {
+            m_memoryUsage -= it->bytes;
+            ++compacted;
+            continue;
+        }
+        kept.emplace_front(std::move(*it));
+    }
+    m_readings.swap(kept);
+
+    // If the history of the lossless feeds still takes up too much, the oldest readings have to go
+    auto evicted = std::uint64_t{0};
+    const auto lowWatermark = m_memoryLimit / 4 * 3;
+    while (m_memoryUsage > lowWatermark && !m_readings.empty())
+    {
+        m_memoryUsage -= m_readings.front().bytes;
+        m_readings.pop_front();
+        ++evicted;
+    }
+
+    m_compacted += compacted;
+    m_evicted += evicted;
+    LOG(WARN) << TAG << "Exceeded the limit of " << m_memoryLimit << " bytes - compacted " << compacted
+              << " and evicted " << evicted << " reading(s), " << m_readings.size() << " reading(s) remain.";
+}
+
+std::size_t OutboundBuffer::sizeOf(const Reading& reading)
+{
+    return sizeof(PendingReading) + reading.getReference().size() +
+           (reading.isString() ? reading.getStringValue().size() : 0);
+}
+
+std::size_t OutboundBuffer::sizeOf(const Attribute& attribute)
+{
+    return sizeof(Attribute) + 2 * attribute.getName().size() + attribute.getValue().size();
+}
+}    // namespace wolkabout::modbus
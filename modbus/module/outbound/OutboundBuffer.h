@@ -0,0 +1,151 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_OUTBOUNDBUFFER_H
+#define WOLKGATEWAYMODBUSMODULE_OUTBOUNDBUFFER_H
+
+#include "core/Types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Class holding the values that wait to be published, within a memory limit.
+ * @details Readings are kept in the order they came in, and only the newest value of every attribute is kept. Once the
+ *          values take up more than the limit, the readings of the feeds that aren't lossless are compacted to the
+ *          newest one per feed. If that doesn't bring the buffer under three quarters of the limit, the oldest
+ *          readings are evicted until it does, so the buffer is not compacted again with every new value.
+ *          Must only be used from a single thread, except for the counters.
+ */
+class OutboundBuffer
+{
+public:
+    using ReadingsCallback = std::function<void(const std::string&, const std::vector<Reading>&)>;
+    using AttributesCallback = std::function<void(const std::string&, const std::vector<Attribute>&)>;
+    using LosslessCheck = std::function<bool(const std::string&, const std::string&)>;
+
+    /**
+     * Default constructor for the buffer.
+     *
+     * @param memoryLimit The count of bytes the values can take up before they are compacted.
+     * @param losslessCheck The check whether every value of a feed of a device needs to be kept.
+     */
+    OutboundBuffer(std::size_t memoryLimit, LosslessCheck losslessCheck);
+
+    /**
+     * This is the method that adds the readings of a device.
+     *
+     * @param deviceKey The key of the device.
+     * @param readings The readings.
+     * @param timestamp The time the readings were made, in milliseconds.
+     */
+    void addReadings(const std::string& deviceKey, std::vector<Reading>&& readings, std::uint64_t timestamp);
+
+    /**
+     * This is the method that adds the attributes of a device, replacing the values of the same attributes.
+     *
+     * @param deviceKey The key of the device.
+     * @param attributes The attributes.
+     */
+    void addAttributes(const std::string& deviceKey, std::vector<Attribute>&& attributes);
+
+    /**
+     * This is the method that hands over all the values, grouped by the device, and empties the buffer.
+     *
+     * @param readingsCallback The callback receiving the readings of a device.
+     * @param attributesCallback The callback receiving the attributes of a device.
+     */
+    void flush(const ReadingsCallback& readingsCallback, const AttributesCallback& attributesCallback);
+
+    /**
+     * This is the method that hands over the readings one by one, with the time they were made, and takes them out of
+     * the buffer. The attributes stay in the buffer.
+     *
+     * @param callback The callback receiving the device key, the timestamp and the reading.
+     */
+    void takeReadings(const std::function<void(const std::string&, std::uint64_t, const Reading&)>& callback);
+
+    /**
+     * This is the method that returns the count of the values in the buffer.
+     *
+     * @return The count of the values.
+     */
+    std::size_t size() const;
+
+    std::size_t getMemoryUsage() const;
+
+    std::uint64_t getCompactedCount() const;
+
+    std::uint64_t getEvictedCount() const;
+
+private:
+    // A reading waiting to be published, with the bytes it's estimated to take up
+    struct PendingReading
+    {
+        std::uint32_t device;
+        std::uint64_t timestamp;
+        Reading reading;
+        bool lossless;
+        std::size_t bytes;
+    };
+
+    /**
+     * This is a helper method that returns the index of a device, adding it if it's new.
+     *
+     * @param deviceKey The key of the device.
+     * @return The index of the device.
+     */
+    std::uint32_t indexOf(const std::string& deviceKey);
+
+    /**
+     * This is a helper method that compacts, and if needed evicts, the readings once the limit is exceeded.
+     */
+    void enforceLimit();
+
+    static std::size_t sizeOf(const Reading& reading);
+
+    static std::size_t sizeOf(const Attribute& attribute);
+
+    const std::string TAG = "[OutboundBuffer] -> ";
+
+    std::size_t m_memoryLimit;
+    LosslessCheck m_losslessCheck;
+
+    // The devices, by the order they were first seen in
+    std::vector<std::string> m_deviceKeys;
+    std::unordered_map<std::string, std::uint32_t> m_deviceIndexes;
+
+    // The values, and the estimate of the memory they take up
+    std::deque<PendingReading> m_readings;
+    std::vector<std::map<std::string, Attribute>> m_attributes;
+    std::size_t m_attributeCount;
+    std::atomic<std::size_t> m_memoryUsage;
+
+    // The readings that were compacted away, and the ones that were evicted
+    std::atomic<std::uint64_t> m_compacted;
+    std::atomic<std::uint64_t> m_evicted;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_OUTBOUNDBUFFER_H
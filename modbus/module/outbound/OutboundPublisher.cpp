@@ -0,0 +1,344 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/outbound/OutboundPublisher.h"
+
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// Every publisher gets its own identifier, so the lane a thread remembers is never mistaken for a lane of another
+std::atomic<std::uint64_t> nextPublisherId{1};
+// The time between two sends of the stored readings, the replay rate is spread over them
+const std::chrono::milliseconds REPLAY_TICK{100};
+}    // namespace
+
+OutboundPublisher::Lane::Lane(std::thread::id laneOwner, std::size_t capacity)
+: owner(laneOwner), ring(capacity), dropped(0)
+{
+}
+
+OutboundPublisher::OutboundPublisher(ReadingsCallback readingsCallback, AttributesCallback attributesCallback,
+                                     std::function<bool()> readyCallback, std::function<void()> publishCallback,
+                                     std::unique_ptr<OutboundBuffer> buffer, std::size_t publishValueCount,
+                                     std::chrono::milliseconds publishLatency, std::size_t laneCapacity)
+: m_readingsCallback(std::move(readingsCallback))
+, m_attributesCallback(std::move(attributesCallback))
+, m_readyCallback(std::move(readyCallback))
+, m_publishCallback(std::move(publishCallback))
+, m_buffer(std::move(buffer))
+, m_publishValueCount(std::max<std::size_t>(publishValueCount, 1))
+, m_publishLatency(publishLatency)
+, m_replayRate(0)
+, m_id(nextPublisherId++)
+, m_laneCapacity(laneCapacity)
+, m_lanes{}
+, m_laneCount(0)
+, m_sharedDropped(0)
+, m_running(false)
+, m_wakeUp(false)
+{
+}
+
+OutboundPublisher::~OutboundPublisher()
+{
+    stop();
+}
+
+void OutboundPublisher::setStoreAndForward(std::unique_ptr<StoreAndForwardRing> ring, std::uint32_t replayRate,
+                                           StoredReadingsCallback storedReadingsCallback)
+{
+    m_storeAndForwardRing = std::move(ring);
+    m_replayRate = replayRate;
+    m_storedReadingsCallback = std::move(storedReadingsCallback);
+}
+
+void OutboundPublisher::start()
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    m_thread = std::unique_ptr<std::thread>{new std::thread(&OutboundPublisher::run, this)};
+}
+
+void OutboundPublisher::stop()
+{
+    if (!m_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_running = false;
+    }
+    m_condition.notify_all();
+    if (m_thread != nullptr && m_thread->joinable())
+        m_thread->join();
+    m_thread.reset();
+}
+
+bool OutboundPublisher::pushReadings(const std::string& deviceKey, std::vector<Reading> readings)
+{
+    return push(Item{deviceKey, std::move(readings), {}, std::chrono::steady_clock::now()});
+}
+
+bool OutboundPublisher::pushAttributes(const std::string& deviceKey, std::vector<Attribute> attributes)
+{
+    return push(Item{deviceKey, {}, std::move(attributes), std::chrono::steady_clock::now()});
+}
+
+OutboundStatistics OutboundPublisher::getStatistics() const
+{
+    const auto& ring = m_storeAndForwardRing;
+    return OutboundStatistics{getDroppedCount(),
+                              m_buffer->getCompactedCount(),
+                              m_buffer->getEvictedCount(),
+                              m_buffer->getMemoryUsage(),
+                              ring != nullptr ? ring->getStoredCount() : 0,
+                              ring != nullptr ? ring->getLostCount() : 0};
+}
+
+std::uint64_t OutboundPublisher::getDroppedCount() const
+{
+    auto dropped = m_sharedDropped.load(std::memory_order_relaxed);
+    const auto laneCount = m_laneCount.load(std::memory_order_acquire);
+    for (auto i = std::size_t{0}; i < laneCount; ++i)
+        dropped += m_lanes[i]->dropped.load(std::memory_order_relaxed);
+    return dropped;
+}
+
+bool OutboundPublisher::push(Item&& item)
+{
+    auto lane = laneOfThisThread();
+    if (lane == nullptr)
+    {
+        if (!pushShared(std::move(item)))
+            return false;
+    }
+    else if (!lane->ring.push(std::move(item)))
+    {
+        lane->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Only the first push after the thread took everything out wakes it up. The flag is set under the lock, so it can't
+    // be set between the thread checking it and going to sleep.
+    if (!m_wakeUp.load())
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_wakeUp = true;
+        m_condition.notify_one();
+    }
+    return true;
+}
+
+OutboundPublisher::Lane* OutboundPublisher::laneOfThisThread()
+{
+    // The thread remembers its lane, so only its first push goes through the lock
+    thread_local auto cached = std::pair<std::uint64_t, Lane*>{0, nullptr};
+    if (cached.first == m_id)
+        return cached.second;
+
+    std::lock_guard<std::mutex> lock{m_laneMutex};
+    const auto owner = std::this_thread::get_id();
+    const auto laneCount = m_laneCount.load(std::memory_order_relaxed);
+    auto lane = static_cast<Lane*>(nullptr);
+    for (auto i = std::size_t{0}; i < laneCount && lane == nullptr; ++i)
+    {
+        if (m_lanes[i]->owner == owner)
+            lane = m_lanes[i].get();
+    }
+    if (lane == nullptr)
+    {
+        if (laneCount == MAX_LANES)
+        {
+            LOG(WARN) << TAG << "All the " << MAX_LANES
+                      << " lanes are taken - the values of the thread go through the shared queue.";
+            cached = {m_id, nullptr};
+            return nullptr;
+        }
+        m_lanes[laneCount] = std::unique_ptr<Lane>{new Lane(owner, m_laneCapacity)};
+        lane = m_lanes[laneCount].get();
+        m_laneCount.store(laneCount + 1, std::memory_order_release);
+        LOG(DEBUG) << TAG << "Claimed lane " << laneCount << " with the capacity of " << lane->ring.capacity()
+                   << ".";
+    }
+    cached = {m_id, lane};
+    return lane;
+}
+
+bool OutboundPublisher::pushShared(Item&& item)
+{
+    std::lock_guard<std::mutex> lock{m_sharedMutex};
+    if (m_sharedQueue.size() >= m_laneCapacity)
+    {
+        m_sharedDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_sharedQueue.emplace_back(std::move(item));
+    return true;
+}
+
+void OutboundPublisher::run()
+{
+    const auto never = std::chrono::steady_clock::time_point::max();
+    auto oldestPushedAt = never;
+    auto retryAt = std::chrono::steady_clock::time_point::min();
+    auto replayAt = std::chrono::steady_clock::time_point::min();
+    auto commitAt = never;
+    auto reported = OutboundStatistics{0, 0, 0, 0, 0, 0};
+    while (m_running)
+    {
+        // Wait for a push, or for the oldest pending value to wait long enough. The wait is bounded even with nothing
+        // pending, so a wake up that was missed costs no more than the latency. The stored readings wake it up for
+        // their replay and their commit.
+        {
+            auto lock = std::unique_lock<std::mutex>{m_mutex};
+            auto wakeAt = oldestPushedAt != never ? std::max(oldestPushedAt + m_publishLatency, retryAt) :
+                                                    std::chrono::steady_clock::now() + m_publishLatency;
+            if (m_storeAndForwardRing != nullptr && !m_storeAndForwardRing->empty())
+                wakeAt = std::min(wakeAt, replayAt);
+            m_condition.wait_until(lock, std::min(wakeAt, commitAt), [&] { return m_wakeUp || !m_running; });
+            m_wakeUp = false;
+        }
+        drain(oldestPushedAt);
+
+        // While the platform side isn't ready, the readings go into the ring, and once it is, they're sent back
+        const auto now = std::chrono::steady_clock::now();
+        const auto ready = m_readyCallback();
+        if (m_storeAndForwardRing != nullptr)
+        {
+            if (!ready)
+                storeReadings();
+            else
+                replay(now, replayAt);
+            commitAt = m_storeAndForwardRing->commitIfDue(now);
+        }
+        if (m_buffer->size() == 0)
+        {
+            oldestPushedAt = never;
+            continue;
+        }
+
+        // While the platform side isn't ready, the values stay in the buffer, and it's checked again once the latency
+        // passes, not with every new value
+        if (now < retryAt || (m_buffer->size() < m_publishValueCount && now < oldestPushedAt + m_publishLatency))
+            continue;
+        if (ready)
+        {
+            m_buffer->flush(m_readingsCallback, m_attributesCallback);
+            m_publishCallback();
+            oldestPushedAt = never;
+            retryAt = std::chrono::steady_clock::time_point::min();
+        }
+        else
+        {
+            retryAt = now + m_publishLatency;
+        }
+
+        const auto statistics = getStatistics();
+        if (statistics.dropped != reported.dropped || statistics.compacted != reported.compacted ||
+            statistics.evicted != reported.evicted || statistics.storeLost != reported.storeLost)
+        {
+            LOG(WARN) << TAG << "Lost values - " << statistics.dropped << " push(es) dropped, "
+                      << statistics.compacted << " reading(s) compacted, " << statistics.evicted
+                      << " reading(s) evicted and " << statistics.storeLost << " stored reading(s) lost in total.";
+            reported = statistics;
+        }
+    }
+
+    // Whatever was pushed until the stop is still handed over, or stored if the platform side isn't ready
+    drain(oldestPushedAt);
+    if (m_storeAndForwardRing != nullptr)
+    {
+        if (!m_readyCallback())
+            storeReadings();
+        m_storeAndForwardRing->commit();
+    }
+    m_buffer->flush(m_readingsCallback, m_attributesCallback);
+}
+
+void OutboundPublisher::drain(std::chrono::steady_clock::time_point& oldestPushedAt)
+{
+    // The readings are given the time they were pushed at
+    const auto systemNow = std::chrono::system_clock::now();
+    const auto steadyNow = std::chrono::steady_clock::now();
+    const auto add = [&](Item& item) {
+        if (!item.readings.empty())
+        {
+            const auto pushedAt = systemNow - std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                                steadyNow - item.pushedAt);
+            const auto timestamp =
+              std::chrono::duration_cast<std::chrono::milliseconds>(pushedAt.time_since_epoch()).count();
+            m_buffer->addReadings(item.deviceKey, std::move(item.readings), static_cast<std::uint64_t>(timestamp));
+        }
+        if (!item.attributes.empty())
+            m_buffer->addAttributes(item.deviceKey, std::move(item.attributes));
+        oldestPushedAt = std::min(oldestPushedAt, item.pushedAt);
+    };
+
+    auto item = Item{};
+    const auto laneCount = m_laneCount.load(std::memory_order_acquire);
+    for (auto i = std::size_t{0}; i < laneCount; ++i)
+    {
+        auto& ring = m_lanes[i]->ring;
+        while (ring.pop(item))
+            add(item);
+    }
+
+    // The shared queue is swapped out, so the producers only wait for the lock as long as the swap takes
+    auto shared = std::deque<Item>{};
+    {
+        std::lock_guard<std::mutex> lock{m_sharedMutex};
+        std::swap(shared, m_sharedQueue);
+    }
+    for (auto& sharedItem : shared)
+        add(sharedItem);
+}
+
+void OutboundPublisher::storeReadings()
+{
+    m_buffer->takeReadings([&](const std::string& deviceKey, std::uint64_t timestamp, const Reading& reading) {
+        m_storeAndForwardRing->store(deviceKey, reading.getTimestamp() != 0 ? reading.getTimestamp() : timestamp,
+                                     reading);
+    });
+}
+
+void OutboundPublisher::replay(std::chrono::steady_clock::time_point now,
+                               std::chrono::steady_clock::time_point& replayAt)
+{
+    if (m_storeAndForwardRing->empty() || now < replayAt)
+        return;
+
+    const auto count = std::max<std::size_t>(1, m_replayRate * static_cast<std::size_t>(REPLAY_TICK.count()) / 1000);
+    for (const auto& device : m_storeAndForwardRing->take(count))
+    {
+        if (m_storedReadingsCallback)
+            m_storedReadingsCallback(device.first, device.second);
+    }
+    m_publishCallback();
+    replayAt = now + REPLAY_TICK;
+    if (m_storeAndForwardRing->empty())
+        LOG(INFO) << TAG << "Sent all the stored readings.";
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,256 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_OUTBOUNDPUBLISHER_H
+#define WOLKGATEWAYMODBUSMODULE_OUTBOUNDPUBLISHER_H
+
+#include "core/Types.h"
+#include "modbus/module/outbound/OutboundBuffer.h"
+#include "modbus/module/outbound/StoreAndForwardRing.h"
+#include "modbus/utilities/SpscRing.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+// The counters of the values that didn't make it to the platform side as they were pushed
+struct OutboundStatistics
+{
+    std::uint64_t dropped;
+    std::uint64_t compacted;
+    std::uint64_t evicted;
+    std::size_t memoryUsage;
+    std::uint64_t stored;
+    std::uint64_t storeLost;
+};
+
+/**
+ * @brief Class that hands the values over from the Modbus side to the platform side, through its own thread.
+ * @details Every thread pushing values is given its own lock-free single-producer/single-consumer lane on its first
+ *          push, so pushing never waits for a lock, or for the broker. The publisher thread is woken up by the
+ *          pushes, and takes the values out of all the lanes into the outbound buffer. They are handed over to the
+ *          platform side and published as soon as enough of them are pending, or the oldest of them has waited long
+ *          enough, whichever comes first. While the platform side isn't ready, they stay in the buffer, which keeps
+ *          them within its memory limit, or if there's a store and forward ring, the readings are moved into it. Once
+ *          the platform side is ready again, the stored readings are sent with their timestamps, at the replay rate.
+ *          Once all the lanes are taken, the threads without a lane push into a shared queue under a lock instead.
+ *          A push into a full lane, or into the full shared queue, is dropped and counted.
+ */
+class OutboundPublisher
+{
+public:
+    using ReadingsCallback = OutboundBuffer::ReadingsCallback;
+    using AttributesCallback = OutboundBuffer::AttributesCallback;
+    using StoredReadingsCallback =
+      std::function<void(const std::string&, const std::map<std::uint64_t, std::vector<Reading>>&)>;
+
+    /**
+     * Default constructor for the publisher.
+     *
+     * @param readingsCallback The callback that adds the readings of a device to the platform side.
+     * @param attributesCallback The callback that adds the attributes of a device to the platform side.
+     * @param readyCallback The callback that returns whether the platform side can take the values.
+     * @param publishCallback The callback that publishes everything that was added.
+     * @param buffer The buffer holding the values until they are published.
+     * @param publishValueCount The count of pending values that triggers a publish.
+     * @param publishLatency The time the oldest pending value can wait before it triggers a publish.
+     * @param laneCapacity The count of pushes a single lane can hold.
+     */
+    OutboundPublisher(ReadingsCallback readingsCallback, AttributesCallback attributesCallback,
+                      std::function<bool()> readyCallback, std::function<void()> publishCallback,
+                      std::unique_ptr<OutboundBuffer> buffer, std::size_t publishValueCount,
+                      std::chrono::milliseconds publishLatency, std::size_t laneCapacity);
+
+    /**
+     * Default destructor.
+     * Will stop the publisher thread.
+     */
+    ~OutboundPublisher();
+
+    /**
+     * This is the method that sets up the ring into which the readings are stored while the platform side isn't
+     * ready. Must be called before the publisher is started.
+     *
+     * @param ring The opened ring.
+     * @param replayRate The count of stored readings sent every second.
+     * @param storedReadingsCallback The callback that adds the timestamped readings of a device to the platform side.
+     */
+    void setStoreAndForward(std::unique_ptr<StoreAndForwardRing> ring, std::uint32_t replayRate,
+                            StoredReadingsCallback storedReadingsCallback);
+
+    /**
+     * This is the method that starts the publisher thread.
+     */
+    void start();
+
+    /**
+     * This is the method that stops the publisher thread, once it has added everything that was pushed.
+     */
+    void stop();
+
+    /**
+     * This is the method that hands over the readings of a device. Never blocks.
+     *
+     * @param deviceKey The key of the device.
+     * @param readings The readings.
+     * @return Whether the readings were accepted, false if they were dropped.
+     */
+    bool pushReadings(const std::string& deviceKey, std::vector<Reading> readings);
+
+    /**
+     * This is the method that hands over the attributes of a device. Never blocks.
+     *
+     * @param deviceKey The key of the device.
+     * @param attributes The attributes.
+     * @return Whether the attributes were accepted, false if they were dropped.
+     */
+    bool pushAttributes(const std::string& deviceKey, std::vector<Attribute> attributes);
+
+    /**
+     * This is the method that returns the counters of the values that were lost or compacted since the publisher was
+     * created, and the memory the pending values take up.
+     *
+     * @return The statistics.
+     */
+    OutboundStatistics getStatistics() const;
+
+private:
+    // The values of a single push
+    struct Item
+    {
+        std::string deviceKey;
+        std::vector<Reading> readings;
+        std::vector<Attribute> attributes;
+        std::chrono::steady_clock::time_point pushedAt;
+    };
+
+    // The queue of a single producer thread, and the pushes it dropped because it was full
+    struct Lane
+    {
+        Lane(std::thread::id laneOwner, std::size_t capacity);
+
+        std::thread::id owner;
+        SpscRing<Item> ring;
+        std::atomic<std::uint64_t> dropped;
+    };
+
+    static constexpr std::size_t MAX_LANES = 32;
+
+    /**
+     * This is a helper method that pushes the values into the lane of the calling thread.
+     *
+     * @param item The values.
+     * @return Whether the values were accepted.
+     */
+    bool push(Item&& item);
+
+    /**
+     * This is a helper method that finds the lane of the calling thread, or claims a new one for it.
+     *
+     * @return The lane, nullptr if all the lanes are taken.
+     */
+    Lane* laneOfThisThread();
+
+    /**
+     * This is a helper method that pushes the values into the shared queue, for the threads that didn't get a lane.
+     *
+     * @param item The values.
+     * @return Whether the values were accepted, false if the queue is full.
+     */
+    bool pushShared(Item&& item);
+
+    /**
+     * This is the method executed by the publisher thread.
+     */
+    void run();
+
+    /**
+     * This is a helper method that returns the count of the pushes that were dropped.
+     *
+     * @return The count of dropped pushes.
+     */
+    std::uint64_t getDroppedCount() const;
+
+    /**
+     * This is a helper method that takes everything out of the lanes and the shared queue, and adds it to the buffer.
+     *
+     * @param oldestPushedAt The time of the oldest push that was taken out, left as is if it was older.
+     */
+    void drain(std::chrono::steady_clock::time_point& oldestPushedAt);
+
+    /**
+     * This is a helper method that moves the readings out of the buffer into the store and forward ring.
+     */
+    void storeReadings();
+
+    /**
+     * This is a helper method that sends the next stored readings, if the replay is due.
+     *
+     * @param now The current time.
+     * @param replayAt The time of the next replay, moved on if the readings were sent.
+     */
+    void replay(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& replayAt);
+
+    const std::string TAG = "[OutboundPublisher] -> ";
+
+    // The platform side
+    ReadingsCallback m_readingsCallback;
+    AttributesCallback m_attributesCallback;
+    std::function<bool()> m_readyCallback;
+    std::function<void()> m_publishCallback;
+    std::unique_ptr<OutboundBuffer> m_buffer;
+    std::size_t m_publishValueCount;
+    std::chrono::milliseconds m_publishLatency;
+
+    // The readings stored while the platform side isn't ready
+    std::unique_ptr<StoreAndForwardRing> m_storeAndForwardRing;
+    std::uint32_t m_replayRate;
+    StoredReadingsCallback m_storedReadingsCallback;
+
+    // The lanes, claimed under the lock, and published to the consumer through the lane count
+    const std::uint64_t m_id;
+    const std::size_t m_laneCapacity;
+    std::array<std::unique_ptr<Lane>, MAX_LANES> m_lanes;
+    std::atomic<std::size_t> m_laneCount;
+    std::mutex m_laneMutex;
+
+    // The queue of the threads that didn't get a lane, with the pushes it dropped because it was full
+    std::deque<Item> m_sharedQueue;
+    std::atomic<std::uint64_t> m_sharedDropped;
+    std::mutex m_sharedMutex;
+
+    // The thread, woken up by the producers when there's something to take out
+    std::atomic_bool m_running;
+    std::atomic_bool m_wakeUp;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::unique_ptr<std::thread> m_thread;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_OUTBOUNDPUBLISHER_H
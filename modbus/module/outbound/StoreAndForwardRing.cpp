@@ -0,0 +1,515 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/outbound/StoreAndForwardRing.h"
+
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+const std::uint32_t MAGIC = 0x52464153;
+const std::uint32_t VERSION = 1;
+// The header slots take up the first page, and the dictionary comes right after it
+const std::uint64_t HEADER_SIZE = 4096;
+const std::uint64_t HEADER_SLOT_SIZE = 512;
+const std::uint64_t MAX_DICTIONARY_SIZE = 1024 * 1024;
+const std::uint64_t MIN_FILE_SIZE = 64 * 1024;
+// The longest a variable length integer can be
+const std::size_t MAX_VARINT_SIZE = 10;
+
+void putVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        bytes.emplace_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.emplace_back(static_cast<std::uint8_t>(value));
+}
+
+bool getVarint(const std::vector<std::uint8_t>& bytes, std::size_t& position, std::uint64_t& value)
+{
+    value = 0;
+    for (auto shift = 0u; position < bytes.size() && shift < 64; shift += 7)
+    {
+        const auto byte = bytes[position++];
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+}    // namespace
+
+StoreAndForwardRing::StoreAndForwardRing(std::string path, std::uint64_t size,
+                                         std::chrono::milliseconds commitInterval)
+: m_path(std::move(path))
+, m_size(size)
+, m_commitInterval(commitInterval)
+, m_fd(-1)
+, m_memory(nullptr)
+, m_dictionarySize(std::min(MAX_DICTIONARY_SIZE, size / 8))
+, m_dataSize(size > HEADER_SIZE + m_dictionarySize ? size - HEADER_SIZE - m_dictionarySize : 0)
+, m_sequence(0)
+, m_head(0)
+, m_tail(0)
+, m_count(0)
+, m_headTimestamp(0)
+, m_tailTimestamp(0)
+, m_dictionaryUsed(0)
+, m_committedHead(0)
+, m_dirty(false)
+, m_lost(0)
+{
+}
+
+StoreAndForwardRing::~StoreAndForwardRing()
+{
+    if (m_memory != nullptr)
+    {
+        commit();
+        munmap(m_memory, m_size);
+    }
+    if (m_fd != -1)
+        close(m_fd);
+}
+
+bool StoreAndForwardRing::open()
+{
+    if (m_size < MIN_FILE_SIZE)
+    {
+        LOG(ERROR) << TAG << "The file '" << m_path << "' needs to be at least " << MIN_FILE_SIZE << " bytes.";
+        return false;
+    }
+
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd == -1)
+    {
+        LOG(ERROR) << TAG << "Failed to open '" << m_path << "' - " << std::strerror(errno) << ".";
+        return false;
+    }
+
+    // The space is reserved up front, so a full storage doesn't show up later as a fault in a write into the mapping
+    struct stat status
+    {
+    };
+    if (fstat(m_fd, &status) != 0 || static_cast<std::uint64_t>(status.st_size) != m_size)
+    {
+        const auto error = ftruncate(m_fd, static_cast<off_t>(m_size)) != 0 ?
+                             errno :
+                             posix_fallocate(m_fd, 0, static_cast<off_t>(m_size));
+        if (error != 0)
+        {
+            LOG(ERROR) << TAG << "Failed to reserve " << m_size << " bytes for '" << m_path << "' - "
+                       << std::strerror(error) << ".";
+            return false;
+        }
+    }
+
+    const auto memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        LOG(ERROR) << TAG << "Failed to map '" << m_path << "' - " << std::strerror(errno) << ".";
+        return false;
+    }
+    m_memory = static_cast<std::uint8_t*>(memory);
+
+    if (!recover())
+    {
+        reset();
+        commit();
+    }
+    LOG(INFO) << TAG << "Opened '" << m_path << "' with " << m_count << " stored reading(s).";
+    return true;
+}
+
+bool StoreAndForwardRing::store(const std::string& deviceKey, std::uint64_t timestamp, const Reading& reading)
+{
+    const auto feed = feedOf(deviceKey, reading.getReference());
+    if (!feed)
+    {
+        ++m_lost;
+        return false;
+    }
+
+    auto payload = std::vector<std::uint8_t>{};
+    payload.emplace_back(0);
+    putVarint(payload, *feed);
+    putVarint(payload, zigzag(static_cast<std::int64_t>(timestamp - m_tailTimestamp)));
+    if (reading.isBoolean())
+    {
+        payload[0] = static_cast<std::uint8_t>(reading.getBoolValue() ? ValueType::BOOL_TRUE : ValueType::BOOL_FALSE);
+    }
+    else if (reading.isUInt())
+    {
+        payload[0] = static_cast<std::uint8_t>(ValueType::UINT);
+        putVarint(payload, reading.getUIntValue());
+    }
+    else if (reading.isInt())
+    {
+        payload[0] = static_cast<std::uint8_t>(ValueType::INT);
+        putVarint(payload, zigzag(reading.getIntValue()));
+    }
+    else if (reading.isDouble())
+    {
+        payload[0] = static_cast<std::uint8_t>(ValueType::DOUBLE);
+        const auto value = reading.getDoubleValue();
+        auto bytes = std::array<std::uint8_t, sizeof(double)>{};
+        std::memcpy(bytes.data(), &value, sizeof(double));
+        payload.insert(payload.end(), bytes.cbegin(), bytes.cend());
+    }
+    else
+    {
+        payload[0] = static_cast<std::uint8_t>(ValueType::STRING);
+        const auto value = reading.getStringValue();
+        payload.insert(payload.end(), value.cbegin(), value.cend());
+    }
+
+    auto record = std::vector<std::uint8_t>{};
+    putVarint(record, payload.size());
+    record.insert(record.end(), payload.cbegin(), payload.cend());
+    if (record.size() > m_dataSize / 16)
+    {
+        ++m_lost;
+        return false;
+    }
+
+    // Make room, and commit the new head before writing over records the committed header still holds
+    if (m_dataSize - (m_tail - m_head) < record.size())
+        evict(record.size());
+    if (m_tail + record.size() > m_committedHead + m_dataSize)
+        commit();
+
+    writeBytes(m_tail, record.data(), record.size());
+    m_tail += record.size();
+    m_tailTimestamp = timestamp;
+    ++m_count;
+    markDirty();
+    return true;
+}
+
+StoreAndForwardRing::StoredReadings StoreAndForwardRing::take(std::size_t count)
+{
+    auto readings = StoredReadings{};
+    for (auto taken = std::size_t{0}; taken < count && m_count > 0; ++taken)
+    {
+        const auto record = popHead();
+        if (!record)
+        {
+            ++m_lost;
+            continue;
+        }
+        const auto& feed = m_feeds[record->feed];
+        auto& timestamped = readings[feed.first][record->timestamp];
+        auto position = std::size_t{0};
+        auto value = std::uint64_t{0};
+        switch (record->type)
+        {
+        case ValueType::BOOL_FALSE:
+        case ValueType::BOOL_TRUE:
+            timestamped.emplace_back(feed.second, record->type == ValueType::BOOL_TRUE, record->timestamp);
+            break;
+        case ValueType::UINT:
+            getVarint(record->value, position, value);
+            timestamped.emplace_back(feed.second, value, record->timestamp);
+            break;
+        case ValueType::INT:
+            getVarint(record->value, position, value);
+            timestamped.emplace_back(feed.second, unzigzag(value), record->timestamp);
+            break;
+        case ValueType::DOUBLE:
+        {
+            auto number = 0.0;
+            std::memcpy(&number, record->value.data(), std::min(record->value.size(), sizeof(double)));
+            timestamped.emplace_back(feed.second, number, record->timestamp);
+            break;
+        }
+        case ValueType::STRING:
+            timestamped.emplace_back(feed.second, std::string(record->value.cbegin(), record->value.cend()),
+                                     record->timestamp);
+            break;
+        }
+    }
+
+    // Once everything is taken out, the dictionary starts over, which has to be committed before it's written again
+    if (m_count == 0 && m_dictionaryUsed > 0)
+    {
+        reset();
+        commit();
+    }
+    else if (!readings.empty())
+    {
+        markDirty();
+    }
+    return readings;
+}
+
+void StoreAndForwardRing::commit()
+{
+    if (m_memory == nullptr)
+        return;
+
+    // The records and the dictionary need to be on the storage before the header that holds them
+    if (msync(m_memory, m_size, MS_SYNC) != 0)
+        LOG(ERROR) << TAG << "Failed to sync '" << m_path << "' - " << std::strerror(errno) << ".";
+
+    auto header = Header{MAGIC,
+                         VERSION,
+                         ++m_sequence,
+                         m_size,
+                         m_head,
+                         m_tail,
+                         m_count,
+                         m_headTimestamp,
+                         m_tailTimestamp,
+                         m_dictionaryUsed,
+                         static_cast<std::uint32_t>(m_feeds.size()),
+                         0};
+    header.checksum = checksumOf(header);
+    std::memcpy(m_memory + (m_sequence % 2) * HEADER_SLOT_SIZE, &header, sizeof(Header));
+    if (msync(m_memory, HEADER_SIZE, MS_SYNC) != 0)
+        LOG(ERROR) << TAG << "Failed to sync the header of '" << m_path << "' - " << std::strerror(errno) << ".";
+
+    m_committedHead = m_head;
+    m_dirty = false;
+}
+
+std::chrono::steady_clock::time_point StoreAndForwardRing::commitIfDue(std::chrono::steady_clock::time_point now)
+{
+    if (!m_dirty)
+        return std::chrono::steady_clock::time_point::max();
+    if (now < m_commitAt)
+        return m_commitAt;
+    commit();
+    return std::chrono::steady_clock::time_point::max();
+}
+
+bool StoreAndForwardRing::empty() const
+{
+    return m_count == 0;
+}
+
+std::uint64_t StoreAndForwardRing::getStoredCount() const
+{
+    return m_count;
+}
+
+std::uint64_t StoreAndForwardRing::getLostCount() const
+{
+    return m_lost;
+}
+
+bool StoreAndForwardRing::recover()
+{
+    auto header = Header{};
+    auto found = false;
+    for (auto slot = std::uint64_t{0}; slot < 2; ++slot)
+    {
+        auto candidate = Header{};
+        std::memcpy(&candidate, m_memory + slot * HEADER_SLOT_SIZE, sizeof(Header));
+        if (candidate.magic != MAGIC || candidate.version != VERSION || candidate.checksum != checksumOf(candidate) ||
+            candidate.fileSize != m_size || candidate.head > candidate.tail ||
+            candidate.tail - candidate.head > m_dataSize || candidate.dictionaryUsed > m_dictionarySize)
+            continue;
+        if (!found || candidate.sequence > header.sequence)
+            header = candidate;
+        found = true;
+    }
+    if (!found)
+    {
+        LOG(WARN) << TAG << "No valid header in '" << m_path << "' - starting it over.";
+        return false;
+    }
+
+    // The dictionary entries are the device key and the reference, each with its length in front of it
+    const auto dictionary = m_memory + HEADER_SIZE;
+    auto position = std::uint64_t{0};
+    for (auto feed = std::uint32_t{0}; feed < header.feedCount; ++feed)
+    {
+        auto parts = std::array<std::string, 2>{};
+        for (auto& part : parts)
+        {
+            if (position >= header.dictionaryUsed || position + 1 + dictionary[position] > header.dictionaryUsed)
+            {
+                LOG(WARN) << TAG << "The dictionary of '" << m_path << "' is broken - starting it over.";
+                return false;
+            }
+            part.assign(reinterpret_cast<const char*>(dictionary + position + 1), dictionary[position]);
+            position += 1 + dictionary[position];
+        }
+        m_feedIndexes.emplace(parts[0] + '\0' + parts[1], feed);
+        m_feeds.emplace_back(std::move(parts[0]), std::move(parts[1]));
+    }
+
+    m_sequence = header.sequence;
+    m_head = header.head;
+    m_tail = header.tail;
+    m_count = header.count;
+    m_headTimestamp = header.headTimestamp;
+    m_tailTimestamp = header.tailTimestamp;
+    m_dictionaryUsed = header.dictionaryUsed;
+    m_committedHead = m_head;
+    return true;
+}
+
+void StoreAndForwardRing::reset()
+{
+    m_head = 0;
+    m_tail = 0;
+    m_count = 0;
+    m_headTimestamp = m_tailTimestamp;
+    m_dictionaryUsed = 0;
+    m_feeds.clear();
+    m_feedIndexes.clear();
+}
+
+std::optional<std::uint32_t> StoreAndForwardRing::feedOf(const std::string& deviceKey, const std::string& reference)
+{
+    auto key = deviceKey + '\0' + reference;
+    const auto it = m_feedIndexes.find(key);
+    if (it != m_feedIndexes.cend())
+        return it->second;
+
+    const auto entrySize = 2 + deviceKey.size() + reference.size();
+    if (deviceKey.size() > 0xFF || reference.size() > 0xFF || m_dictionaryUsed + entrySize > m_dictionarySize)
+    {
+        LOG(WARN) << TAG << "Feed '" << reference << "' of device '" << deviceKey
+                  << "' doesn't fit into the dictionary.";
+        return {};
+    }
+
+    auto entry = m_memory + HEADER_SIZE + m_dictionaryUsed;
+    for (const auto& part : {std::cref(deviceKey), std::cref(reference)})
+    {
+        *entry = static_cast<std::uint8_t>(part.get().size());
+        std::memcpy(entry + 1, part.get().data(), part.get().size());
+        entry += 1 + part.get().size();
+    }
+    m_dictionaryUsed += entrySize;
+
+    const auto feed = static_cast<std::uint32_t>(m_feeds.size());
+    m_feeds.emplace_back(deviceKey, reference);
+    m_feedIndexes.emplace(std::move(key), feed);
+    markDirty();
+    return feed;
+}
+
+std::optional<StoreAndForwardRing::Record> StoreAndForwardRing::popHead()
+{
+    // The length of the record comes first, and it can wrap around the end like everything else
+    auto lengthBytes = std::vector<std::uint8_t>(std::min<std::uint64_t>(MAX_VARINT_SIZE, m_tail - m_head));
+    readBytes(m_head, lengthBytes.data(), lengthBytes.size());
+    auto position = std::size_t{0};
+    auto length = std::uint64_t{0};
+    getVarint(lengthBytes, position, length);
+    length = std::min(length, m_tail - m_head - position);
+
+    auto payload = std::vector<std::uint8_t>(length);
+    readBytes(m_head + position, payload.data(), payload.size());
+    m_head += position + length;
+    --m_count;
+
+    auto feed = std::uint64_t{0};
+    auto delta = std::uint64_t{0};
+    position = 1;
+    if (payload.empty() || !getVarint(payload, position, feed) || !getVarint(payload, position, delta) ||
+        feed >= m_feeds.size() || payload[0] > static_cast<std::uint8_t>(ValueType::STRING))
+    {
+        LOG(ERROR) << TAG << "Found a broken record in '" << m_path << "'.";
+        return {};
+    }
+
+    m_headTimestamp += static_cast<std::uint64_t>(unzigzag(delta));
+    return Record{static_cast<std::uint32_t>(feed), m_headTimestamp, static_cast<ValueType>(payload[0]),
+                  std::vector<std::uint8_t>(payload.cbegin() + static_cast<std::ptrdiff_t>(position), payload.cend())};
+}
+
+void StoreAndForwardRing::markDirty()
+{
+    if (m_dirty)
+        return;
+    m_dirty = true;
+    m_commitAt = std::chrono::steady_clock::now() + m_commitInterval;
+}
+
+void StoreAndForwardRing::evict(std::uint64_t bytes)
+{
+    const auto target = std::max(bytes, m_dataSize / 16);
+    auto evicted = std::uint64_t{0};
+    while (m_count > 0 && m_dataSize - (m_tail - m_head) < target)
+    {
+        popHead();
+        ++evicted;
+    }
+    m_lost += evicted;
+    LOG(WARN) << TAG << "The ring in '" << m_path << "' is full - overwrote " << evicted << " reading(s).";
+}
+
+void StoreAndForwardRing::writeBytes(std::uint64_t offset, const std::uint8_t* data, std::size_t size)
+{
+    const auto data0 = m_memory + HEADER_SIZE + m_dictionarySize;
+    const auto start = offset % m_dataSize;
+    const auto first = std::min<std::uint64_t>(size, m_dataSize - start);
+    std::memcpy(data0 + start, data, first);
+    std::memcpy(data0, data + first, size - first);
+}
+
+void StoreAndForwardRing::readBytes(std::uint64_t offset, std::uint8_t* data, std::size_t size) const
+{
+    const auto data0 = m_memory + HEADER_SIZE + m_dictionarySize;
+    const auto start = offset % m_dataSize;
+    const auto first = std::min<std::uint64_t>(size, m_dataSize - start);
+    std::memcpy(data, data0 + start, first);
+    std::memcpy(data + first, data0, size - first);
+}
+
+std::uint32_t StoreAndForwardRing::checksumOf(const Header& header)
+{
+    // FNV-1a over everything in front of the checksum
+    auto bytes = std::array<std::uint8_t, offsetof(Header, checksum)>{};
+    std::memcpy(bytes.data(), &header, bytes.size());
+    auto checksum = std::uint32_t{2166136261u};
+    for (const auto byte : bytes)
+        checksum = (checksum ^ byte) * 16777619u;
+    return checksum;
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,239 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDRING_H
+#define WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDRING_H
+
+#include "core/Types.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Fixed-size file, mapped into memory, holding the timestamped readings while the platform can't be reached.
+ * @details The file starts with two header slots, followed by the dictionary of the feeds, and the ring of the
+ *          records. A record holds the index of the feed in the dictionary, the difference from the timestamp of the
+ *          previous record and the value, all as variable length integers where possible, so a numeric reading
+ *          usually takes 5 to 12 bytes. Once the ring is full, the oldest records are overwritten.
+ *          The records are only written to the storage when they are committed, once in the commit interval. The
+ *          storage is synced first, and only then the header slot that wasn't written the last time, so a crash loses
+ *          at most the readings since the last commit, and never leaves records that can't be read. The ring is
+ *          committed before it overwrites records that the last committed header still holds.
+ *          Must only be used from a single thread, except for the counters.
+ */
+class StoreAndForwardRing
+{
+public:
+    // The readings of every device, by their timestamps
+    using StoredReadings = std::map<std::string, std::map<std::uint64_t, std::vector<Reading>>>;
+
+    /**
+     * Default constructor for the ring.
+     *
+     * @param path The path of the file.
+     * @param size The size of the file, in bytes.
+     * @param commitInterval The time between two commits.
+     */
+    StoreAndForwardRing(std::string path, std::uint64_t size, std::chrono::milliseconds commitInterval);
+
+    /**
+     * Default destructor.
+     * Will commit the ring and close the file.
+     */
+    ~StoreAndForwardRing();
+
+    StoreAndForwardRing(const StoreAndForwardRing&) = delete;
+    StoreAndForwardRing& operator=(const StoreAndForwardRing&) = delete;
+
+    /**
+     * This is the method that opens the file, and reads the readings committed in it. A file that can't be read is
+     * emptied.
+     *
+     * @return Whether the file is ready to be used.
+     */
+    bool open();
+
+    /**
+     * This is the method that stores a reading, overwriting the oldest ones if the ring is full.
+     *
+     * @param deviceKey The key of the device.
+     * @param timestamp The timestamp of the reading, in milliseconds.
+     * @param reading The reading.
+     * @return Whether the reading was stored, false if it can't fit into the dictionary or the ring.
+     */
+    bool store(const std::string& deviceKey, std::uint64_t timestamp, const Reading& reading);
+
+    /**
+     * This is the method that takes the oldest readings out of the ring.
+     *
+     * @param count The highest count of readings that are taken out.
+     * @return The readings.
+     */
+    StoredReadings take(std::size_t count);
+
+    /**
+     * This is the method that writes everything changed since the last commit to the storage.
+     */
+    void commit();
+
+    /**
+     * This is the method that commits the ring if it's been changed, and the commit interval has passed.
+     *
+     * @param now The current time.
+     * @return The time of the next commit, max if nothing is waiting to be committed.
+     */
+    std::chrono::steady_clock::time_point commitIfDue(std::chrono::steady_clock::time_point now);
+
+    bool empty() const;
+
+    std::uint64_t getStoredCount() const;
+
+    /**
+     * This is the method that returns the count of the readings that were overwritten, or couldn't be stored.
+     *
+     * @return The count of lost readings.
+     */
+    std::uint64_t getLostCount() const;
+
+private:
+    // A single header slot, as it's laid out in the file
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t sequence;
+        std::uint64_t fileSize;
+        std::uint64_t head;
+        std::uint64_t tail;
+        std::uint64_t count;
+        std::uint64_t headTimestamp;
+        std::uint64_t tailTimestamp;
+        std::uint64_t dictionaryUsed;
+        std::uint32_t feedCount;
+        std::uint32_t checksum;
+    };
+
+    // The type of the value, stored in every record
+    enum class ValueType : std::uint8_t
+    {
+        BOOL_FALSE,
+        BOOL_TRUE,
+        UINT,
+        INT,
+        DOUBLE,
+        STRING
+    };
+
+    // A record, as it's read out of the ring
+    struct Record
+    {
+        std::uint32_t feed;
+        std::uint64_t timestamp;
+        ValueType type;
+        std::vector<std::uint8_t> value;
+    };
+
+    /**
+     * This is a helper method that reads the newest valid header slot, and the dictionary it holds.
+     *
+     * @return Whether a valid header was found.
+     */
+    bool recover();
+
+    /**
+     * This is a helper method that empties the ring and the dictionary.
+     */
+    void reset();
+
+    /**
+     * This is a helper method that returns the index of a feed in the dictionary, adding it if it's new.
+     *
+     * @param deviceKey The key of the device.
+     * @param reference The reference of the feed.
+     * @return The index, empty if the dictionary is full.
+     */
+    std::optional<std::uint32_t> feedOf(const std::string& deviceKey, const std::string& reference);
+
+    /**
+     * This is a helper method that reads the record at the head of the ring, and moves the head past it.
+     *
+     * @return The record, empty if it can't be read.
+     */
+    std::optional<Record> popHead();
+
+    /**
+     * This is a helper method that marks the ring as changed since the last commit.
+     */
+    void markDirty();
+
+    /**
+     * This is a helper method that drops the oldest records until the bytes are free, and at least a sixteenth of
+     * the ring along with them, so the ring is not committed before every record once it's full.
+     *
+     * @param bytes The bytes that need to be free.
+     */
+    void evict(std::uint64_t bytes);
+
+    void writeBytes(std::uint64_t offset, const std::uint8_t* data, std::size_t size);
+
+    void readBytes(std::uint64_t offset, std::uint8_t* data, std::size_t size) const;
+
+    static std::uint32_t checksumOf(const Header& header);
+
+    const std::string TAG = "[StoreAndForwardRing] -> ";
+
+    std::string m_path;
+    std::uint64_t m_size;
+    std::chrono::milliseconds m_commitInterval;
+
+    // The mapped file, and the regions in it
+    int m_fd;
+    std::uint8_t* m_memory;
+    std::uint64_t m_dictionarySize;
+    std::uint64_t m_dataSize;
+
+    // The state that is written into the header on every commit
+    std::uint64_t m_sequence;
+    std::uint64_t m_head;
+    std::uint64_t m_tail;
+    std::atomic<std::uint64_t> m_count;
+    std::uint64_t m_headTimestamp;
+    std::uint64_t m_tailTimestamp;
+    std::uint64_t m_dictionaryUsed;
+
+    // The head the last committed header holds, the records from it on can't be overwritten before a commit
+    std::uint64_t m_committedHead;
+    bool m_dirty;
+    std::chrono::steady_clock::time_point m_commitAt;
+
+    // The dictionary of the feeds, by the device key and the reference joined by a zero
+    std::vector<std::pair<std::string, std::string>> m_feeds;
+    std::unordered_map<std::string, std::uint32_t> m_feedIndexes;
+
+    std::atomic<std::uint64_t> m_lost;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_STOREANDFORWARDRING_H
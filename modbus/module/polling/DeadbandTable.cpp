@@ -0,0 +1,115 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/polling/DeadbandTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// The count of rows covered by a single word of the bitmask
+const std::size_t ROWS_PER_WORD = 64;
+
+// The times are kept as doubles, as the comparisons of 64-bit integers can't be vectorized on every target
+double toMilliseconds(std::chrono::steady_clock::time_point time)
+{
+    return std::chrono::duration<double, std::milli>(time.time_since_epoch()).count();
+}
+
+// Checks a chunk of rows, with the flags kept as 0.0 or 1.0, so the loop has no branches and is vectorized. The columns
+// never overlap, which the compiler can't know without the restrict qualifiers.
+void filterRows(const double* __restrict values, const double* __restrict sent, const double* __restrict deadbands,
+                const double* __restrict dueAt, const double* __restrict open, double* __restrict passing,
+                double* __restrict held, std::size_t count, double time)
+{
+    for (auto i = std::size_t{0}; i < count; ++i)
+    {
+        // A NaN on one side makes the difference a NaN, which counts as a significant change, while a value that stays
+        // a NaN is unchanged
+        const auto difference = std::abs(values[i] - sent[i]);
+        const auto stillNan = std::isnan(values[i]) && std::isnan(sent[i]);
+        const auto changed = !stillNan && !(difference <= 0.0) ? 1.0 : 0.0;
+        const auto significant = !(difference < deadbands[i]) ? 1.0 : 0.0;
+        const auto due = !(time < dueAt[i]) ? 1.0 : 0.0;
+        const auto change = changed * significant;
+        passing[i] = open[i] + change * due * (1.0 - open[i]);
+        held[i] = change * (1.0 - due) * (1.0 - open[i]);
+    }
+}
+}    // namespace
+
+void DeadbandTable::add(double deadband, std::chrono::milliseconds frequencyFilter, bool filtered)
+{
+    m_sent.emplace_back(0.0);
+    m_dueAt.emplace_back(0.0);
+    m_deadbands.emplace_back(deadband);
+    m_frequencyFilters.emplace_back(static_cast<double>(frequencyFilter.count()));
+    m_filtered.emplace_back(filtered);
+    m_open.emplace_back(1.0);
+    m_passing.resize((m_sent.size() + ROWS_PER_WORD - 1) / ROWS_PER_WORD, 0);
+}
+
+bool DeadbandTable::evaluate(const double* values, std::chrono::steady_clock::time_point now)
+{
+    const auto time = toMilliseconds(now);
+    auto held = false;
+    auto passingFlags = std::array<double, ROWS_PER_WORD>{};
+    auto heldFlags = std::array<double, ROWS_PER_WORD>{};
+    for (auto word = std::size_t{0}; word < m_passing.size(); ++word)
+    {
+        // The flags of the rows are found first, and only then packed into the word of the bitmask
+        const auto first = word * ROWS_PER_WORD;
+        const auto count = std::min(m_sent.size() - first, ROWS_PER_WORD);
+        filterRows(values + first, m_sent.data() + first, m_deadbands.data() + first, m_dueAt.data() + first,
+                   m_open.data() + first, passingFlags.data(), heldFlags.data(), count, time);
+
+        auto passing = std::uint64_t{0};
+        for (auto i = std::size_t{0}; i < count; ++i)
+        {
+            passing |= static_cast<std::uint64_t>(passingFlags[i] > 0.5) << i;
+            held = held || heldFlags[i] > 0.5;
+        }
+        m_passing[word] = passing;
+    }
+    return held;
+}
+
+bool DeadbandTable::passes(std::size_t row) const
+{
+    return ((m_passing[row / ROWS_PER_WORD] >> (row % ROWS_PER_WORD)) & 1) != 0;
+}
+
+bool DeadbandTable::isFiltered(std::size_t row) const
+{
+    return m_filtered[row];
+}
+
+void DeadbandTable::accept(std::size_t row, double value, std::chrono::steady_clock::time_point now)
+{
+    m_sent[row] = value;
+    m_dueAt[row] = toMilliseconds(now) + m_frequencyFilters[row];
+    m_open[row] = m_filtered[row] ? 0.0 : 1.0;
+}
+
+std::size_t DeadbandTable::size() const
+{
+    return m_sent.size();
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,101 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_DEADBANDTABLE_H
+#define WOLKGATEWAYMODBUSMODULE_DEADBANDTABLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Table of the filters of the mappings of a group, kept as one array per column, with a row per mapping.
+ * @details The decoded values of a response are checked against the last sent values, the deadbands and the frequency
+ *          filters of all the rows in a single pass without branches, producing a bitmask of the rows whose values
+ *          pass. For the rows it filters, the table is the only place the deadband and the frequency filter are
+ *          checked, and only the mappings that passed are looked at any further.
+ *          Rows that are not filtered, such as boolean, string and aggregated mappings, always pass, and so do the
+ *          rows that were never sent. A value turning into a NaN, or out of it, is a change that passes the deadband,
+ *          while a value that stays a NaN is not a change.
+ */
+class DeadbandTable
+{
+public:
+    /**
+     * This is the method that adds a row at the end of the table.
+     *
+     * @param deadband The smallest change of the value that passes.
+     * @param frequencyFilter The shortest time between two values that pass.
+     * @param filtered Whether the row is filtered by the table, the other rows always pass.
+     */
+    void add(double deadband, std::chrono::milliseconds frequencyFilter, bool filtered);
+
+    /**
+     * This is the method that checks the current values of all the rows against the filters.
+     *
+     * @param values The current values, one per row.
+     * @param now The time of the values.
+     * @return Whether any value is held back only by its frequency filter, and would pass later.
+     */
+    bool evaluate(const double* values, std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is the method that returns whether the value of a row passed the last evaluation.
+     *
+     * @param row The row.
+     * @return Whether the value passed.
+     */
+    bool passes(std::size_t row) const;
+
+    /**
+     * This is the method that returns whether a row is filtered by the table, or always passes.
+     *
+     * @param row The row.
+     * @return Whether the row is filtered.
+     */
+    bool isFiltered(std::size_t row) const;
+
+    /**
+     * This is the method that records the value of a row as sent.
+     *
+     * @param row The row.
+     * @param value The value that was sent.
+     * @param now The time at which the value was sent.
+     */
+    void accept(std::size_t row, double value, std::chrono::steady_clock::time_point now);
+
+    std::size_t size() const;
+
+private:
+    // The columns of the table
+    std::vector<double> m_sent;
+    std::vector<double> m_dueAt;
+    std::vector<double> m_deadbands;
+    std::vector<double> m_frequencyFilters;
+    std::vector<bool> m_filtered;
+
+    // Whether the rows always pass, as 1.0 or 0.0, so it's used in the same arithmetic as the values
+    std::vector<double> m_open;
+
+    // The rows that passed the last evaluation, one bit per row
+    std::vector<std::uint64_t> m_passing;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_DEADBANDTABLE_H
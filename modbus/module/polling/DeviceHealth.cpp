@@ -0,0 +1,35 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/polling/DeviceHealth.h"
+
+namespace wolkabout::modbus
+{
+std::string toString(DeviceStatus status)
+{
+    switch (status)
+    {
+    case DeviceStatus::ONLINE:
+        return "ONLINE";
+    case DeviceStatus::OFFLINE:
+        return "OFFLINE";
+    case DeviceStatus::QUARANTINED:
+        return "QUARANTINED";
+    }
+    return "";
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,80 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_DEVICEHEALTH_H
+#define WOLKGATEWAYMODBUSMODULE_DEVICEHEALTH_H
+
+#include "more_modbus/ModbusDevice.h"
+#include "more_modbus/RegisterMapping.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief The status of a device, as it is reported to the platform.
+ */
+enum class DeviceStatus
+{
+    ONLINE,
+    OFFLINE,
+    QUARANTINED
+};
+
+std::string toString(DeviceStatus status);
+
+/**
+ * @brief The rules by which unresponsive devices are quarantined.
+ * @details After the count of consecutive failed reads, the reads of the device are no longer issued. Instead, the
+ *          device is probed with a single register read, in intervals that double after every failed probe.
+ */
+struct HealthPolicy
+{
+    // Zero disables the quarantine
+    std::uint16_t failuresBeforeQuarantine = 3;
+    std::chrono::milliseconds probeInterval{1000};
+    std::chrono::milliseconds maxProbeInterval{60000};
+};
+
+/**
+ * @brief Runtime health of a single device, as it is tracked by the PollScheduler.
+ */
+struct DeviceHealth
+{
+    std::shared_ptr<more_modbus::ModbusDevice> device;
+
+    // The register that is read to check whether a quarantined device responds
+    more_modbus::RegisterType probeType;
+    std::uint16_t probeAddress;
+
+    // The last reported status, and the consecutive failed reads
+    bool reported = false;
+    DeviceStatus status = DeviceStatus::OFFLINE;
+    std::uint16_t failures = 0;
+
+    // The state of the quarantine
+    bool quarantined = false;
+    bool probing = false;
+    std::chrono::milliseconds probeInterval{0};
+    std::chrono::steady_clock::time_point nextProbe{};
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_DEVICEHEALTH_H
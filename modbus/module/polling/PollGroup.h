@@ -0,0 +1,131 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_POLLGROUP_H
+#define WOLKGATEWAYMODBUSMODULE_POLLGROUP_H
+
+#include "modbus/model/ModuleMapping.h"
+#include "modbus/module/polling/DeadbandTable.h"
+#include "modbus/module/polling/DeviceHealth.h"
+#include "more_modbus/ModbusDevice.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+struct PollGroup;
+
+/**
+ * @brief Runtime state of a single mapping of a single device, as it is tracked by the PollScheduler.
+ */
+struct PolledMapping
+{
+    // Identifying information
+    std::shared_ptr<more_modbus::ModbusDevice> device;
+    std::shared_ptr<more_modbus::RegisterMapping> mapping;
+    ModuleMapping configuration;
+
+    // The period in which the mapping is read, already resolved against the template and module
+    std::chrono::milliseconds pollPeriod;
+
+    // The group that reads the mapping, empty for write-only mappings
+    std::weak_ptr<PollGroup> group{};
+
+    // The last value that was accepted and reported, with the numeric value of the registers for the deadband
+    bool initialized = false;
+    std::vector<std::uint16_t> registers{};
+    double value = 0.0;
+    bool bit = false;
+    std::chrono::steady_clock::time_point acceptedAt{};
+
+    // The last value that was written, used for repeated writes
+    std::chrono::milliseconds repeat{0};
+    bool written = false;
+    std::vector<std::uint16_t> writtenRegisters{};
+    bool writtenBit = false;
+    std::chrono::steady_clock::time_point writtenAt{};
+
+    // The timer of the repeated write, assigned once the repeated write is set
+    std::optional<std::size_t> repeatTimer{};
+};
+
+/**
+ * @brief Consecutive numeric mappings of a group that have the same type and byte order, and are decoded out of the
+ *        response together.
+ */
+struct DecodeRun
+{
+    // The index of the first mapping in the group, and the count of mappings
+    std::size_t firstMapping;
+    std::size_t count;
+
+    // The offset of the first mapping in the response
+    std::uint16_t offset;
+
+    // The type of the values, with the count of registers each one takes up
+    more_modbus::OutputType type;
+    std::uint16_t width;
+    bool bigEndian;
+};
+
+/**
+ * @brief A single read request, covering a contiguous block of addresses of one device,
+ *        that is repeated with its own period.
+ */
+struct PollGroup
+{
+    std::shared_ptr<more_modbus::ModbusDevice> device;
+    more_modbus::RegisterType registerType;
+    std::uint16_t startAddress;
+    std::uint16_t count;
+    std::chrono::milliseconds period;
+    std::vector<std::shared_ptr<PolledMapping>> mappings;
+
+    // The health of the device, shared by all of its groups
+    std::shared_ptr<DeviceHealth> health{};
+
+    // The offset of the reads within the period, derived from the index of the device so the devices are not read
+    // together
+    std::chrono::milliseconds phase{0};
+
+    // When the group is supposed to be read next, and whether the read has been issued and not yet completed. Every
+    // time the read is scheduled it's counted, so the queue of the scheduler can tell the reads that were moved since.
+    std::chrono::steady_clock::time_point nextRead{};
+    std::uint64_t scheduled = 0;
+    bool inFlight = false;
+
+    // Whether the group was asked to be read ahead of all the others after a write
+    bool forced = false;
+
+    // The runs of numeric mappings, and the values decoded out of the last response, by the index of the mapping
+    std::vector<DecodeRun> decodeRuns{};
+    std::vector<double> values{};
+
+    // The filters of the mappings, checked against the decoded values all at once
+    DeadbandTable deadbands{};
+
+    // The hash of the last response that was handed to the mappings, and whether a response with the same hash can
+    // skip them, as none of the mappings would accept its values
+    std::uint64_t responseHash = 0;
+    bool settled = false;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_POLLGROUP_H
@@ -0,0 +1,1131 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/polling/PollScheduler.h"
+
+#include "core/utilities/Logger.h"
+#include "modbus/utilities/RegisterDecoder.h"
+#include "more_modbus/utilities/DataParsers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// The resolution of the repeated writes, the writes due within the same tick are sent together
+const std::chrono::milliseconds REPEAT_TICK{10};
+// The most registers and coils a single write request can carry
+const std::size_t MAX_WRITE_REGISTERS = 123;
+const std::size_t MAX_WRITE_COILS = 1968;
+// Requests issued within this time from the first one are counted as a single burst
+const std::chrono::milliseconds BURST_WINDOW{5};
+// The parameters of the 64-bit FNV-1a hash of the responses
+const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const std::uint64_t FNV_PRIME = 1099511628211ULL;
+}    // namespace
+
+PollScheduler::PollScheduler(std::shared_ptr<ModbusTransport> transport, ReadPlanner readPlanner,
+                             HealthPolicy healthPolicy, std::chrono::milliseconds readAfterWriteWindow)
+: m_transport(std::move(transport))
+, m_readPlanner(std::move(readPlanner))
+, m_healthPolicy(healthPolicy)
+, m_readAfterWriteWindow(readAfterWriteWindow)
+, m_epoch(std::chrono::steady_clock::now())
+, m_longestPeriod(0)
+, m_repeatWheel(REPEAT_TICK)
+, m_deviceCount(0)
+, m_pendingRequests(0)
+, m_running(false)
+{
+}
+
+PollScheduler::~PollScheduler()
+{
+    stop();
+}
+
+std::vector<std::shared_ptr<PollGroup>> PollScheduler::addDevice(
+  const std::shared_ptr<more_modbus::ModbusDevice>& device, const std::string& bus,
+  const std::vector<std::shared_ptr<PolledMapping>>& mappings, std::uint16_t maxInFlight)
+{
+    const auto groups = m_readPlanner.plan(device, mappings);
+    m_transport->addDevice(device, bus, maxInFlight);
+
+    // The probe is the first register of the first group, it's known to exist on the device
+    auto health = std::shared_ptr<DeviceHealth>{};
+    if (!groups.empty())
+    {
+        health = std::make_shared<DeviceHealth>(
+          DeviceHealth{device, groups.front()->registerType, groups.front()->startAddress});
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (const auto& mapping : mappings)
+        m_mappings.emplace(mapping->mapping.get(), mapping);
+    const auto now = std::chrono::steady_clock::now();
+    const auto deviceIndex = m_deviceCount++;
+    if (!groups.empty())
+    {
+        auto& schedule = m_devices[device.get()];
+        schedule.health = health;
+        schedule.groups.insert(schedule.groups.end(), groups.cbegin(), groups.cend());
+    }
+    for (const auto& group : groups)
+    {
+        group->health = health;
+        group->phase = phaseOf(deviceIndex, group->period);
+        scheduleRead(group, nextSlot(*group, now));
+        m_longestPeriod = std::max(m_longestPeriod, group->period);
+    }
+    LOG(DEBUG) << TAG << "Device '" << device->getName() << "' is read with " << groups.size() << " group(s).";
+    m_condition.notify_one();
+    return groups;
+}
+
+bool PollScheduler::isRunning() const
+{
+    return m_running;
+}
+
+void PollScheduler::start()
+{
+    if (m_running)
+        return;
+
+    m_transport->start();
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_epoch = std::chrono::steady_clock::now();
+        m_cycle = CycleState{m_epoch};
+        m_queuedReads = {};
+        for (const auto& device : m_devices)
+        {
+            for (const auto& group : device.second.groups)
+                scheduleRead(group, m_epoch + group->phase);
+        }
+        m_running = true;
+    }
+    m_thread = std::unique_ptr<std::thread>{new std::thread(&PollScheduler::run, this)};
+}
+
+void PollScheduler::stop()
+{
+    if (!m_running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_running = false;
+    }
+    m_condition.notify_all();
+    if (m_thread != nullptr && m_thread->joinable())
+        m_thread->join();
+    m_thread.reset();
+
+    // Requests of an asynchronous transport can still be in flight, and they complete into the scheduler
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    m_condition.wait(lock, [&] { return m_pendingRequests == 0; });
+}
+
+bool PollScheduler::writeMapping(const more_modbus::RegisterMapping& mapping, const std::vector<std::uint16_t>& values)
+{
+    const auto polled = [&] {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return findMapping(mapping);
+    }();
+    if (polled == nullptr)
+    {
+        LOG(WARN) << TAG << "Received a write for mapping '" << mapping.getReference() << "' that is not known.";
+        return false;
+    }
+    if (polled->configuration.getRegisterType() != more_modbus::RegisterType::HOLDING_REGISTER)
+    {
+        LOG(WARN) << TAG << "Can not write registers into mapping '" << mapping.getReference() << "'.";
+        return false;
+    }
+
+    // Strings are padded or cut to take up exactly the registers of the mapping
+    auto registers = values;
+    if (polled->configuration.getDataType() == more_modbus::OutputType::STRING)
+        registers.resize(ReadPlanner::addressSpan(polled->configuration), 0);
+
+    if (!waitForWrite([&](const ModbusTransport::WriteCallback& callback) {
+            writeRegisters(*polled, registers, ModbusTransport::Priority::WRITE, callback);
+        }))
+    {
+        LOG(WARN) << TAG << "Failed to write into mapping '" << mapping.getReference() << "'.";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    recordWrite(*polled, registers, false, std::chrono::steady_clock::now());
+    m_condition.notify_one();
+    return true;
+}
+
+bool PollScheduler::writeMapping(const more_modbus::RegisterMapping& mapping, bool value)
+{
+    const auto polled = [&] {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return findMapping(mapping);
+    }();
+    if (polled == nullptr)
+    {
+        LOG(WARN) << TAG << "Received a write for mapping '" << mapping.getReference() << "' that is not known.";
+        return false;
+    }
+
+    if (!waitForWrite([&](const ModbusTransport::WriteCallback& callback) {
+            writeBit(*polled, value, ModbusTransport::Priority::WRITE, callback);
+        }))
+    {
+        LOG(WARN) << TAG << "Failed to write into mapping '" << mapping.getReference() << "'.";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    recordWrite(*polled, {}, value, std::chrono::steady_clock::now());
+    m_condition.notify_one();
+    return true;
+}
+
+std::vector<bool> PollScheduler::writeMappings(const std::vector<MappingWrite>& writes)
+{
+    auto results = std::vector<bool>(writes.size(), false);
+    auto polled = std::vector<std::shared_ptr<PolledMapping>>(writes.size());
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        for (auto i = std::size_t{0}; i < writes.size(); ++i)
+            polled[i] = findMapping(*writes[i].mapping);
+    }
+    for (auto i = std::size_t{0}; i < writes.size(); ++i)
+    {
+        if (polled[i] == nullptr)
+            LOG(WARN) << TAG << "Received a write for mapping '" << writes[i].mapping->getReference()
+                      << "' that is not known.";
+    }
+
+    // All the requests are submitted first, so an asynchronous transport can send the blocks of different devices
+    // at the same time
+    const auto blocks = planWrites(polled, writes);
+    auto futures = std::vector<std::future<bool>>{};
+    for (const auto& block : blocks)
+    {
+        auto promise = std::make_shared<std::promise<bool>>();
+        futures.emplace_back(promise->get_future());
+        submitWrite(block, ModbusTransport::Priority::WRITE, [promise](bool success) { promise->set_value(success); });
+    }
+
+    for (auto i = std::size_t{0}; i < blocks.size(); ++i)
+    {
+        const auto success = futures[i].get();
+        for (const auto index : blocks[i].writes)
+            results[index] = success;
+        if (!success)
+            LOG(WARN) << TAG << "Failed to write " << blocks[i].writes.size() << " mapping(s) starting at address "
+                      << blocks[i].startAddress << " of device '" << blocks[i].device->getName() << "'.";
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto i = std::size_t{0}; i < writes.size(); ++i)
+    {
+        if (!results[i])
+            continue;
+        auto registers = writes[i].registers;
+        if (polled[i]->configuration.getDataType() == more_modbus::OutputType::STRING)
+            registers.resize(ReadPlanner::addressSpan(polled[i]->configuration), 0);
+        recordWrite(*polled[i], registers, writes[i].bit, now);
+    }
+    m_condition.notify_one();
+    return results;
+}
+
+void PollScheduler::forceReadOfMapping(const more_modbus::RegisterMapping& mapping)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto polled = findMapping(mapping);
+    if (polled == nullptr)
+        return;
+    const auto group = polled->group.lock();
+    if (group == nullptr || group->forced)
+        return;
+
+    // The first forced read of a device opens the window, the ones that follow join it
+    auto& device = m_devices.at(group->device.get());
+    if (device.forced == 0)
+    {
+        device.forcedAt = std::chrono::steady_clock::now() + m_readAfterWriteWindow;
+        m_forcedDevices.emplace_back(&device);
+    }
+    ++device.forced;
+    group->forced = true;
+    m_condition.notify_one();
+}
+
+void PollScheduler::setRepeatedWrite(const more_modbus::RegisterMapping& mapping, std::chrono::milliseconds repeat)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto polled = findMapping(mapping);
+    if (polled == nullptr)
+        return;
+
+    // The timer of the mapping is its index among the repeated mappings
+    polled->repeat = repeat;
+    if (!polled->repeatTimer)
+    {
+        polled->repeatTimer = m_repeatedMappings.size();
+        m_repeatedMappings.emplace_back(polled);
+    }
+    if (repeat.count() > 0 && polled->written)
+        m_repeatWheel.schedule(*polled->repeatTimer, polled->writtenAt + repeat);
+    else
+        m_repeatWheel.cancel(*polled->repeatTimer);
+    m_condition.notify_one();
+}
+
+PollScheduler::PollStatistics PollScheduler::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_statistics;
+}
+
+std::chrono::milliseconds PollScheduler::phaseOf(std::size_t deviceIndex, std::chrono::milliseconds period)
+{
+    auto index = static_cast<std::uint16_t>(deviceIndex);
+    auto reversed = std::uint32_t{0};
+    for (auto i = 0; i < 16; ++i)
+    {
+        reversed = (reversed << 1) | (index & 1u);
+        index = static_cast<std::uint16_t>(index >> 1);
+    }
+    return std::chrono::milliseconds{period.count() * reversed / 65536};
+}
+
+void PollScheduler::setOnStatusChange(const StatusCallback& onStatusChange)
+{
+    m_onStatusChange = onStatusChange;
+}
+
+void PollScheduler::setOnMappingValueChange(const BytesCallback& onMappingValueChange)
+{
+    m_onBytesChange = onMappingValueChange;
+}
+
+void PollScheduler::setOnMappingValueChange(const BoolCallback& onMappingValueChange)
+{
+    m_onBoolChange = onMappingValueChange;
+}
+
+void PollScheduler::setOnCycleComplete(const CycleCallback& onCycleComplete)
+{
+    m_onCycleComplete = onCycleComplete;
+}
+
+double PollScheduler::numericValue(const ModuleMapping& mapping, const std::vector<std::uint16_t>& registers)
+{
+    const auto endian = mapping.getOperationType() == more_modbus::OperationType::MERGE_LITTLE_ENDIAN ||
+                            mapping.getOperationType() == more_modbus::OperationType::MERGE_FLOAT_LITTLE_ENDIAN ?
+                          more_modbus::DataParsers::Endian::LITTLE :
+                          more_modbus::DataParsers::Endian::BIG;
+    switch (mapping.getDataType())
+    {
+    case more_modbus::OutputType::UINT16:
+        return registers[0];
+    case more_modbus::OutputType::INT16:
+        return static_cast<std::int16_t>(registers[0]);
+    case more_modbus::OutputType::UINT32:
+        return more_modbus::DataParsers::registersToUint32(registers, endian);
+    case more_modbus::OutputType::INT32:
+        return more_modbus::DataParsers::registersToInt32(registers, endian);
+    case more_modbus::OutputType::FLOAT:
+        return more_modbus::DataParsers::registersToFloat(registers, endian);
+    default:
+        return 0.0;
+    }
+}
+
+void PollScheduler::decodeValues(PollGroup& group, const std::vector<std::uint16_t>& registers)
+{
+    for (const auto& run : group.decodeRuns)
+    {
+        const auto available = registers.size() > run.offset ? (registers.size() - run.offset) / run.width : 0;
+        const auto count = std::min(run.count, available);
+        if (count == 0)
+            continue;
+        const auto source = registers.data() + run.offset;
+        const auto target = group.values.data() + run.firstMapping;
+        switch (run.type)
+        {
+        case more_modbus::OutputType::UINT16:
+            RegisterDecoder::decodeUint16(source, count, target);
+            break;
+        case more_modbus::OutputType::INT16:
+            RegisterDecoder::decodeInt16(source, count, target);
+            break;
+        case more_modbus::OutputType::UINT32:
+            RegisterDecoder::decodeUint32(source, count, run.bigEndian, target);
+            break;
+        case more_modbus::OutputType::INT32:
+            RegisterDecoder::decodeInt32(source, count, run.bigEndian, target);
+            break;
+        case more_modbus::OutputType::FLOAT:
+            RegisterDecoder::decodeFloat(source, count, run.bigEndian, target);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+std::uint64_t PollScheduler::hashResponse(const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits)
+{
+    auto hash = FNV_OFFSET_BASIS;
+    for (const auto value : registers)
+        hash = (hash ^ value) * FNV_PRIME;
+    for (const auto bit : bits)
+        hash = (hash ^ (bit ? 1u : 2u)) * FNV_PRIME;
+    return hash;
+}
+
+void PollScheduler::run()
+{
+    auto lock = std::unique_lock<std::mutex>{m_mutex};
+    while (m_running)
+    {
+        // Find the read, the probe or the repeated write that is due the soonest. The queued reads of groups that
+        // were scheduled again since, that are still being read, that are forced, or whose device is quarantined, are
+        // dropped - the groups are queued again once that is over. The forced groups of a device go ahead of
+        // everything else once their window closes.
+        const auto now = std::chrono::steady_clock::now();
+        auto due = std::chrono::steady_clock::time_point::max();
+        auto group = std::shared_ptr<PollGroup>{};
+        auto forced = static_cast<DeviceSchedule*>(nullptr);
+        auto probe = std::shared_ptr<DeviceHealth>{};
+        auto repeated = false;
+        while (!m_queuedReads.empty())
+        {
+            const auto& queued = m_queuedReads.top();
+            const auto& candidate = *queued.group;
+            if (queued.scheduled == candidate.scheduled && !candidate.inFlight && !candidate.forced &&
+                !candidate.health->quarantined)
+            {
+                due = queued.at;
+                group = queued.group;
+                break;
+            }
+            m_queuedReads.pop();
+        }
+        for (const auto candidate : m_forcedDevices)
+        {
+            if (candidate->health->quarantined ||
+                std::none_of(candidate->groups.cbegin(), candidate->groups.cend(),
+                             [](const std::shared_ptr<PollGroup>& other) { return other->forced && !other->inFlight; }))
+                continue;
+            const auto candidateDue =
+              candidate->forcedAt <= now ? std::chrono::steady_clock::time_point::min() : candidate->forcedAt;
+            if (candidateDue < due)
+            {
+                due = candidateDue;
+                group = nullptr;
+                forced = candidate;
+            }
+        }
+        for (const auto& candidate : m_quarantined)
+        {
+            if (!candidate->probing && candidate->nextProbe < due)
+            {
+                due = candidate->nextProbe;
+                group = nullptr;
+                forced = nullptr;
+                probe = candidate;
+            }
+        }
+        const auto repeatDue = m_repeatWheel.nextExpiry();
+        if (repeatDue < due)
+        {
+            due = repeatDue;
+            group = nullptr;
+            forced = nullptr;
+            probe = nullptr;
+            repeated = true;
+        }
+
+        // Wait for it, or for something to be rescheduled
+        if (due > now)
+        {
+            if (due == std::chrono::steady_clock::time_point::max())
+                m_condition.wait(lock);
+            else
+                m_condition.wait_until(lock, due);
+            continue;
+        }
+
+        // The requests are claimed before the lock is released, so an asynchronous transport can be handed the next
+        // one right away, without waiting for this one to complete
+        if (repeated)
+        {
+            const auto blocks = takeRepeatedWrites(now);
+            m_pendingRequests += blocks.size();
+            recordDispatch(now, blocks.size());
+            lock.unlock();
+            for (const auto& block : blocks)
+                repeatWrite(block);
+            lock.lock();
+            continue;
+        }
+        if (forced != nullptr)
+        {
+            const auto reads = takeForcedReads(*forced);
+            recordDispatch(now, reads.size());
+            lock.unlock();
+            for (const auto& read : reads)
+                readMerged(read);
+            lock.lock();
+            continue;
+        }
+
+        ++m_pendingRequests;
+        if (probe != nullptr)
+        {
+            probe->probing = true;
+            recordDispatch(now, 1);
+            lock.unlock();
+            probeDevice(probe);
+        }
+        else
+        {
+            m_queuedReads.pop();
+            group->inFlight = true;
+            ++m_devices.at(group->device.get()).inFlight;
+            recordDispatch(now, 1, now - group->nextRead);
+            lock.unlock();
+            readGroup(group);
+        }
+        lock.lock();
+    }
+}
+
+void PollScheduler::readGroup(const std::shared_ptr<PollGroup>& group)
+{
+    m_transport->read(*group->device, group->registerType, group->startAddress, group->count,
+                      ModbusTransport::Priority::POLL,
+                      [this, group](bool success, const std::vector<std::uint16_t>& registers,
+                                    const std::vector<bool>& bits) { completeRead(group, success, registers, bits);
+                      });
+}
+
+std::vector<PollScheduler::MergedRead> PollScheduler::takeForcedReads(DeviceSchedule& device)
+{
+    auto groups = std::vector<std::shared_ptr<PollGroup>>{};
+    if (device.health->quarantined)
+        return {};
+    for (const auto& group : device.groups)
+    {
+        if (group->forced && !group->inFlight)
+            groups.emplace_back(group);
+    }
+
+    for (const auto& group : groups)
+    {
+        group->forced = false;
+        group->inFlight = true;
+    }
+    device.forced -= groups.size();
+    device.inFlight += groups.size();
+    if (device.forced == 0)
+        m_forcedDevices.erase(std::remove(m_forcedDevices.begin(), m_forcedDevices.end(), &device),
+                              m_forcedDevices.end());
+    m_pendingRequests += groups.size();
+    return m_readPlanner.merge(groups);
+}
+
+void PollScheduler::readMerged(const MergedRead& read)
+{
+    const auto& first = read.front();
+    auto start = static_cast<std::uint32_t>(first->startAddress);
+    auto end = start;
+    for (const auto& group : read)
+    {
+        start = std::min<std::uint32_t>(start, group->startAddress);
+        end = std::max<std::uint32_t>(end, group->startAddress + group->count);
+    }
+
+    m_transport->read(
+      *first->device, first->registerType, static_cast<std::uint16_t>(start), static_cast<std::uint16_t>(end - start),
+      ModbusTransport::Priority::FORCED_READ,
+      [this, read, start](bool success, const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits) {
+          // Every group gets the part of the response it covers, as if it was read on its own
+          for (auto i = std::size_t{0}; i < read.size(); ++i)
+          {
+              const auto& group = read[i];
+              const auto offset = static_cast<std::size_t>(group->startAddress - start);
+              const auto slice = [&](const auto& values) {
+                  using Values = std::decay_t<decltype(values)>;
+                  if (offset >= values.size())
+                      return Values{};
+                  const auto last = std::min(values.size(), offset + group->count);
+                  return Values(values.cbegin() + static_cast<std::ptrdiff_t>(offset),
+                                values.cbegin() + static_cast<std::ptrdiff_t>(last));
+              };
+              completeRead(group, success, slice(registers), slice(bits), i == 0);
+          }
+      });
+}
+
+void PollScheduler::completeRead(const std::shared_ptr<PollGroup>& group, bool success,
+                                 const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits,
+                                 bool recordHealth)
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto changes = std::vector<ValueChange>{};
+    auto statusChanged = false;
+    auto status = DeviceStatus::ONLINE;
+    auto cycleComplete = true;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        auto& device = m_devices.at(group->device.get());
+        group->inFlight = false;
+        --device.inFlight;
+        statusChanged = recordHealth && recordRead(*group->health, success, now);
+        status = group->health->status;
+
+        // Schedule the next read, unless a forced read came ahead of it.
+        // If the bus can not keep up, the missed reads are skipped.
+        scheduleRead(group, group->nextRead <= now ? nextSlot(*group, now) : group->nextRead);
+
+        // A unit that did not respond would most likely time out on its other groups too. When many units share the
+        // connection, the other groups of the unit that are due are skipped, so they don't delay the other units.
+        if (!success)
+        {
+            for (const auto& other : device.groups)
+            {
+                if (other != group && !other->inFlight && other->nextRead <= now)
+                    scheduleRead(other, nextSlot(*other, now));
+            }
+        }
+        // A response that is the same as the last one can't change any of the mappings, unless one of them holds
+        // back a change for its frequency filter, or takes every sample for its aggregation
+        else if (const auto hash = hashResponse(registers, bits); !group->settled || hash != group->responseHash)
+        {
+            group->responseHash = hash;
+            group->settled = true;
+            decodeValues(*group, registers);
+            if (group->deadbands.evaluate(group->values.data(), now))
+                group->settled = false;
+
+            // Only the mappings that passed the table are looked at one by one
+            for (auto index = std::size_t{0}; index < group->mappings.size(); ++index)
+            {
+                if (!group->deadbands.passes(index))
+                    continue;
+                const auto& mapping = group->mappings[index];
+                const auto& configuration = mapping->configuration;
+                const auto offset = static_cast<std::size_t>(configuration.getAddress() - group->startAddress);
+                if (configuration.getDataType() == more_modbus::OutputType::BOOL)
+                {
+                    auto bit = false;
+                    if (group->registerType == more_modbus::RegisterType::COIL ||
+                        group->registerType == more_modbus::RegisterType::INPUT_CONTACT)
+                    {
+                        if (offset >= bits.size())
+                            continue;
+                        bit = bits[offset];
+                    }
+                    else
+                    {
+                        if (offset >= registers.size())
+                            continue;
+                        if (configuration.getOperationType() == more_modbus::OperationType::TAKE_BIT)
+                            bit = ((registers[offset] >> configuration.getBitIndex()) & 1) != 0;
+                        else
+                            bit = registers[offset] != 0;
+                    }
+                    if (acceptBit(*mapping, bit, now))
+                        changes.emplace_back(ValueChange{mapping, {}, bit});
+                    else if (mapping->bit != bit && configuration.getFrequencyFilterValue().count() > 0)
+                        group->settled = false;
+                }
+                else
+                {
+                    const auto span = ReadPlanner::addressSpan(configuration);
+                    if (offset + span > registers.size())
+                        continue;
+                    const auto first = registers.cbegin() + static_cast<std::ptrdiff_t>(offset);
+                    const auto last = first + static_cast<std::ptrdiff_t>(span);
+                    if (configuration.isAggregated())
+                        group->settled = false;
+                    if (acceptRegisters(*mapping, first, last, group->values[index],
+                                        group->deadbands.isFiltered(index), now))
+                    {
+                        group->deadbands.accept(index, group->values[index], now);
+                        changes.emplace_back(ValueChange{mapping, mapping->registers, false});
+                    }
+                    else if (!std::equal(first, last, mapping->registers.cbegin(), mapping->registers.cend()) &&
+                             configuration.getFrequencyFilterValue().count() > 0)
+                        group->settled = false;
+                }
+            }
+        }
+
+        // The cycle of the device is complete once none of its groups is still being read, or due to be read
+        cycleComplete =
+          device.inFlight == 0 &&
+          (device.health->quarantined ||
+           std::none_of(device.groups.cbegin(), device.groups.cend(),
+                        [&](const std::shared_ptr<PollGroup>& other) { return other->nextRead <= now; }));
+    }
+
+    if (statusChanged)
+        reportStatus(group->device, status);
+    for (const auto& change : changes)
+    {
+        if (change.mapping->configuration.getDataType() == more_modbus::OutputType::BOOL)
+        {
+            if (m_onBoolChange)
+                m_onBoolChange(change.mapping->device, change.mapping->mapping, change.bit);
+        }
+        else if (m_onBytesChange)
+        {
+            m_onBytesChange(change.mapping->device, change.mapping->mapping, change.registers);
+        }
+    }
+    if (cycleComplete && m_onCycleComplete)
+        m_onCycleComplete(group->device);
+    completeRequest();
+}
+
+void PollScheduler::probeDevice(const std::shared_ptr<DeviceHealth>& health)
+{
+    m_transport->read(*health->device, health->probeType, health->probeAddress, 1, ModbusTransport::Priority::POLL,
+                      [this, health](bool success, const std::vector<std::uint16_t>&, const std::vector<bool>&) {
+                          completeProbe(health, success);
+                      });
+}
+
+void PollScheduler::completeProbe(const std::shared_ptr<DeviceHealth>& health, bool success)
+{
+    auto statusChanged = false;
+    auto status = DeviceStatus::ONLINE;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        health->probing = false;
+        if (success)
+        {
+            statusChanged = recordRead(*health, true, std::chrono::steady_clock::now());
+        }
+        else if (health->quarantined)
+        {
+            health->probeInterval = std::min(health->probeInterval * 2, m_healthPolicy.maxProbeInterval);
+            health->nextProbe = std::chrono::steady_clock::now() + health->probeInterval;
+            LOG(DEBUG) << TAG << "Device '" << health->device->getName()
+                       << "' did not respond to the probe. Next probe in " << health->probeInterval.count() << "ms.";
+        }
+        status = health->status;
+    }
+
+    if (statusChanged)
+        reportStatus(health->device, status);
+    completeRequest();
+}
+
+void PollScheduler::scheduleRead(const std::shared_ptr<PollGroup>& group, std::chrono::steady_clock::time_point at)
+{
+    group->nextRead = at;
+    m_queuedReads.push(QueuedRead{at, ++group->scheduled, group});
+}
+
+std::chrono::steady_clock::time_point PollScheduler::nextSlot(const PollGroup& group,
+                                                              std::chrono::steady_clock::time_point after) const
+{
+    const auto first = m_epoch + group.phase;
+    if (after < first || group.period.count() <= 0)
+        return std::max(first, after);
+    return first + ((after - first) / group.period + 1) * group.period;
+}
+
+void PollScheduler::recordDispatch(std::chrono::steady_clock::time_point now, std::size_t requests,
+                                   std::optional<std::chrono::steady_clock::duration> jitter)
+{
+    if (requests == 0)
+        return;
+
+    auto& cycle = m_cycle;
+    cycle.requests += requests;
+    if (jitter)
+    {
+        ++cycle.polls;
+        cycle.jitterSum += *jitter;
+        cycle.maxJitter = std::max(cycle.maxJitter, *jitter);
+    }
+    if (cycle.burstSize == 0 || now - cycle.burstStart > BURST_WINDOW)
+    {
+        ++cycle.bursts;
+        cycle.burstSize = 0;
+        cycle.burstStart = now;
+    }
+    cycle.burstSize += requests;
+    cycle.maxBurst = std::max(cycle.maxBurst, cycle.burstSize);
+
+    // The cycle is as long as the longest period, so every group is read in it at least once
+    if (now - cycle.start < m_longestPeriod)
+        return;
+
+    using namespace std::chrono;
+    m_statistics.cycle = duration_cast<milliseconds>(now - cycle.start);
+    m_statistics.requests = cycle.requests;
+    m_statistics.meanJitter =
+      cycle.polls > 0 ? duration_cast<microseconds>(cycle.jitterSum / cycle.polls) : microseconds{0};
+    m_statistics.maxJitter = duration_cast<microseconds>(cycle.maxJitter);
+    m_statistics.meanBurst = static_cast<double>(cycle.requests) / static_cast<double>(cycle.bursts);
+    m_statistics.maxBurst = cycle.maxBurst;
+    LOG(DEBUG) << TAG << "Issued " << m_statistics.requests << " request(s) in " << m_statistics.cycle.count()
+               << "ms, the jitter is " << m_statistics.meanJitter.count() << "us on average and "
+               << m_statistics.maxJitter.count() << "us at most, the bursts are " << m_statistics.meanBurst
+               << " request(s) on average and " << m_statistics.maxBurst << " at most.";
+    m_cycle = CycleState{now};
+}
+
+bool PollScheduler::recordRead(DeviceHealth& health, bool success, std::chrono::steady_clock::time_point now)
+{
+    auto status = DeviceStatus::ONLINE;
+    if (success)
+    {
+        health.failures = 0;
+        if (health.quarantined)
+        {
+            // The device is read right away, the reads were skipped for a while
+            health.quarantined = false;
+            m_quarantined.erase(std::remove_if(m_quarantined.begin(), m_quarantined.end(),
+                                               [&](const std::shared_ptr<DeviceHealth>& quarantined) {
+                                                   return quarantined.get() == &health;
+                                               }),
+                                m_quarantined.end());
+            for (const auto& group : m_devices.at(health.device.get()).groups)
+                scheduleRead(group, now);
+            LOG(INFO) << TAG << "Device '" << health.device->getName() << "' responded, ending the quarantine.";
+        }
+    }
+    else
+    {
+        // Reads that were in flight when the quarantine started don't count
+        if (health.quarantined)
+            return false;
+
+        if (health.failures < std::numeric_limits<std::uint16_t>::max())
+            ++health.failures;
+        status = DeviceStatus::OFFLINE;
+        if (m_healthPolicy.failuresBeforeQuarantine > 0 && health.failures >= m_healthPolicy.failuresBeforeQuarantine)
+        {
+            health.quarantined = true;
+            health.probeInterval = m_healthPolicy.probeInterval;
+            health.nextProbe = now + health.probeInterval;
+            m_quarantined.emplace_back(m_devices.at(health.device.get()).health);
+            status = DeviceStatus::QUARANTINED;
+            LOG(WARN) << TAG << "Device '" << health.device->getName() << "' failed " << health.failures
+                      << " reads in a row. Its reads are suspended until it responds to a probe.";
+        }
+    }
+
+    if (health.reported && health.status == status)
+        return false;
+    health.reported = true;
+    health.status = status;
+    return true;
+}
+
+std::vector<PollScheduler::WriteBlock> PollScheduler::takeRepeatedWrites(std::chrono::steady_clock::time_point now)
+{
+    auto mappings = std::vector<std::shared_ptr<PolledMapping>>{};
+    auto writes = std::vector<MappingWrite>{};
+    for (const auto timer : m_repeatWheel.advance(now))
+    {
+        const auto& mapping = m_repeatedMappings[timer];
+        if (mapping->repeat.count() <= 0 || !mapping->written)
+            continue;
+
+        // Mappings with the same period keep expiring in the same tick, so they stay batched
+        mapping->writtenAt = now;
+        m_repeatWheel.schedule(timer, now + mapping->repeat);
+        mappings.emplace_back(mapping);
+        writes.emplace_back(MappingWrite{mapping->mapping, mapping->writtenRegisters, mapping->writtenBit});
+    }
+    return planWrites(mappings, writes);
+}
+
+void PollScheduler::repeatWrite(const WriteBlock& block)
+{
+    // The repeated writes keep the values in place, they are not urgent like the writes from the platform
+    const auto device = block.device;
+    const auto address = block.startAddress;
+    const auto count = block.writes.size();
+    submitWrite(block, ModbusTransport::Priority::POLL, [this, device, address, count](bool success) {
+        if (!success)
+            LOG(WARN) << TAG << "Failed to repeat the write of " << count << " mapping(s) starting at address "
+                      << address << " of device '" << device->getName() << "'.";
+        completeRequest();
+    });
+}
+
+void PollScheduler::completeRequest()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_pendingRequests;
+    }
+    m_condition.notify_all();
+}
+
+std::vector<PollScheduler::WriteBlock> PollScheduler::planWrites(
+  const std::vector<std::shared_ptr<PolledMapping>>& mappings, const std::vector<MappingWrite>& writes) const
+{
+    // Every write becomes a single block at first. Boolean mappings that take a bit of a register need the rest of
+    // the register, so they are written on their own.
+    auto blocks = std::vector<WriteBlock>{};
+    for (auto i = std::size_t{0}; i < mappings.size(); ++i)
+    {
+        if (mappings[i] == nullptr)
+            continue;
+
+        const auto& configuration = mappings[i]->configuration;
+        const auto& device = mappings[i]->device;
+        const auto address = static_cast<std::uint16_t>(configuration.getAddress());
+        if (configuration.getDataType() == more_modbus::OutputType::BOOL)
+        {
+            if (configuration.getRegisterType() == more_modbus::RegisterType::COIL)
+                blocks.emplace_back(
+                  WriteBlock{device, more_modbus::RegisterType::COIL, address, {}, {writes[i].bit}, {i}, nullptr});
+            else if (configuration.getRegisterType() == more_modbus::RegisterType::HOLDING_REGISTER &&
+                     configuration.getOperationType() != more_modbus::OperationType::TAKE_BIT)
+                blocks.emplace_back(WriteBlock{device, more_modbus::RegisterType::HOLDING_REGISTER, address,
+                                               {static_cast<std::uint16_t>(writes[i].bit)}, {}, {i}, nullptr});
+            else
+                blocks.emplace_back(WriteBlock{device, configuration.getRegisterType(), address, {}, {writes[i].bit},
+                                               {i}, mappings[i]});
+        }
+        else if (configuration.getRegisterType() == more_modbus::RegisterType::HOLDING_REGISTER &&
+                 !writes[i].registers.empty())
+        {
+            auto registers = writes[i].registers;
+            if (configuration.getDataType() == more_modbus::OutputType::STRING)
+                registers.resize(ReadPlanner::addressSpan(configuration), 0);
+            blocks.emplace_back(
+              WriteBlock{device, more_modbus::RegisterType::HOLDING_REGISTER, address, registers, {}, {i}, nullptr});
+        }
+        else
+        {
+            LOG(WARN) << TAG << "Can not write registers into mapping '" << configuration.getReference() << "'.";
+        }
+    }
+
+    // Blocks that follow one another on the same device are merged, as long as the request can carry them
+    std::sort(blocks.begin(), blocks.end(), [](const WriteBlock& lhs, const WriteBlock& rhs) {
+        return std::make_tuple(lhs.device.get(), lhs.registerType, lhs.startAddress) <
+               std::make_tuple(rhs.device.get(), rhs.registerType, rhs.startAddress);
+    });
+    auto merged = std::vector<WriteBlock>{};
+    for (auto& block : blocks)
+    {
+        if (!merged.empty() && merged.back().bitMapping == nullptr && block.bitMapping == nullptr)
+        {
+            auto& last = merged.back();
+            const auto isCoil = block.registerType == more_modbus::RegisterType::COIL;
+            const auto size = isCoil ? last.bits.size() : last.registers.size();
+            const auto added = isCoil ? block.bits.size() : block.registers.size();
+            if (last.device == block.device && last.registerType == block.registerType &&
+                last.startAddress + size == block.startAddress &&
+                size + added <= (isCoil ? MAX_WRITE_COILS : MAX_WRITE_REGISTERS))
+            {
+                last.registers.insert(last.registers.end(), block.registers.cbegin(), block.registers.cend());
+                last.bits.insert(last.bits.end(), block.bits.cbegin(), block.bits.cend());
+                last.writes.insert(last.writes.end(), block.writes.cbegin(), block.writes.cend());
+                continue;
+            }
+        }
+        merged.emplace_back(std::move(block));
+    }
+    return merged;
+}
+
+void PollScheduler::submitWrite(const WriteBlock& block, ModbusTransport::Priority priority,
+                                const ModbusTransport::WriteCallback& callback)
+{
+    if (block.bitMapping != nullptr)
+        writeBit(*block.bitMapping, block.bits.front(), priority, callback);
+    else if (block.registerType == more_modbus::RegisterType::COIL)
+        m_transport->writeCoils(*block.device, block.startAddress, block.bits, priority, callback);
+    else
+        m_transport->writeRegisters(*block.device, block.startAddress, block.registers, priority, callback);
+}
+
+void PollScheduler::recordWrite(PolledMapping& mapping, const std::vector<std::uint16_t>& registers, bool bit,
+                                std::chrono::steady_clock::time_point now)
+{
+    mapping.written = true;
+    mapping.writtenRegisters = registers;
+    mapping.writtenBit = bit;
+    mapping.writtenAt = now;
+    if (mapping.configuration.isAutoLocalUpdate())
+    {
+        mapping.initialized = true;
+        mapping.registers = registers;
+        if (!registers.empty())
+            mapping.value = numericValue(mapping.configuration, registers);
+        mapping.bit = bit;
+        mapping.acceptedAt = now;
+
+        // The local value may differ from the one the group last read, so the next response can't be skipped, and the
+        // table of the group needs to compare against the local value
+        if (const auto group = mapping.group.lock())
+        {
+            group->settled = false;
+            const auto it =
+              std::find_if(group->mappings.cbegin(), group->mappings.cend(),
+                           [&](const std::shared_ptr<PolledMapping>& polled) { return polled.get() == &mapping; });
+            if (it != group->mappings.cend())
+                group->deadbands.accept(static_cast<std::size_t>(it - group->mappings.cbegin()), mapping.value, now);
+        }
+    }
+
+    // The repeated write starts counting from the last write
+    if (mapping.repeatTimer && mapping.repeat.count() > 0)
+        m_repeatWheel.schedule(*mapping.repeatTimer, now + mapping.repeat);
+}
+
+bool PollScheduler::waitForWrite(const std::function<void(const ModbusTransport::WriteCallback&)>& write)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+    write([promise](bool success) { promise->set_value(success); });
+    return future.get();
+}
+
+void PollScheduler::writeRegisters(const PolledMapping& mapping, const std::vector<std::uint16_t>& values,
+                                   ModbusTransport::Priority priority, const ModbusTransport::WriteCallback& callback)
+{
+    if (values.empty())
+    {
+        callback(false);
+        return;
+    }
+    m_transport->writeRegisters(*mapping.device, static_cast<std::uint16_t>(mapping.configuration.getAddress()), values,
+                                priority, callback);
+}
+
+void PollScheduler::writeBit(const PolledMapping& mapping, bool value, ModbusTransport::Priority priority,
+                             const ModbusTransport::WriteCallback& callback)
+{
+    const auto& device = mapping.device;
+    const auto address = static_cast<std::uint16_t>(mapping.configuration.getAddress());
+    switch (mapping.configuration.getRegisterType())
+    {
+    case more_modbus::RegisterType::COIL:
+        m_transport->writeCoil(*device, address, value, priority, callback);
+        return;
+    case more_modbus::RegisterType::HOLDING_REGISTER:
+    {
+        if (mapping.configuration.getOperationType() != more_modbus::OperationType::TAKE_BIT)
+        {
+            m_transport->writeRegisters(*device, address, {static_cast<std::uint16_t>(value)}, priority, callback);
+            return;
+        }
+
+        // The other bits of the register need to be kept as they are
+        const auto mask = static_cast<std::uint16_t>(1u << mapping.configuration.getBitIndex());
+        m_transport->read(*device, more_modbus::RegisterType::HOLDING_REGISTER, address, 1, priority,
+                          [this, device, address, mask, value, priority, callback](
+                            bool success, const std::vector<std::uint16_t>& registers, const std::vector<bool>&) {
+                              if (!success || registers.empty())
+                              {
+                                  callback(false);
+                                  return;
+                              }
+                              const auto newValue = static_cast<std::uint16_t>(value ? registers.front() | mask :
+                                                                                       registers.front() & ~mask);
+                              m_transport->writeRegisters(*device, address, {newValue}, priority, callback);
+                          });
+        return;
+    }
+    default:
+        callback(false);
+    }
+}
+
+bool PollScheduler::acceptRegisters(PolledMapping& mapping, std::vector<std::uint16_t>::const_iterator first,
+                                    std::vector<std::uint16_t>::const_iterator last, double value, bool filtered,
+                                    std::chrono::steady_clock::time_point now)
+{
+    // The table of the group already decided on the deadband and the frequency filter of the mappings it filters, and
+    // aggregated mappings take every sample, their statistics are sent out once per window instead. What's left are
+    // the strings.
+    if (mapping.initialized && !filtered && !mapping.configuration.isAggregated())
+    {
+        if (std::equal(first, last, mapping.registers.cbegin(), mapping.registers.cend()))
+            return false;
+
+        const auto& configuration = mapping.configuration;
+        if (configuration.getFrequencyFilterValue().count() > 0 &&
+            now - mapping.acceptedAt < configuration.getFrequencyFilterValue())
+            return false;
+    }
+
+    mapping.initialized = true;
+    mapping.registers.assign(first, last);
+    mapping.value = value;
+    mapping.acceptedAt = now;
+    return true;
+}
+
+bool PollScheduler::acceptBit(PolledMapping& mapping, bool bit, std::chrono::steady_clock::time_point now)
+{
+    if (mapping.initialized)
+    {
+        if (mapping.bit == bit)
+            return false;
+
+        const auto& configuration = mapping.configuration;
+        if (configuration.getFrequencyFilterValue().count() > 0 &&
+            now - mapping.acceptedAt < configuration.getFrequencyFilterValue())
+            return false;
+    }
+
+    mapping.initialized = true;
+    mapping.bit = bit;
+    mapping.acceptedAt = now;
+    return true;
+}
+
+void PollScheduler::reportStatus(const std::shared_ptr<more_modbus::ModbusDevice>& device, DeviceStatus status)
+{
+    if (m_onStatusChange)
+        m_onStatusChange(device, status);
+}
+
+std::shared_ptr<PolledMapping> PollScheduler::findMapping(const more_modbus::RegisterMapping& mapping) const
+{
+    const auto it = m_mappings.find(&mapping);
+    return it != m_mappings.cend() ? it->second : nullptr;
+}
+}    // namespace wolkabout::modbus
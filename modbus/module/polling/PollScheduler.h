@@ -0,0 +1,589 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_POLLSCHEDULER_H
+#define WOLKGATEWAYMODBUSMODULE_POLLSCHEDULER_H
+
+#include "modbus/module/polling/DeviceHealth.h"
+#include "modbus/module/polling/PollGroup.h"
+#include "modbus/module/polling/ReadPlanner.h"
+#include "modbus/module/polling/TimerWheel.h"
+#include "modbus/module/transport/ModbusTransport.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout
+{
+namespace modbus
+{
+/**
+ * @brief Class that reads the mappings of Modbus devices, where every group of mappings is read in its own period.
+ * @details The scheduler owns a single thread that always issues the read that is due the soonest. With an
+ *          asynchronous transport, many reads are in flight at once, and they complete from the transport thread.
+ *          Groups are planned by the ReadPlanner out of mappings of a device that share the register type and the
+ *          period, so a slow changing mapping does not cost as much bus time as a fast one. The devices are spread
+ *          across the period by the order in which they were added, so their reads, and the changes they produce,
+ *          don't all come in the same burst, even when they share the slave address on different connections.
+ *          Values that changed are reported through the callbacks, after the deadband and frequency filters. Once
+ *          all the groups of a device that were due together are read, the end of the poll cycle of the device is
+ *          reported too, so the changes can be sent out together.
+ *          A device that keeps failing is quarantined according to the HealthPolicy - its groups are not read, and
+ *          it's probed with a single register read until it responds.
+ *          Repeated writes are kept in a timer wheel, and the ones that are due in the same tick are batched per
+ *          device.
+ *          Writes are sent through the write lane of the transport, and forced reads through the lane below it, so
+ *          both get ahead of the polls that are waiting for the bus. Forced reads of a device are collected for the
+ *          read-after-write window, and merged into as few read requests as possible.
+ */
+class PollScheduler
+{
+public:
+    using StatusCallback = std::function<void(const std::shared_ptr<more_modbus::ModbusDevice>&, DeviceStatus)>;
+    using BytesCallback = std::function<void(const std::shared_ptr<more_modbus::ModbusDevice>&,
+                                             const std::shared_ptr<more_modbus::RegisterMapping>&,
+                                             const std::vector<std::uint16_t>&)>;
+    using BoolCallback = std::function<void(const std::shared_ptr<more_modbus::ModbusDevice>&,
+                                            const std::shared_ptr<more_modbus::RegisterMapping>&, bool)>;
+    using CycleCallback = std::function<void(const std::shared_ptr<more_modbus::ModbusDevice>&)>;
+
+    // A value that needs to be written into a mapping, as registers, or as a bit for boolean mappings
+    struct MappingWrite
+    {
+        std::shared_ptr<more_modbus::RegisterMapping> mapping;
+        std::vector<std::uint16_t> registers;
+        bool bit;
+    };
+
+    // The load of the scheduler over a single cycle, which is as long as the longest period of the groups
+    struct PollStatistics
+    {
+        std::chrono::milliseconds cycle{0};
+        std::size_t requests = 0;
+
+        // How late the polls were issued after their scheduled time
+        std::chrono::microseconds meanJitter{0};
+        std::chrono::microseconds maxJitter{0};
+
+        // The count of requests issued together, within the burst window
+        double meanBurst = 0.0;
+        std::size_t maxBurst = 0;
+    };
+
+    /**
+     * Default constructor for the scheduler.
+     *
+     * @param transport The transport through which all the requests are sent.
+     * @param readPlanner The planner that merges the mappings of devices into read requests.
+     * @param healthPolicy The rules by which unresponsive devices are quarantined.
+     * @param readAfterWriteWindow The time for which the forced reads of a device are collected before being issued.
+     */
+    explicit PollScheduler(std::shared_ptr<ModbusTransport> transport, ReadPlanner readPlanner = ReadPlanner{},
+                           HealthPolicy healthPolicy = HealthPolicy{},
+                           std::chrono::milliseconds readAfterWriteWindow = std::chrono::milliseconds{0});
+
+    /**
+     * Default destructor.
+     * Will stop the scheduler thread, and wait for the requests in flight.
+     */
+    virtual ~PollScheduler();
+
+    /**
+     * This is the method that adds a device with all of its mappings into the scheduler.
+     * The mappings are split into groups that will be read. Write-only mappings are not read, but can be written.
+     *
+     * @param device The device to which the mappings belong.
+     * @param bus The name of the bus the device is on.
+     * @param mappings The mappings of the device, with their poll period resolved.
+     * @param maxInFlight The count of requests the device can have in flight, if the transport can pipeline them.
+     * @return The groups that were planned for the device.
+     */
+    std::vector<std::shared_ptr<PollGroup>> addDevice(const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                                      const std::string& bus,
+                                                      const std::vector<std::shared_ptr<PolledMapping>>& mappings,
+                                                      std::uint16_t maxInFlight = 1);
+
+    /**
+     * This is the method that returns whether the scheduler thread is running.
+     *
+     * @return Whether the scheduler thread is running.
+     */
+    bool isRunning() const;
+
+    /**
+     * This is the method that starts the transport and the scheduler thread. All groups are read immediately.
+     */
+    void start();
+
+    /**
+     * This is the method that stops the scheduler thread. The transport is left running, as it can be shared.
+     */
+    void stop();
+
+    /**
+     * This is the method that writes register values into a mapping.
+     *
+     * @param mapping The mapping that needs to be written.
+     * @param values The register values that need to be written.
+     * @return Whether the write was successful.
+     */
+    bool writeMapping(const more_modbus::RegisterMapping& mapping, const std::vector<std::uint16_t>& values);
+
+    /**
+     * This is the method that writes a boolean value into a mapping.
+     *
+     * @param mapping The mapping that needs to be written.
+     * @param value The value that needs to be written.
+     * @return Whether the write was successful.
+     */
+    bool writeMapping(const more_modbus::RegisterMapping& mapping, bool value);
+
+    /**
+     * This is the method that writes values into many mappings at once. The values are grouped per device and per
+     * contiguous block of addresses, and every block is written with a single request. The blocks of all devices
+     * are submitted before waiting for any of them.
+     *
+     * @param writes The values that need to be written.
+     * @return Whether each of the values was written, in the order of the writes.
+     */
+    std::vector<bool> writeMappings(const std::vector<MappingWrite>& writes);
+
+    /**
+     * This is the method that schedules the group containing the mapping to be read ahead of all the other groups.
+     * The read is issued once the read-after-write window of the device closes, together with the other forced
+     * reads of the device.
+     *
+     * @param mapping The mapping that needs to be read.
+     */
+    void forceReadOfMapping(const more_modbus::RegisterMapping& mapping);
+
+    /**
+     * This is the method that sets the period in which the last written value of the mapping is written again.
+     *
+     * @param mapping The mapping for which the repeated write is set.
+     * @param repeat The period of the repeated write. Zero disables the repeated write.
+     */
+    void setRepeatedWrite(const more_modbus::RegisterMapping& mapping, std::chrono::milliseconds repeat);
+
+    /**
+     * This is the method that returns the statistics of the last completed cycle. The statistics are copied under the
+     * lock, so it can be called from any thread.
+     *
+     * @return The statistics.
+     */
+    PollStatistics getStatistics() const;
+
+    /**
+     * This is the method that calculates the offset of the reads of a device within a period. The indexes of the
+     * devices are bit reversed, so any count of devices added one after the other is spread evenly across the period.
+     *
+     * @param deviceIndex The index of the device, in the order in which the devices were added to the scheduler.
+     * @param period The period.
+     * @return The offset within the period.
+     */
+    static std::chrono::milliseconds phaseOf(std::size_t deviceIndex, std::chrono::milliseconds period);
+
+    /**
+     * @brief Setter for the callback invoked once a device changes its status.
+     * @param onStatusChange The callback.
+     */
+    void setOnStatusChange(const StatusCallback& onStatusChange);
+
+    /**
+     * @brief Setter for the callback invoked once a non-boolean mapping changes its value.
+     * @param onMappingValueChange The callback.
+     */
+    void setOnMappingValueChange(const BytesCallback& onMappingValueChange);
+
+    /**
+     * @brief Setter for the callback invoked once a boolean mapping changes its value.
+     * @param onMappingValueChange The callback.
+     */
+    void setOnMappingValueChange(const BoolCallback& onMappingValueChange);
+
+    /**
+     * @brief Setter for the callback invoked once a device completed its poll cycle, after all of its changes.
+     * @param onCycleComplete The callback.
+     */
+    void setOnCycleComplete(const CycleCallback& onCycleComplete);
+
+private:
+    // Writes of adjacent addresses of a device, that are sent as a single request
+    struct WriteBlock
+    {
+        std::shared_ptr<more_modbus::ModbusDevice> device;
+        more_modbus::RegisterType registerType;
+        std::uint16_t startAddress;
+        std::vector<std::uint16_t> registers;
+        std::vector<bool> bits;
+        std::vector<std::size_t> writes;
+
+        // The mapping taking a bit of a register, written on its own with a read-modify-write
+        std::shared_ptr<PolledMapping> bitMapping;
+    };
+
+    // Groups of a device read with a single request
+    using MergedRead = std::vector<std::shared_ptr<PollGroup>>;
+
+    // A scheduled read of a group, in the queue of the reads ordered by their time. It's only valid as long as the
+    // group wasn't scheduled again since.
+    struct QueuedRead
+    {
+        std::chrono::steady_clock::time_point at;
+        std::uint64_t scheduled;
+        std::shared_ptr<PollGroup> group;
+
+        bool operator>(const QueuedRead& other) const { return at > other.at; }
+    };
+
+    // The groups of a device, with the count of them being read, and the forced ones with the time they're read at
+    struct DeviceSchedule
+    {
+        std::shared_ptr<DeviceHealth> health;
+        std::vector<std::shared_ptr<PollGroup>> groups;
+        std::size_t inFlight = 0;
+        std::size_t forced = 0;
+        std::chrono::steady_clock::time_point forcedAt{};
+    };
+
+    // The statistics of the cycle in progress
+    struct CycleState
+    {
+        std::chrono::steady_clock::time_point start{};
+        std::size_t requests = 0;
+        std::size_t polls = 0;
+        std::chrono::steady_clock::duration jitterSum{0};
+        std::chrono::steady_clock::duration maxJitter{0};
+        std::size_t bursts = 0;
+        std::size_t maxBurst = 0;
+        std::size_t burstSize = 0;
+        std::chrono::steady_clock::time_point burstStart{};
+    };
+
+    // A value change that is reported once the state lock has been released
+    struct ValueChange
+    {
+        std::shared_ptr<PolledMapping> mapping;
+        std::vector<std::uint16_t> registers;
+        bool bit;
+    };
+
+    /**
+     * This is a helper method that returns the numeric value of registers for the deadband filter.
+     *
+     * @param mapping The mapping configuration, describing the data type.
+     * @param registers The registers of the mapping.
+     * @return The numeric value.
+     */
+    static double numericValue(const ModuleMapping& mapping, const std::vector<std::uint16_t>& registers);
+
+    /**
+     * This is a helper method that decodes the values of all the numeric mappings of a group out of its response, one
+     * run of consecutive values at a time. Called under the state lock.
+     *
+     * @param group The group that has been read.
+     * @param registers The registers of the response.
+     */
+    static void decodeValues(PollGroup& group, const std::vector<std::uint16_t>& registers);
+
+    /**
+     * This is a helper method that returns the 64-bit FNV-1a hash of a response, used to find responses that did not
+     * change since the last one.
+     *
+     * @param registers The registers of the response.
+     * @param bits The bits of the response.
+     * @return The hash.
+     */
+    static std::uint64_t hashResponse(const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits);
+
+    /**
+     * This is the method executed by the scheduler thread.
+     */
+    void run();
+
+    /**
+     * This is a helper method that issues the read of a group.
+     *
+     * @param group The group that needs to be read.
+     */
+    void readGroup(const std::shared_ptr<PollGroup>& group);
+
+    /**
+     * This is a helper method that takes all the forced groups of a device that can be read, and merges them into
+     * read requests. Called under the state lock.
+     *
+     * @param device The schedule of the device.
+     * @return The merged reads, each of them is issued as a single request.
+     */
+    std::vector<MergedRead> takeForcedReads(DeviceSchedule& device);
+
+    /**
+     * This is a helper method that issues a merged read, and hands each group its part of the response.
+     *
+     * @param read The groups that are read.
+     */
+    void readMerged(const MergedRead& read);
+
+    /**
+     * This is a helper method that handles the result of a group read, and reports all the changes it produced.
+     *
+     * @param group The group that was read.
+     * @param success Whether the read was successful.
+     * @param registers The registers that were read.
+     * @param bits The bits that were read.
+     * @param recordHealth Whether the read counts towards the health of the device, once per request.
+     */
+    void completeRead(const std::shared_ptr<PollGroup>& group, bool success,
+                      const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits,
+                      bool recordHealth = true);
+
+    /**
+     * This is a helper method that sets the time of the next read of a group, and queues the read. Called under the
+     * state lock.
+     *
+     * @param group The group.
+     * @param at The time of the read.
+     */
+    void scheduleRead(const std::shared_ptr<PollGroup>& group, std::chrono::steady_clock::time_point at);
+
+    /**
+     * This is a helper method that returns the first read of the group after a time, keeping the reads of the group
+     * on its phase, so the devices don't drift into the same bursts. Called under the state lock.
+     *
+     * @param group The group.
+     * @param after The time after which the read is needed.
+     * @return The time of the read.
+     */
+    std::chrono::steady_clock::time_point nextSlot(const PollGroup& group,
+                                                   std::chrono::steady_clock::time_point after) const;
+
+    /**
+     * This is a helper method that records requests issued by the scheduler thread into the statistics, and
+     * closes the cycle once it's over. Called under the state lock.
+     *
+     * @param now The time the requests were issued.
+     * @param requests The count of the requests.
+     * @param jitter How late a poll was issued, empty for the other requests.
+     */
+    void recordDispatch(std::chrono::steady_clock::time_point now, std::size_t requests,
+                        std::optional<std::chrono::steady_clock::duration> jitter = std::nullopt);
+
+    /**
+     * This is a helper method that issues the probe of a quarantined device.
+     *
+     * @param health The health of the device.
+     */
+    void probeDevice(const std::shared_ptr<DeviceHealth>& health);
+
+    /**
+     * This is a helper method that handles the result of a probe.
+     *
+     * @param health The health of the device.
+     * @param success Whether the device responded.
+     */
+    void completeProbe(const std::shared_ptr<DeviceHealth>& health, bool success);
+
+    /**
+     * This is a helper method that applies the result of a read to the health of the device. Called under the
+     * state lock.
+     *
+     * @param health The health of the device.
+     * @param success Whether the read was successful.
+     * @param now The time of the read.
+     * @return Whether the status of the device changed, and needs to be reported.
+     */
+    bool recordRead(DeviceHealth& health, bool success, std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is a helper method that takes the repeated writes that are due out of the wheel, schedules their next
+     * repetition, and plans them into blocks. Called under the state lock.
+     *
+     * @param now The current time.
+     * @return The blocks that need to be written.
+     */
+    std::vector<WriteBlock> takeRepeatedWrites(std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is a helper method that issues a block of repeated writes.
+     *
+     * @param block The block of mappings for which the last writes need to be repeated.
+     */
+    void repeatWrite(const WriteBlock& block);
+
+    /**
+     * This is a helper method that groups writes per device and per contiguous block of addresses.
+     *
+     * @param mappings The states of the mappings that are written, nullptr for the ones that are skipped.
+     * @param writes The values, in the same order as the mappings.
+     * @return The blocks, each of them can be sent as a single request.
+     */
+    std::vector<WriteBlock> planWrites(const std::vector<std::shared_ptr<PolledMapping>>& mappings,
+                                       const std::vector<MappingWrite>& writes) const;
+
+    /**
+     * This is a helper method that sends a block of writes through the transport.
+     *
+     * @param block The block.
+     * @param priority The lane of the write.
+     * @param callback The callback invoked with the result.
+     */
+    void submitWrite(const WriteBlock& block, ModbusTransport::Priority priority,
+                     const ModbusTransport::WriteCallback& callback);
+
+    /**
+     * This is a helper method that marks a request issued by the scheduler thread as completed.
+     */
+    void completeRequest();
+
+    /**
+     * This is a helper method that remembers the value that was written into a mapping, and schedules its repeated
+     * write. Called under the state lock.
+     *
+     * @param mapping The mapping that was written.
+     * @param registers The registers that were written, for non-boolean mappings.
+     * @param bit The bit that was written, for boolean mappings.
+     * @param now The time of the write.
+     */
+    void recordWrite(PolledMapping& mapping, const std::vector<std::uint16_t>& registers, bool bit,
+                     std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is a helper method that issues a write, and waits for it to complete.
+     *
+     * @param write The function issuing the write with the given callback.
+     * @return Whether the write was successful.
+     */
+    static bool waitForWrite(const std::function<void(const ModbusTransport::WriteCallback&)>& write);
+
+    /**
+     * This is a helper method that writes the values into the registers through the transport.
+     *
+     * @param mapping The mapping that is being written.
+     * @param values The register values.
+     * @param priority The lane of the write.
+     * @param callback The callback invoked with the result.
+     */
+    void writeRegisters(const PolledMapping& mapping, const std::vector<std::uint16_t>& values,
+                        ModbusTransport::Priority priority, const ModbusTransport::WriteCallback& callback);
+
+    /**
+     * This is a helper method that writes the boolean value into a coil, or a bit of a register.
+     *
+     * @param mapping The mapping that is being written.
+     * @param value The boolean value.
+     * @param priority The lane of the write.
+     * @param callback The callback invoked with the result.
+     */
+    void writeBit(const PolledMapping& mapping, bool value, ModbusTransport::Priority priority,
+                  const ModbusTransport::WriteCallback& callback);
+
+    /**
+     * This is a helper method that checks whether new registers of a mapping pass the filters, and takes them as the
+     * value of the mapping if they do. The mappings filtered by the table of the group already passed it, so only the
+     * others are checked here. Called under the state lock.
+     *
+     * @param mapping The mapping which has been read.
+     * @param first The first of the new registers.
+     * @param last The end of the new registers.
+     * @param value The numeric value of the new registers, decoded with the rest of the group.
+     * @param filtered Whether the mapping is filtered by the table of the group.
+     * @param now The time of the read.
+     * @return Whether the value is accepted as a change.
+     */
+    static bool acceptRegisters(PolledMapping& mapping, std::vector<std::uint16_t>::const_iterator first,
+                                std::vector<std::uint16_t>::const_iterator last, double value, bool filtered,
+                                std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is a helper method that checks whether a new bit of a mapping passes the filters. Called under the
+     * state lock.
+     *
+     * @param mapping The mapping which has been read.
+     * @param bit The new bit.
+     * @param now The time of the read.
+     * @return Whether the value is accepted as a change.
+     */
+    static bool acceptBit(PolledMapping& mapping, bool bit, std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is a helper method that reports the status of a device.
+     *
+     * @param device The device.
+     * @param status The new status.
+     */
+    void reportStatus(const std::shared_ptr<more_modbus::ModbusDevice>& device, DeviceStatus status);
+
+    /**
+     * This is a helper method that finds the state of a mapping. Called under the state lock.
+     *
+     * @param mapping The mapping.
+     * @return The state of the mapping, nullptr if the mapping is not known.
+     */
+    std::shared_ptr<PolledMapping> findMapping(const more_modbus::RegisterMapping& mapping) const;
+
+    const std::string TAG = "[PollScheduler] -> ";
+
+    // The transport through which the requests are sent
+    std::shared_ptr<ModbusTransport> m_transport;
+
+    // The planner of the groups, and the rules of the quarantine
+    ReadPlanner m_readPlanner;
+    HealthPolicy m_healthPolicy;
+    std::chrono::milliseconds m_readAfterWriteWindow;
+
+    // The groups and the mapping states, guarded by the state lock. The phases of the groups count from the epoch.
+    // The reads are queued by their time, and the devices with forced reads or in quarantine are kept on the side, so
+    // the scheduler thread doesn't look through all the groups for every request.
+    std::chrono::steady_clock::time_point m_epoch;
+    std::map<const more_modbus::ModbusDevice*, DeviceSchedule> m_devices;
+    std::priority_queue<QueuedRead, std::vector<QueuedRead>, std::greater<QueuedRead>> m_queuedReads;
+    std::vector<DeviceSchedule*> m_forcedDevices;
+    std::vector<std::shared_ptr<DeviceHealth>> m_quarantined;
+    std::chrono::milliseconds m_longestPeriod;
+    std::map<const more_modbus::RegisterMapping*, std::shared_ptr<PolledMapping>> m_mappings;
+    std::vector<std::shared_ptr<PolledMapping>> m_repeatedMappings;
+    TimerWheel m_repeatWheel;
+    std::size_t m_deviceCount;
+    std::size_t m_pendingRequests;
+    CycleState m_cycle;
+    PollStatistics m_statistics;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    // The thread
+    std::atomic_bool m_running;
+    std::unique_ptr<std::thread> m_thread;
+
+    // The callbacks
+    StatusCallback m_onStatusChange;
+    BytesCallback m_onBytesChange;
+    BoolCallback m_onBoolChange;
+    CycleCallback m_onCycleComplete;
+};
+}    // namespace modbus
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_POLLSCHEDULER_H
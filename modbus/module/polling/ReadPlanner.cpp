@@ -0,0 +1,223 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/polling/ReadPlanner.h"
+
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+
+namespace wolkabout::modbus
+{
+const std::uint16_t ReadPlanner::MAX_REGISTERS_PER_READ = 125;
+const std::uint16_t ReadPlanner::MAX_BITS_PER_READ = 2000;
+const std::uint16_t ReadPlanner::BITS_PER_REGISTER = 16;
+
+ReadPlanner::ReadPlanner(std::uint16_t gapTolerance) : m_gapTolerance(gapTolerance) {}
+
+std::vector<std::shared_ptr<PollGroup>> ReadPlanner::plan(
+  const std::shared_ptr<more_modbus::ModbusDevice>& device,
+  const std::vector<std::shared_ptr<PolledMapping>>& mappings) const
+{
+    // Write-only mappings are never read
+    auto readable = std::vector<std::shared_ptr<PolledMapping>>{};
+    std::copy_if(mappings.cbegin(), mappings.cend(), std::back_inserter(readable),
+                 [](const std::shared_ptr<PolledMapping>& mapping) {
+                     return mapping->configuration.getMappingType() != MappingType::WriteOnly;
+                 });
+
+    // Sort them so that the mappings that can share a group are next to each other
+    std::sort(readable.begin(), readable.end(),
+              [](const std::shared_ptr<PolledMapping>& lhs, const std::shared_ptr<PolledMapping>& rhs) {
+                  return std::make_tuple(lhs->configuration.getRegisterType(), lhs->pollPeriod,
+                                         lhs->configuration.getAddress()) <
+                         std::make_tuple(rhs->configuration.getRegisterType(), rhs->pollPeriod,
+                                         rhs->configuration.getAddress());
+              });
+
+    auto groups = std::vector<std::shared_ptr<PollGroup>>{};
+    for (const auto& mapping : readable)
+    {
+        const auto& configuration = mapping->configuration;
+        const auto isBit = configuration.getRegisterType() == more_modbus::RegisterType::COIL ||
+                           configuration.getRegisterType() == more_modbus::RegisterType::INPUT_CONTACT;
+        const auto limit = isBit ? MAX_BITS_PER_READ : MAX_REGISTERS_PER_READ;
+        const auto gap = isBit ? m_gapTolerance * BITS_PER_REGISTER : m_gapTolerance;
+        const auto address = static_cast<std::uint16_t>(configuration.getAddress());
+        const auto span = addressSpan(configuration);
+
+        // Check if the mapping can be appended to the last group, with the sorting this is the only candidate
+        if (!groups.empty())
+        {
+            const auto& last = groups.back();
+            const auto lastEnd = last->startAddress + last->count;
+            const auto newEnd = std::max(lastEnd, address + span);
+            if (last->registerType == configuration.getRegisterType() && last->period == mapping->pollPeriod &&
+                address <= lastEnd + gap && newEnd - last->startAddress <= limit)
+            {
+                last->count = static_cast<std::uint16_t>(newEnd - last->startAddress);
+                last->mappings.emplace_back(mapping);
+                mapping->group = last;
+                continue;
+            }
+        }
+
+        const auto group = std::make_shared<PollGroup>(
+          PollGroup{device, configuration.getRegisterType(), address, span, mapping->pollPeriod, {mapping}});
+        mapping->group = group;
+        groups.emplace_back(group);
+    }
+
+    for (const auto& group : groups)
+    {
+        group->decodeRuns = planDecode(*group);
+        group->values.resize(group->mappings.size(), 0.0);
+
+        // The table filters every mapping that has a decoded value, unless it takes every sample for its aggregation.
+        // The strings and the boolean mappings are checked one by one.
+        auto filtered = std::vector<bool>(group->mappings.size(), false);
+        for (const auto& run : group->decodeRuns)
+        {
+            for (auto i = run.firstMapping; i < run.firstMapping + run.count; ++i)
+                filtered[i] = !group->mappings[i]->configuration.isAggregated();
+        }
+        for (auto i = std::size_t{0}; i < group->mappings.size(); ++i)
+        {
+            const auto& configuration = group->mappings[i]->configuration;
+            group->deadbands.add(configuration.getDeadbandValue(), configuration.getFrequencyFilterValue(),
+                                 filtered[i]);
+        }
+    }
+    return groups;
+}
+
+std::vector<std::vector<std::shared_ptr<PollGroup>>> ReadPlanner::merge(
+  std::vector<std::shared_ptr<PollGroup>> groups) const
+{
+    std::sort(groups.begin(), groups.end(),
+              [](const std::shared_ptr<PollGroup>& lhs, const std::shared_ptr<PollGroup>& rhs) {
+                  return std::make_tuple(lhs->registerType, lhs->startAddress) <
+                         std::make_tuple(rhs->registerType, rhs->startAddress);
+              });
+
+    auto sets = std::vector<std::vector<std::shared_ptr<PollGroup>>>{};
+    auto setStart = std::uint32_t{0};
+    auto setEnd = std::uint32_t{0};
+    for (const auto& group : groups)
+    {
+        const auto isBit = group->registerType == more_modbus::RegisterType::COIL ||
+                           group->registerType == more_modbus::RegisterType::INPUT_CONTACT;
+        const auto limit = isBit ? MAX_BITS_PER_READ : MAX_REGISTERS_PER_READ;
+        const auto gap = isBit ? m_gapTolerance * BITS_PER_REGISTER : m_gapTolerance;
+        const auto end = static_cast<std::uint32_t>(group->startAddress + group->count);
+
+        // With the sorting, the last set is the only candidate
+        if (!sets.empty() && sets.back().front()->registerType == group->registerType &&
+            group->startAddress <= setEnd + gap && std::max(setEnd, end) - setStart <= limit)
+        {
+            sets.back().emplace_back(group);
+            setEnd = std::max(setEnd, end);
+            continue;
+        }
+
+        sets.push_back({group});
+        setStart = group->startAddress;
+        setEnd = end;
+    }
+    return sets;
+}
+
+std::string ReadPlanner::describe(const std::vector<std::shared_ptr<PollGroup>>& groups)
+{
+    auto stream = std::stringstream{};
+    for (const auto& group : groups)
+    {
+        switch (group->registerType)
+        {
+        case more_modbus::RegisterType::COIL:
+            stream << "FC01 COIL";
+            break;
+        case more_modbus::RegisterType::INPUT_CONTACT:
+            stream << "FC02 INPUT_CONTACT";
+            break;
+        case more_modbus::RegisterType::HOLDING_REGISTER:
+            stream << "FC03 HOLDING_REGISTER";
+            break;
+        case more_modbus::RegisterType::INPUT_REGISTER:
+            stream << "FC04 INPUT_REGISTER";
+            break;
+        }
+        stream << " " << group->startAddress << "-" << group->startAddress + group->count - 1 << " (" << group->count
+               << ") every " << group->period.count() << "ms:";
+        for (const auto& mapping : group->mappings)
+            stream << " " << mapping->configuration.getReference();
+        stream << std::endl;
+    }
+    return stream.str();
+}
+
+std::uint16_t ReadPlanner::addressSpan(const ModuleMapping& mapping)
+{
+    if (mapping.getRegisterType() == more_modbus::RegisterType::COIL ||
+        mapping.getRegisterType() == more_modbus::RegisterType::INPUT_CONTACT ||
+        mapping.getDataType() == more_modbus::OutputType::BOOL)
+        return 1;
+    return static_cast<std::uint16_t>(mapping.getRegisterCount());
+}
+
+std::vector<DecodeRun> ReadPlanner::planDecode(const PollGroup& group)
+{
+    auto runs = std::vector<DecodeRun>{};
+    if (group.registerType == more_modbus::RegisterType::COIL ||
+        group.registerType == more_modbus::RegisterType::INPUT_CONTACT)
+        return runs;
+
+    for (auto i = std::size_t{0}; i < group.mappings.size(); ++i)
+    {
+        const auto& configuration = group.mappings[i]->configuration;
+        const auto type = configuration.getDataType();
+        if (type == more_modbus::OutputType::BOOL || type == more_modbus::OutputType::STRING)
+            continue;
+
+        const auto width = static_cast<std::uint16_t>(
+          type == more_modbus::OutputType::UINT16 || type == more_modbus::OutputType::INT16 ? 1 : 2);
+        const auto offset = static_cast<std::uint16_t>(configuration.getAddress() - group.startAddress);
+        const auto bigEndian = configuration.getOperationType() != more_modbus::OperationType::MERGE_LITTLE_ENDIAN &&
+                               configuration.getOperationType() !=
+                                 more_modbus::OperationType::MERGE_FLOAT_LITTLE_ENDIAN;
+
+        // The mapping continues the last run if it's the next value in it
+        if (!runs.empty())
+        {
+            auto& last = runs.back();
+            if (last.firstMapping + last.count == i && last.type == type && last.bigEndian == bigEndian &&
+                last.offset + last.count * width == offset && addressSpan(configuration) == width &&
+                addressSpan(group.mappings[i - 1]->configuration) == width)
+            {
+                ++last.count;
+                continue;
+            }
+        }
+        runs.emplace_back(DecodeRun{i, 1, offset, type, width, bigEndian});
+    }
+    return runs;
+}
+
+std::uint16_t ReadPlanner::getGapTolerance() const
+{
+    return m_gapTolerance;
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,105 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_READPLANNER_H
+#define WOLKGATEWAYMODBUSMODULE_READPLANNER_H
+
+#include "modbus/module/polling/PollGroup.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Class that merges the mappings of a device into the fewest read requests.
+ * @details Mappings that share the register type and the poll period are merged into a single request as long as the
+ *          request stays within the limits of a Modbus PDU, and the unused addresses between two mappings are not
+ *          more than the gap tolerance. Reading a few unused registers is cheaper than another round trip.
+ */
+class ReadPlanner
+{
+public:
+    // The most a single FC03/FC04 request can read
+    static const std::uint16_t MAX_REGISTERS_PER_READ;
+    // The most a single FC01/FC02 request can read
+    static const std::uint16_t MAX_BITS_PER_READ;
+    // How many bits are tolerated in a gap for each tolerated register, as they cost the same amount of bytes
+    static const std::uint16_t BITS_PER_REGISTER;
+
+    /**
+     * Default constructor for the planner.
+     *
+     * @param gapTolerance The count of unused registers that can be read to merge two mappings into one request.
+     */
+    explicit ReadPlanner(std::uint16_t gapTolerance = 0);
+
+    /**
+     * This is the method that merges the mappings of a device into read requests.
+     * Write-only mappings are not read, so they're left out of the plan.
+     *
+     * @param device The device to which the mappings belong.
+     * @param mappings The mappings of the device, with their poll period resolved.
+     * @return The groups, each one being a single read request.
+     */
+    std::vector<std::shared_ptr<PollGroup>> plan(const std::shared_ptr<more_modbus::ModbusDevice>& device,
+                                                 const std::vector<std::shared_ptr<PolledMapping>>& mappings) const;
+
+    /**
+     * This is the method that merges groups of a device that need to be read at the same time into the fewest read
+     * requests, regardless of their periods.
+     *
+     * @param groups The groups of a single device.
+     * @return The groups split into sets, each set being covered by a single read request.
+     */
+    std::vector<std::vector<std::shared_ptr<PollGroup>>> merge(std::vector<std::shared_ptr<PollGroup>> groups) const;
+
+    /**
+     * This is the method that describes a plan in a human readable form, one request per line.
+     *
+     * @param groups The groups created by the planner.
+     * @return The description of the plan.
+     */
+    static std::string describe(const std::vector<std::shared_ptr<PollGroup>>& groups);
+
+    /**
+     * This is the method that returns the count of addresses a mapping takes up in its group.
+     *
+     * @param mapping The mapping.
+     * @return The count of registers/bits.
+     */
+    static std::uint16_t addressSpan(const ModuleMapping& mapping);
+
+    /**
+     * This is the method that splits the numeric mappings of a group into runs of consecutive values of the same type
+     * and byte order, that are decoded together. Mappings taking up more registers than their value start their own
+     * run.
+     *
+     * @param group The group, with its mappings sorted by the address.
+     * @return The runs.
+     */
+    static std::vector<DecodeRun> planDecode(const PollGroup& group);
+
+    std::uint16_t getGapTolerance() const;
+
+private:
+    std::uint16_t m_gapTolerance;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_READPLANNER_H
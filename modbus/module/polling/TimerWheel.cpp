@@ -0,0 +1,151 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/polling/TimerWheel.h"
+
+#include <algorithm>
+
+namespace wolkabout::modbus
+{
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, std::chrono::steady_clock::time_point start)
+: m_tick(std::max(tick, std::chrono::milliseconds{1})), m_start(start), m_current(0)
+{
+}
+
+void TimerWheel::schedule(std::size_t timer, std::chrono::steady_clock::time_point deadline)
+{
+    // The deadline is rounded up to a tick, and a deadline that has passed expires on the next tick
+    auto tick = m_current + 1;
+    if (deadline > m_start)
+    {
+        const auto elapsed = deadline - m_start;
+        tick = std::max(tick, static_cast<std::uint64_t>((elapsed + m_tick - std::chrono::nanoseconds{1}) / m_tick));
+    }
+
+    m_deadlines[timer] = tick;
+    insert(Entry{timer, tick});
+}
+
+void TimerWheel::cancel(std::size_t timer)
+{
+    // The entry is left in its slot, and dropped once the slot is reached
+    m_deadlines.erase(timer);
+}
+
+std::vector<std::size_t> TimerWheel::advance(std::chrono::steady_clock::time_point now)
+{
+    auto expired = std::vector<std::size_t>{};
+    if (now < m_start)
+        return expired;
+
+    const auto target = static_cast<std::uint64_t>((now - m_start) / m_tick);
+    if (m_deadlines.empty())
+    {
+        for (auto& level : m_levels)
+            for (auto& slot : level)
+                slot.clear();
+        m_current = std::max(m_current, target);
+        return expired;
+    }
+
+    while (m_current < target)
+    {
+        ++m_current;
+
+        // Once a level wraps around, the next slot of the level above is spread into it
+        for (auto level = std::size_t{1}; level < LEVELS; ++level)
+        {
+            const auto shift = SLOT_BITS * level;
+            if ((m_current & ((std::uint64_t{1} << shift) - 1)) != 0)
+                break;
+            cascade(level, (m_current >> shift) & SLOT_MASK);
+        }
+
+        auto& slot = m_levels[0][m_current & SLOT_MASK];
+        auto entries = std::vector<Entry>{};
+        entries.swap(slot);
+        for (const auto& entry : entries)
+        {
+            if (!isCurrent(entry))
+                continue;
+            if (entry.tick > m_current)
+            {
+                slot.emplace_back(entry);
+                continue;
+            }
+            m_deadlines.erase(entry.timer);
+            expired.emplace_back(entry.timer);
+        }
+    }
+    return expired;
+}
+
+std::chrono::steady_clock::time_point TimerWheel::nextExpiry() const
+{
+    if (m_deadlines.empty())
+        return std::chrono::steady_clock::time_point::max();
+
+    // A slot of the first level that has current entries, or the wrap around, when the levels above cascade into it
+    for (auto tick = m_current + 1;; ++tick)
+    {
+        const auto& slot = m_levels[0][tick & SLOT_MASK];
+        if ((tick & SLOT_MASK) == 0 ||
+            std::any_of(slot.cbegin(), slot.cend(),
+                        [&](const Entry& entry) { return entry.tick == tick && isCurrent(entry); }))
+            return m_start + m_tick * static_cast<std::int64_t>(tick);
+    }
+}
+
+std::size_t TimerWheel::size() const
+{
+    return m_deadlines.size();
+}
+
+void TimerWheel::insert(const Entry& entry)
+{
+    // The level is chosen by how far away the tick is, the timers beyond the last level wait in its furthest slot
+    const auto delta = entry.tick - m_current;
+    for (auto level = std::size_t{0}; level < LEVELS; ++level)
+    {
+        const auto shift = SLOT_BITS * level;
+        if (delta < (SLOTS << shift))
+        {
+            m_levels[level][(entry.tick >> shift) & SLOT_MASK].emplace_back(entry);
+            return;
+        }
+    }
+    const auto shift = SLOT_BITS * (LEVELS - 1);
+    m_levels[LEVELS - 1][((m_current >> shift) - 1) & SLOT_MASK].emplace_back(entry);
+}
+
+void TimerWheel::cascade(std::size_t level, std::uint64_t slot)
+{
+    auto entries = std::vector<Entry>{};
+    entries.swap(m_levels[level][slot]);
+    for (const auto& entry : entries)
+    {
+        if (isCurrent(entry))
+            insert(entry);
+    }
+}
+
+bool TimerWheel::isCurrent(const Entry& entry) const
+{
+    const auto it = m_deadlines.find(entry.timer);
+    return it != m_deadlines.cend() && it->second == entry.tick;
+}
+}    // namespace wolkabout::modbus
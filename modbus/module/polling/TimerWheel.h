@@ -0,0 +1,135 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_TIMERWHEEL_H
+#define WOLKGATEWAYMODBUSMODULE_TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Hierarchical timer wheel, keeping any number of timers at a constant cost per timer.
+ * @details Time is divided into ticks. Timers due within the next 64 ticks are kept in the slots of the first level,
+ *          the ones further away in the levels above it, each covering 64 times more ticks than the one below. Once
+ *          the first level wraps around, the next slot of the level above it is spread into the first level.
+ *          All timers due within the same tick expire together.
+ */
+class TimerWheel
+{
+public:
+    /**
+     * Default constructor for the wheel.
+     *
+     * @param tick The resolution of the wheel. Timers never expire before their deadline, but can be up to a tick
+     * late.
+     * @param start The time from which the ticks are counted.
+     */
+    explicit TimerWheel(std::chrono::milliseconds tick,
+                        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now());
+
+    /**
+     * This is the method that schedules a timer. A timer that is already scheduled is moved to the new deadline.
+     *
+     * @param timer The identifier of the timer.
+     * @param deadline The time at which the timer expires.
+     */
+    void schedule(std::size_t timer, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * This is the method that cancels a timer. Canceling a timer that is not scheduled does nothing.
+     *
+     * @param timer The identifier of the timer.
+     */
+    void cancel(std::size_t timer);
+
+    /**
+     * This is the method that moves the wheel up to the time, and returns all the timers that expired on the way.
+     *
+     * @param now The current time.
+     * @return The timers that expired, ordered by their deadline.
+     */
+    std::vector<std::size_t> advance(std::chrono::steady_clock::time_point now);
+
+    /**
+     * This is the method that returns the time at which the wheel needs to be advanced next. Until then, no timer
+     * can expire.
+     *
+     * @return The time of the next tick that has timers, or the maximum time if there are no timers.
+     */
+    std::chrono::steady_clock::time_point nextExpiry() const;
+
+    /**
+     * This is the method that returns the count of scheduled timers.
+     *
+     * @return The count of timers.
+     */
+    std::size_t size() const;
+
+private:
+    static const std::size_t LEVELS = 4;
+    static const std::uint64_t SLOT_BITS = 6;
+    static const std::uint64_t SLOTS = 1u << SLOT_BITS;
+    static const std::uint64_t SLOT_MASK = SLOTS - 1;
+
+    // A timer in a slot, which is stale if the timer was moved or canceled since
+    struct Entry
+    {
+        std::size_t timer;
+        std::uint64_t tick;
+    };
+
+    /**
+     * This is a helper method that puts the timer into the slot matching its tick.
+     *
+     * @param entry The timer with its tick.
+     */
+    void insert(const Entry& entry);
+
+    /**
+     * This is a helper method that spreads a slot of a higher level into the levels below it.
+     *
+     * @param level The level.
+     * @param slot The slot of the level.
+     */
+    void cascade(std::size_t level, std::uint64_t slot);
+
+    /**
+     * This is a helper method that checks whether the entry is still the current deadline of its timer.
+     *
+     * @param entry The entry.
+     * @return Whether the entry is valid.
+     */
+    bool isCurrent(const Entry& entry) const;
+
+    std::chrono::milliseconds m_tick;
+    std::chrono::steady_clock::time_point m_start;
+
+    // The last tick that has been processed
+    std::uint64_t m_current;
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> m_levels;
+    std::unordered_map<std::size_t, std::uint64_t> m_deadlines;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_TIMERWHEEL_H
@@ -0,0 +1,758 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/transport/EpollTcpTransport.h"
+
+#include "core/utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// The MBAP header, including the unit identifier
+const std::size_t MBAP_HEADER_SIZE = 7;
+// The length field covers the unit identifier and the PDU, which is at most 253 bytes
+const std::uint16_t MAX_MBAP_LENGTH = 254;
+// The time before an endpoint that failed is connected to again
+const std::chrono::milliseconds RECONNECT_DELAY{1000};
+// The longest time the thread sleeps when nothing is happening
+const std::chrono::milliseconds IDLE_WAIT{1000};
+const int MAX_EVENTS = 64;
+const std::string STOPPED = "the transport is stopped";
+// The count of latencies that need to be measured before the adaptive timeout is used
+const std::uint32_t MIN_LATENCY_SAMPLES = 20;
+const double LATENCY_PERCENTILE = 99.0;
+const std::size_t RECEIVE_CHUNK = 1024;
+
+const std::uint8_t READ_COILS = 0x01;
+const std::uint8_t READ_DISCRETE_INPUTS = 0x02;
+const std::uint8_t READ_HOLDING_REGISTERS = 0x03;
+const std::uint8_t READ_INPUT_REGISTERS = 0x04;
+const std::uint8_t WRITE_SINGLE_COIL = 0x05;
+const std::uint8_t WRITE_SINGLE_REGISTER = 0x06;
+const std::uint8_t WRITE_MULTIPLE_COILS = 0x0F;
+const std::uint8_t WRITE_MULTIPLE_REGISTERS = 0x10;
+const std::uint8_t EXCEPTION_FLAG = 0x80;
+// The exception a device responds with when it can't take another request
+const std::uint8_t SERVER_DEVICE_BUSY = 0x06;
+
+void appendWord(std::vector<std::uint8_t>& bytes, std::uint16_t word)
+{
+    bytes.emplace_back(static_cast<std::uint8_t>(word >> 8));
+    bytes.emplace_back(static_cast<std::uint8_t>(word & 0xFF));
+}
+
+std::uint16_t readWord(const std::vector<std::uint8_t>& bytes, std::size_t offset)
+{
+    return static_cast<std::uint16_t>((bytes[offset] << 8) | bytes[offset + 1]);
+}
+}    // namespace
+
+EpollTcpTransport::EpollTcpTransport()
+: m_epollFd(epoll_create1(EPOLL_CLOEXEC)), m_wakeUpFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), m_running(false)
+{
+    if (m_epollFd < 0 || m_wakeUpFd < 0)
+        throw std::runtime_error("Failed to create the epoll instance : " + std::string(std::strerror(errno)));
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeUpFd, &event) < 0)
+        throw std::runtime_error("Failed to watch the wake up event : " + std::string(std::strerror(errno)));
+}
+
+EpollTcpTransport::~EpollTcpTransport()
+{
+    stop();
+    if (m_wakeUpFd >= 0)
+        ::close(m_wakeUpFd);
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+}
+
+void EpollTcpTransport::addEndpoint(const std::string& bus, const std::string& host, std::uint16_t port,
+                                    std::chrono::milliseconds responseTimeout,
+                                    std::unique_ptr<AdaptiveTimeoutConfiguration> adaptiveTimeout)
+{
+    // The lookup can block, so it's done before the lock is taken
+    auto address = sockaddr_storage{};
+    auto addressLength = socklen_t{0};
+    auto hints = addrinfo{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) == 0 && result != nullptr)
+    {
+        std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+        addressLength = result->ai_addrlen;
+    }
+    else
+    {
+        LOG(ERROR) << TAG << "Failed to resolve " << host << " - the devices on bus '" << bus
+                   << "' can not be reached.";
+    }
+    if (result != nullptr)
+        freeaddrinfo(result);
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto key = host + ":" + std::to_string(port);
+    auto it = m_connections.find(key);
+    if (it == m_connections.cend())
+    {
+        auto connection = std::unique_ptr<Connection>(new Connection{});
+        connection->host = host;
+        connection->port = port;
+        connection->responseTimeout = responseTimeout;
+        connection->address = address;
+        connection->addressLength = addressLength;
+        connection->adaptiveTimeout = std::move(adaptiveTimeout);
+        it = m_connections.emplace(key, std::move(connection)).first;
+    }
+    m_connectionByBus[bus] = it->second.get();
+}
+
+void EpollTcpTransport::addDevice(const std::shared_ptr<more_modbus::ModbusDevice>& device, const std::string& bus,
+                                  std::uint16_t maxInFlight)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    const auto it = m_connectionByBus.find(bus);
+    if (it == m_connectionByBus.cend())
+    {
+        LOG(WARN) << TAG << "Device '" << device->getName() << "' is on bus '" << bus << "' that has no endpoint.";
+        return;
+    }
+    m_devices[device.get()] = std::unique_ptr<DeviceState>(
+      new DeviceState{device->getName(), it->second, std::max(maxInFlight, static_cast<std::uint16_t>(1))});
+}
+
+void EpollTcpTransport::start()
+{
+    if (m_running)
+        return;
+
+    m_running = true;
+    m_thread = std::unique_ptr<std::thread>{new std::thread(&EpollTcpTransport::run, this)};
+}
+
+void EpollTcpTransport::stop()
+{
+    if (!m_running)
+        return;
+
+    m_running = false;
+    wakeUp();
+    if (m_thread != nullptr && m_thread->joinable())
+        m_thread->join();
+    m_thread.reset();
+
+    auto completions = Completions{};
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        for (const auto& pair : m_connections)
+            closeConnection(*pair.second, STOPPED, completions);
+    }
+    for (const auto& completion : completions)
+        completion();
+}
+
+bool EpollTcpTransport::isAsynchronous() const
+{
+    return true;
+}
+
+void EpollTcpTransport::read(const more_modbus::ModbusDevice& device, more_modbus::RegisterType registerType,
+                             std::uint16_t address, std::uint16_t count, Priority priority, ReadCallback callback)
+{
+    auto functionCode = std::uint8_t{0};
+    switch (registerType)
+    {
+    case more_modbus::RegisterType::COIL:
+        functionCode = READ_COILS;
+        break;
+    case more_modbus::RegisterType::INPUT_CONTACT:
+        functionCode = READ_DISCRETE_INPUTS;
+        break;
+    case more_modbus::RegisterType::HOLDING_REGISTER:
+        functionCode = READ_HOLDING_REGISTERS;
+        break;
+    case more_modbus::RegisterType::INPUT_REGISTER:
+        functionCode = READ_INPUT_REGISTERS;
+        break;
+    }
+
+    auto pdu = std::vector<std::uint8_t>{functionCode};
+    appendWord(pdu, address);
+    appendWord(pdu, count);
+    submit(device, std::make_shared<Transaction>(Transaction{static_cast<std::uint8_t>(device.getSlaveAddress()),
+                                                             std::move(pdu), count, std::move(callback), nullptr,
+                                                             priority}));
+}
+
+void EpollTcpTransport::writeRegisters(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                                       const std::vector<std::uint16_t>& values, Priority priority,
+                                       WriteCallback callback)
+{
+    if (values.empty())
+    {
+        callback(false);
+        return;
+    }
+
+    auto pdu = std::vector<std::uint8_t>{};
+    if (values.size() == 1)
+    {
+        pdu.emplace_back(WRITE_SINGLE_REGISTER);
+        appendWord(pdu, address);
+        appendWord(pdu, values.front());
+    }
+    else
+    {
+        pdu.emplace_back(WRITE_MULTIPLE_REGISTERS);
+        appendWord(pdu, address);
+        appendWord(pdu, static_cast<std::uint16_t>(values.size()));
+        pdu.emplace_back(static_cast<std::uint8_t>(values.size() * 2));
+        for (const auto value : values)
+            appendWord(pdu, value);
+    }
+    submit(device, std::make_shared<Transaction>(Transaction{static_cast<std::uint8_t>(device.getSlaveAddress()),
+                                                             std::move(pdu), 0, nullptr, std::move(callback),
+                                                             priority}));
+}
+
+void EpollTcpTransport::writeCoil(const more_modbus::ModbusDevice& device, std::uint16_t address, bool value,
+                                  Priority priority, WriteCallback callback)
+{
+    auto pdu = std::vector<std::uint8_t>{WRITE_SINGLE_COIL};
+    appendWord(pdu, address);
+    appendWord(pdu, value ? 0xFF00 : 0x0000);
+    submit(device, std::make_shared<Transaction>(Transaction{static_cast<std::uint8_t>(device.getSlaveAddress()),
+                                                             std::move(pdu), 0, nullptr, std::move(callback),
+                                                             priority}));
+}
+
+void EpollTcpTransport::writeCoils(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                                   const std::vector<bool>& values, Priority priority, WriteCallback callback)
+{
+    if (values.empty())
+    {
+        callback(false);
+        return;
+    }
+    if (values.size() == 1)
+    {
+        writeCoil(device, address, values.front(), priority, std::move(callback));
+        return;
+    }
+
+    // The coils are packed into bytes, starting from the lowest bit
+    auto pdu = std::vector<std::uint8_t>{WRITE_MULTIPLE_COILS};
+    appendWord(pdu, address);
+    appendWord(pdu, static_cast<std::uint16_t>(values.size()));
+    pdu.emplace_back(static_cast<std::uint8_t>((values.size() + 7) / 8));
+    for (auto i = std::size_t{0}; i < values.size(); ++i)
+    {
+        if (i % 8 == 0)
+            pdu.emplace_back(0);
+        if (values[i])
+            pdu.back() = static_cast<std::uint8_t>(pdu.back() | (1u << (i % 8)));
+    }
+    submit(device, std::make_shared<Transaction>(Transaction{static_cast<std::uint8_t>(device.getSlaveAddress()),
+                                                             std::move(pdu), 0, nullptr, std::move(callback),
+                                                             priority}));
+}
+
+void EpollTcpTransport::submit(const more_modbus::ModbusDevice& device, std::shared_ptr<Transaction> transaction)
+{
+    auto failure = std::function<void()>{};
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        const auto it = m_devices.find(&device);
+        if (!m_running || it == m_devices.cend())
+        {
+            failure = complete(transaction, false);
+        }
+        else
+        {
+            transaction->device = it->second.get();
+            auto& pending = it->second->connection->pending;
+            const auto position =
+              std::upper_bound(pending.cbegin(), pending.cend(), transaction->priority,
+                               [](Priority priority, const std::shared_ptr<Transaction>& queued) {
+                                   return priority < queued->priority;
+                               });
+            pending.insert(position, std::move(transaction));
+        }
+    }
+
+    if (failure)
+        failure();
+    else
+        wakeUp();
+}
+
+void EpollTcpTransport::run()
+{
+    epoll_event events[MAX_EVENTS];
+    auto eventCount = 0;
+    while (m_running)
+    {
+        auto completions = Completions{};
+        auto timeout = std::chrono::milliseconds{0};
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            for (auto i = 0; i < eventCount; ++i)
+            {
+                if (events[i].data.ptr == nullptr)
+                {
+                    auto value = std::uint64_t{0};
+                    while (::read(m_wakeUpFd, &value, sizeof(value)) > 0)
+                    {
+                    }
+                    continue;
+                }
+                handleEvents(*static_cast<Connection*>(events[i].data.ptr), events[i].events, completions);
+            }
+            timeout = service(completions);
+        }
+
+        // The callbacks are invoked without the lock, as they are free to submit new requests
+        for (const auto& completion : completions)
+            completion();
+
+        eventCount = epoll_wait(m_epollFd, events, MAX_EVENTS, static_cast<int>(timeout.count()));
+        if (eventCount < 0)
+        {
+            if (errno != EINTR)
+                LOG(ERROR) << TAG << "Failed to wait for events : " << std::strerror(errno);
+            eventCount = 0;
+        }
+    }
+}
+
+std::chrono::milliseconds EpollTcpTransport::service(Completions& completions)
+{
+    const auto now = std::chrono::steady_clock::now();
+    auto next = now + IDLE_WAIT;
+    for (const auto& pair : m_connections)
+    {
+        auto& connection = *pair.second;
+
+        // Requests that did not get a response in time fail, while a late response is dropped once it arrives
+        for (auto it = connection.inFlight.begin(); it != connection.inFlight.end();)
+        {
+            if (it->second->deadline <= now)
+            {
+                // A pipelined request that timed out while the device answered the others was most likely dropped
+                const auto& transaction = it->second;
+                backOff(*transaction->device);
+                const auto dropped =
+                  transaction->pipelined && transaction->device->respondedAt >= transaction->sentAt;
+                finish(transaction, false, dropped, completions);
+                it = connection.inFlight.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (!connection.connected && !connection.connecting)
+        {
+            if (connection.pending.empty())
+                continue;
+
+            // An endpoint that just failed fails the requests right away, instead of making them wait
+            if (now < connection.reconnectAt || !openConnection(connection))
+            {
+                for (const auto& transaction : connection.pending)
+                    completions.emplace_back(complete(transaction, false));
+                connection.pending.clear();
+                if (now >= connection.reconnectAt)
+                    connection.reconnectAt = now + RECONNECT_DELAY;
+                continue;
+            }
+        }
+
+        if (connection.connecting)
+        {
+            if (now >= connection.connectDeadline)
+                closeConnection(connection, "the connect timed out", completions);
+            else
+                next = std::min(next, connection.connectDeadline);
+            continue;
+        }
+
+        // Requests are sent in the order of the queue, except that a device that has all of its requests in flight
+        // is skipped
+        for (auto it = connection.pending.begin(); it != connection.pending.end();)
+        {
+            auto& device = *(*it)->device;
+            if (device.inFlight >= device.maxInFlight)
+            {
+                ++it;
+                continue;
+            }
+            auto transaction = std::move(*it);
+            it = connection.pending.erase(it);
+
+            auto transactionId = connection.nextTransactionId++;
+            while (connection.inFlight.find(transactionId) != connection.inFlight.cend())
+                transactionId = connection.nextTransactionId++;
+
+            auto& buffer = connection.sendBuffer;
+            appendWord(buffer, transactionId);
+            appendWord(buffer, 0);
+            appendWord(buffer, static_cast<std::uint16_t>(transaction->pdu.size() + 1));
+            buffer.emplace_back(transaction->unitId);
+            buffer.insert(buffer.end(), transaction->pdu.cbegin(), transaction->pdu.cend());
+
+            transaction->pipelined = device.inFlight > 0;
+            transaction->sentAt = now;
+            transaction->deadline =
+              now + (device.responseTimeout.count() > 0 ? device.responseTimeout : connection.responseTimeout);
+            ++device.inFlight;
+            connection.inFlight.emplace(transactionId, std::move(transaction));
+        }
+        if (!flush(connection))
+        {
+            closeConnection(connection, std::strerror(errno), completions);
+            continue;
+        }
+
+        for (const auto& inFlight : connection.inFlight)
+            next = std::min(next, inFlight.second->deadline);
+    }
+
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now) + std::chrono::milliseconds{1};
+    return std::max(wait, std::chrono::milliseconds{0});
+}
+
+void EpollTcpTransport::handleEvents(Connection& connection, std::uint32_t events, Completions& completions)
+{
+    if (connection.fd < 0)
+        return;
+
+    if (connection.connecting)
+    {
+        auto error = 0;
+        auto length = static_cast<socklen_t>(sizeof(error));
+        if (getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0)
+            error = errno;
+        if (error != 0)
+        {
+            closeConnection(connection, std::strerror(error), completions);
+            return;
+        }
+        if ((events & EPOLLOUT) == 0)
+            return;
+
+        connection.connecting = false;
+        connection.connected = true;
+        LOG(INFO) << TAG << "Connected to " << connection.host << ":" << connection.port << ".";
+    }
+
+    if ((events & EPOLLIN) != 0)
+    {
+        std::uint8_t chunk[RECEIVE_CHUNK];
+        while (true)
+        {
+            const auto received = ::recv(connection.fd, chunk, sizeof(chunk), 0);
+            if (received > 0)
+            {
+                connection.receiveBuffer.insert(connection.receiveBuffer.end(), chunk, chunk + received);
+                continue;
+            }
+            if (received == 0)
+            {
+                closeConnection(connection, "the connection was closed by the endpoint", completions);
+                return;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            closeConnection(connection, std::strerror(errno), completions);
+            return;
+        }
+
+        if (!parseFrames(connection, completions))
+        {
+            closeConnection(connection, "received an invalid frame", completions);
+            return;
+        }
+    }
+
+    if ((events & (EPOLLERR | EPOLLHUP)) != 0)
+    {
+        closeConnection(connection, "the connection failed", completions);
+        return;
+    }
+
+    if ((events & EPOLLOUT) != 0 && !flush(connection))
+        closeConnection(connection, std::strerror(errno), completions);
+}
+
+bool EpollTcpTransport::openConnection(Connection& connection)
+{
+    if (connection.addressLength == 0)
+        return false;
+
+    const auto fd = ::socket(connection.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    auto noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    const auto connected =
+      ::connect(fd, reinterpret_cast<const sockaddr*>(&connection.address), connection.addressLength) == 0;
+    if (!connected && errno != EINPROGRESS)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.ptr = &connection;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    connection.fd = fd;
+    connection.connecting = !connected;
+    connection.connected = connected;
+    connection.sendBlocked = true;
+    connection.connectDeadline = std::chrono::steady_clock::now() + connection.responseTimeout;
+    if (connected)
+        LOG(INFO) << TAG << "Connected to " << connection.host << ":" << connection.port << ".";
+    return true;
+}
+
+void EpollTcpTransport::closeConnection(Connection& connection, const std::string& reason, Completions& completions)
+{
+    const auto wasOpen = connection.fd >= 0;
+    if (wasOpen)
+    {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        connection.fd = -1;
+    }
+
+    if (connection.connected)
+        LOG(WARN) << TAG << "Lost the connection to " << connection.host << ":" << connection.port << " - " << reason
+                  << ".";
+    else if (wasOpen)
+        LOG(DEBUG) << TAG << "Failed to connect to " << connection.host << ":" << connection.port << " - " << reason
+                   << ".";
+
+    connection.connecting = false;
+    connection.connected = false;
+    connection.sendBlocked = false;
+    connection.reconnectAt = std::chrono::steady_clock::now() + RECONNECT_DELAY;
+    connection.sendBuffer.clear();
+    connection.receiveBuffer.clear();
+
+    // An endpoint that closes the connection while it has pipelined requests might not handle them
+    for (const auto& pair : connection.inFlight)
+        finish(pair.second, false, pair.second->pipelined && reason != STOPPED, completions);
+    connection.inFlight.clear();
+    for (const auto& transaction : connection.pending)
+        completions.emplace_back(complete(transaction, false));
+    connection.pending.clear();
+}
+
+bool EpollTcpTransport::flush(Connection& connection)
+{
+    auto& buffer = connection.sendBuffer;
+    while (!buffer.empty())
+    {
+        const auto sent = ::send(connection.fd, buffer.data(), buffer.size(), MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + sent);
+    }
+
+    // The socket is watched for being writable only while there is something left to send
+    if (connection.sendBlocked != !buffer.empty())
+    {
+        connection.sendBlocked = !buffer.empty();
+        auto event = epoll_event{};
+        event.events = EPOLLIN | (connection.sendBlocked ? EPOLLOUT : 0u);
+        event.data.ptr = &connection;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, connection.fd, &event) < 0)
+            return false;
+    }
+    return true;
+}
+
+bool EpollTcpTransport::parseFrames(Connection& connection, Completions& completions)
+{
+    auto& buffer = connection.receiveBuffer;
+    auto offset = std::size_t{0};
+    while (buffer.size() - offset >= MBAP_HEADER_SIZE)
+    {
+        const auto transactionId = readWord(buffer, offset);
+        const auto protocolId = readWord(buffer, offset + 2);
+        const auto length = readWord(buffer, offset + 4);
+        if (protocolId != 0 || length < 2 || length > MAX_MBAP_LENGTH)
+            return false;
+
+        const auto frameSize = std::size_t{6} + length;
+        if (buffer.size() - offset < frameSize)
+            break;
+
+        // A response that is not expected anymore has timed out, and is dropped
+        const auto it = connection.inFlight.find(transactionId);
+        if (it != connection.inFlight.cend())
+        {
+            const auto transaction = it->second;
+            connection.inFlight.erase(it);
+            recordLatency(*transaction->device, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  std::chrono::steady_clock::now() - transaction->sentAt));
+
+            const auto unitId = buffer[offset + 6];
+            const auto functionCode = buffer[offset + 7];
+            if (unitId != transaction->unitId || functionCode != transaction->pdu.front())
+            {
+                const auto exception = (functionCode & EXCEPTION_FLAG) != 0 && length > 2 ? buffer[offset + 8] : 0;
+                if (exception != 0)
+                    LOG(DEBUG) << TAG << "Unit " << static_cast<int>(unitId) << " responded with exception "
+                               << static_cast<int>(exception) << ".";
+                finish(transaction, false, transaction->pipelined && exception == SERVER_DEVICE_BUSY, completions);
+            }
+            else
+            {
+                const auto begin = buffer.cbegin() + static_cast<std::ptrdiff_t>(offset + 8);
+                const auto end = buffer.cbegin() + static_cast<std::ptrdiff_t>(offset + frameSize);
+                finish(transaction, true, false, completions, std::vector<std::uint8_t>(begin, end));
+            }
+        }
+        offset += frameSize;
+    }
+    buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+    return true;
+}
+
+void EpollTcpTransport::finish(const std::shared_ptr<Transaction>& transaction, bool success, bool rejected,
+                               Completions& completions, const std::vector<std::uint8_t>& data)
+{
+    auto& device = *transaction->device;
+    --device.inFlight;
+    if (success)
+        device.respondedAt = std::chrono::steady_clock::now();
+    if (rejected && device.maxInFlight > 1)
+    {
+        LOG(WARN) << TAG << "Device '" << device.name
+                  << "' does not handle pipelined requests. Falling back to one request at a time.";
+        device.maxInFlight = 1;
+    }
+    completions.emplace_back(complete(transaction, success, data));
+}
+
+void EpollTcpTransport::recordLatency(DeviceState& device, std::chrono::microseconds latency) const
+{
+    const auto& adaptiveTimeout = device.connection->adaptiveTimeout;
+    if (adaptiveTimeout == nullptr)
+        return;
+
+    device.latency.record(latency);
+    if (device.latency.getCount() < MIN_LATENCY_SAMPLES)
+        return;
+
+    const auto percentile = static_cast<double>(device.latency.percentile(LATENCY_PERCENTILE).count());
+    const auto timeout = std::min(
+      std::max(std::chrono::milliseconds{static_cast<std::int64_t>(
+                 std::ceil(percentile * adaptiveTimeout->getFactor() / 1000.0))},
+               adaptiveTimeout->getMinTimeout()),
+      adaptiveTimeout->getMaxTimeout());
+    if (device.responseTimeout.count() == 0)
+        LOG(DEBUG) << TAG << "Device '" << device.name << "' now uses a response timeout of " << timeout.count()
+                   << "ms.";
+    device.responseTimeout = timeout;
+}
+
+void EpollTcpTransport::backOff(DeviceState& device)
+{
+    // Until the next response, so a device that got slower isn't cut off by the timeout it used to have
+    const auto& adaptiveTimeout = device.connection->adaptiveTimeout;
+    if (adaptiveTimeout != nullptr && device.responseTimeout.count() > 0)
+        device.responseTimeout = std::min(device.responseTimeout * 2, adaptiveTimeout->getMaxTimeout());
+}
+
+std::function<void()> EpollTcpTransport::complete(const std::shared_ptr<Transaction>& transaction, bool success,
+                                                  const std::vector<std::uint8_t>& data)
+{
+    if (transaction->onWrite)
+        return [transaction, success] { transaction->onWrite(success); };
+
+    return [transaction, success, data] {
+        auto registers = std::vector<std::uint16_t>{};
+        auto bits = std::vector<bool>{};
+        auto valid = success && !data.empty();
+        if (valid)
+        {
+            const auto count = static_cast<std::size_t>(transaction->count);
+            const auto byteCount = static_cast<std::size_t>(data.front());
+            const auto functionCode = transaction->pdu.front();
+            if (functionCode == READ_COILS || functionCode == READ_DISCRETE_INPUTS)
+            {
+                valid = byteCount >= (count + 7) / 8 && data.size() >= byteCount + 1;
+                for (auto i = std::size_t{0}; valid && i < count; ++i)
+                    bits.emplace_back(((data[1 + i / 8] >> (i % 8)) & 1) != 0);
+            }
+            else
+            {
+                valid = byteCount == count * 2 && data.size() >= byteCount + 1;
+                for (auto i = std::size_t{0}; valid && i < count; ++i)
+                    registers.emplace_back(readWord(data, 1 + i * 2));
+            }
+        }
+        transaction->onRead(valid, registers, bits);
+    };
+}
+
+void EpollTcpTransport::wakeUp() const
+{
+    const auto value = std::uint64_t{1};
+    const auto written = ::write(m_wakeUpFd, &value, sizeof(value));
+    static_cast<void>(written);
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,291 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_EPOLLTCPTRANSPORT_H
+#define WOLKGATEWAYMODBUSMODULE_EPOLLTCPTRANSPORT_H
+
+#include "modbus/model/AdaptiveTimeoutConfiguration.h"
+#include "modbus/module/transport/LatencyHistogram.h"
+#include "modbus/module/transport/ModbusTransport.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Asynchronous Modbus TCP transport, where a single thread drives non-blocking connections to all the
+ *        endpoints through one epoll instance.
+ * @details Requests are queued per endpoint, and the endpoints are served in parallel, so a slow or unreachable
+ *          endpoint only delays its own requests. A request is queued behind the requests of its own priority, but
+ *          ahead of the less urgent ones. Responses are matched to requests by the MBAP transaction
+ *          identifier, and the callbacks are invoked from the transport thread.
+ *          A device that allows it can have many requests in flight at once. If such a device turns out not to
+ *          handle them, it falls back to a single request at a time.
+ *          With the adaptive timeout, every request is given the response timeout derived from the latency
+ *          histogram of its device, so a lost frame of a fast device is noticed in the time it usually takes to
+ *          respond, not in the time the slowest device on the endpoint takes.
+ */
+class EpollTcpTransport : public ModbusTransport
+{
+public:
+    /**
+     * Default constructor for the transport.
+     */
+    EpollTcpTransport();
+
+    /**
+     * Default destructor.
+     * Will stop the transport thread and close all the connections.
+     */
+    ~EpollTcpTransport() override;
+
+    /**
+     * This is the method that adds a TCP endpoint for a bus. Buses with the same endpoint share the connection.
+     * The host is resolved here, once, so the transport thread never waits for a lookup.
+     *
+     * @param bus The name of the bus.
+     * @param host The IP address or the host name of the endpoint.
+     * @param port The port of the endpoint.
+     * @param responseTimeout The time a request can wait for the response.
+     * @param adaptiveTimeout The rules of the adaptive timeout, nullptr if the response timeout is always used.
+     */
+    void addEndpoint(const std::string& bus, const std::string& host, std::uint16_t port,
+                     std::chrono::milliseconds responseTimeout,
+                     std::unique_ptr<AdaptiveTimeoutConfiguration> adaptiveTimeout = nullptr);
+
+    void addDevice(const std::shared_ptr<more_modbus::ModbusDevice>& device, const std::string& bus,
+                   std::uint16_t maxInFlight) override;
+
+    void start() override;
+
+    void stop() override;
+
+    bool isAsynchronous() const override;
+
+    void read(const more_modbus::ModbusDevice& device, more_modbus::RegisterType registerType, std::uint16_t address,
+              std::uint16_t count, Priority priority, ReadCallback callback) override;
+
+    void writeRegisters(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                        const std::vector<std::uint16_t>& values, Priority priority, WriteCallback callback) override;
+
+    void writeCoil(const more_modbus::ModbusDevice& device, std::uint16_t address, bool value, Priority priority,
+                   WriteCallback callback) override;
+
+    void writeCoils(const more_modbus::ModbusDevice& device, std::uint16_t address, const std::vector<bool>& values,
+                    Priority priority, WriteCallback callback) override;
+
+private:
+    struct Connection;
+
+    // The state of a single device behind a connection
+    struct DeviceState
+    {
+        std::string name;
+        Connection* connection;
+        std::uint16_t maxInFlight;
+        std::uint16_t inFlight = 0;
+        std::chrono::steady_clock::time_point respondedAt{};
+
+        // The measured latency, and the response timeout derived from it, zero until enough is measured
+        LatencyHistogram latency{};
+        std::chrono::milliseconds responseTimeout{0};
+    };
+
+    // A single request, from being submitted until its response arrives or it fails
+    struct Transaction
+    {
+        std::uint8_t unitId;
+        std::vector<std::uint8_t> pdu;
+        std::uint16_t count;
+        ReadCallback onRead;
+        WriteCallback onWrite;
+        Priority priority = Priority::POLL;
+        DeviceState* device = nullptr;
+        bool pipelined = false;
+        std::chrono::steady_clock::time_point sentAt{};
+        std::chrono::steady_clock::time_point deadline{};
+    };
+
+    // A single TCP connection to an endpoint, with the requests for all the devices behind it
+    struct Connection
+    {
+        std::string host;
+        std::uint16_t port;
+        std::chrono::milliseconds responseTimeout;
+
+        // The address the host resolved to, the length is zero if it could not be resolved
+        sockaddr_storage address{};
+        socklen_t addressLength = 0;
+        std::unique_ptr<AdaptiveTimeoutConfiguration> adaptiveTimeout;
+
+        int fd = -1;
+        bool connecting = false;
+        bool connected = false;
+        bool sendBlocked = false;
+        std::chrono::steady_clock::time_point connectDeadline{};
+        std::chrono::steady_clock::time_point reconnectAt{};
+
+        // Ordered by the priority, and by the submission within the same priority
+        std::deque<std::shared_ptr<Transaction>> pending;
+        std::map<std::uint16_t, std::shared_ptr<Transaction>> inFlight;
+        std::uint16_t nextTransactionId = 0;
+
+        std::vector<std::uint8_t> sendBuffer;
+        std::vector<std::uint8_t> receiveBuffer;
+    };
+
+    using Completions = std::vector<std::function<void()>>;
+
+    /**
+     * This is a helper method that queues a request for the connection of the device.
+     *
+     * @param device The device the request is for.
+     * @param transaction The request.
+     */
+    void submit(const more_modbus::ModbusDevice& device, std::shared_ptr<Transaction> transaction);
+
+    /**
+     * This is the method executed by the transport thread.
+     */
+    void run();
+
+    /**
+     * This is a helper method that connects, sends the queued requests and expires the requests of all
+     * connections. Called under the lock.
+     *
+     * @param completions The callbacks of the requests that got completed.
+     * @return The time until something needs to be checked again.
+     */
+    std::chrono::milliseconds service(Completions& completions);
+
+    /**
+     * This is a helper method that handles the events of a single connection. Called under the lock.
+     *
+     * @param connection The connection.
+     * @param events The epoll events.
+     * @param completions The callbacks of the requests that got completed.
+     */
+    void handleEvents(Connection& connection, std::uint32_t events, Completions& completions);
+
+    /**
+     * This is a helper method that starts a non-blocking connect to the endpoint. Called under the lock.
+     *
+     * @param connection The connection.
+     * @return Whether the connect was started.
+     */
+    bool openConnection(Connection& connection);
+
+    /**
+     * This is a helper method that closes the connection and fails all of its requests. Called under the lock.
+     *
+     * @param connection The connection.
+     * @param reason The reason that is logged.
+     * @param completions The callbacks of the requests that got completed.
+     */
+    void closeConnection(Connection& connection, const std::string& reason, Completions& completions);
+
+    /**
+     * This is a helper method that sends as much of the send buffer as the socket accepts. Called under the lock.
+     *
+     * @param connection The connection.
+     * @return Whether the socket is still fine.
+     */
+    bool flush(Connection& connection);
+
+    /**
+     * This is a helper method that parses all the complete frames out of the receive buffer. Called under the lock.
+     *
+     * @param connection The connection.
+     * @param completions The callbacks of the requests that got completed.
+     * @return Whether the stream is still valid.
+     */
+    bool parseFrames(Connection& connection, Completions& completions);
+
+    /**
+     * This is a helper method that finishes a request that was in flight. Called under the lock.
+     *
+     * @param transaction The request.
+     * @param success Whether the request was successful.
+     * @param rejected Whether the failure shows that the device doesn't handle pipelined requests.
+     * @param completions The callbacks of the requests that got completed.
+     * @param data The data of the response, starting after the function code.
+     */
+    void finish(const std::shared_ptr<Transaction>& transaction, bool success, bool rejected,
+                Completions& completions, const std::vector<std::uint8_t>& data = {});
+
+    /**
+     * This is a helper method that records the latency of a request, and updates the response timeout of the
+     * device if the adaptive timeout is used. Called under the lock.
+     *
+     * @param device The device.
+     * @param latency The time from sending the request until the response.
+     */
+    void recordLatency(DeviceState& device, std::chrono::microseconds latency) const;
+
+    /**
+     * This is a helper method that doubles the adapted response timeout of the device after a request timed out.
+     * Called under the lock.
+     *
+     * @param device The device.
+     */
+    static void backOff(DeviceState& device);
+
+    /**
+     * This is a helper method that creates the completion of a request.
+     *
+     * @param transaction The request.
+     * @param success Whether the request was successful.
+     * @param data The data of the response, starting after the function code.
+     * @return The completion.
+     */
+    static std::function<void()> complete(const std::shared_ptr<Transaction>& transaction, bool success,
+                                          const std::vector<std::uint8_t>& data = {});
+
+    /**
+     * This is a helper method that wakes up the transport thread.
+     */
+    void wakeUp() const;
+
+    const std::string TAG = "[EpollTcpTransport] -> ";
+
+    // The endpoints, shared among buses, and the states of the devices, guarded by the lock
+    std::map<std::string, std::unique_ptr<Connection>> m_connections;
+    std::map<std::string, Connection*> m_connectionByBus;
+    std::map<const more_modbus::ModbusDevice*, std::unique_ptr<DeviceState>> m_devices;
+    std::mutex m_mutex;
+
+    // The epoll instance, and the eventfd used to wake the thread up when requests are submitted
+    int m_epollFd;
+    int m_wakeUpFd;
+
+    // The thread
+    std::atomic_bool m_running;
+    std::unique_ptr<std::thread> m_thread;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_EPOLLTCPTRANSPORT_H
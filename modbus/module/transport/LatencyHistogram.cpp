@@ -0,0 +1,77 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/transport/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// The upper bound of the first bucket
+const double FIRST_BOUND_US = 100.0;
+const double BUCKETS_PER_DOUBLING = 4.0;
+}    // namespace
+
+void LatencyHistogram::record(std::chrono::microseconds latency)
+{
+    const auto ratio = static_cast<double>(latency.count()) / FIRST_BOUND_US;
+    const auto index = ratio <= 1.0 ? 0.0 : std::ceil(std::log2(ratio) * BUCKETS_PER_DOUBLING);
+    const auto bucket = std::min(static_cast<std::size_t>(index), BUCKET_COUNT - 1);
+    ++m_buckets[bucket];
+    ++m_count;
+
+    if (m_count >= WINDOW)
+    {
+        m_count = 0;
+        for (auto& count : m_buckets)
+        {
+            count /= 2;
+            m_count += count;
+        }
+    }
+}
+
+std::uint32_t LatencyHistogram::getCount() const
+{
+    return m_count;
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double percentile) const
+{
+    if (m_count == 0)
+        return std::chrono::microseconds{0};
+
+    const auto target = std::max(std::ceil(static_cast<double>(m_count) * percentile / 100.0), 1.0);
+    auto cumulative = 0.0;
+    for (auto bucket = std::size_t{0}; bucket < BUCKET_COUNT; ++bucket)
+    {
+        cumulative += m_buckets[bucket];
+        if (cumulative >= target)
+            return upperBound(bucket);
+    }
+    return upperBound(BUCKET_COUNT - 1);
+}
+
+std::chrono::microseconds LatencyHistogram::upperBound(std::size_t bucket)
+{
+    return std::chrono::microseconds{static_cast<std::int64_t>(
+      FIRST_BOUND_US * std::exp2(static_cast<double>(bucket) / BUCKETS_PER_DOUBLING))};
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,75 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_LATENCYHISTOGRAM_H
+#define WOLKGATEWAYMODBUSMODULE_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Histogram of the response latency of a single device.
+ * @details Buckets grow exponentially, four per doubling, from 100us up to several seconds, so a percentile is known
+ *          within a fifth of its value. Once the window is filled, all the counts are halved, so the histogram
+ *          follows the recent latency of the device.
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     * This is the method that records a single latency.
+     *
+     * @param latency The latency.
+     */
+    void record(std::chrono::microseconds latency);
+
+    /**
+     * This is the method that returns the count of latencies the histogram currently holds.
+     *
+     * @return The count.
+     */
+    std::uint32_t getCount() const;
+
+    /**
+     * This is the method that returns the latency under which the percentage of recorded latencies are.
+     *
+     * @param percentile The percentage, between 0 and 100.
+     * @return The upper bound of the bucket holding the percentile. Zero if nothing has been recorded.
+     */
+    std::chrono::microseconds percentile(double percentile) const;
+
+private:
+    static const std::size_t BUCKET_COUNT = 64;
+    static const std::uint32_t WINDOW = 1024;
+
+    /**
+     * This is a helper method that returns the highest latency that falls into the bucket.
+     *
+     * @param bucket The index of the bucket.
+     * @return The upper bound of the bucket.
+     */
+    static std::chrono::microseconds upperBound(std::size_t bucket);
+
+    std::array<std::uint32_t, BUCKET_COUNT> m_buckets{};
+    std::uint32_t m_count = 0;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_LATENCYHISTOGRAM_H
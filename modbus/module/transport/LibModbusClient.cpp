@@ -0,0 +1,233 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/transport/LibModbusClient.h"
+
+#include "core/utilities/Logger.h"
+
+#include <cerrno>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+const std::int64_t MICROSECONDS_PER_SECOND = 1000000;
+
+char parityOf(more_modbus::LibModbusSerialRtuClient::BitParity bitParity)
+{
+    switch (bitParity)
+    {
+    case more_modbus::LibModbusSerialRtuClient::BitParity::EVEN:
+        return 'E';
+    case more_modbus::LibModbusSerialRtuClient::BitParity::ODD:
+        return 'O';
+    default:
+        return 'N';
+    }
+}
+}    // namespace
+
+LibModbusClient::LibModbusClient(const std::string& ip, int port, std::chrono::milliseconds responseTimeout)
+: m_context(modbus_new_tcp(ip.c_str(), port))
+, m_description(ip + ":" + std::to_string(port))
+, m_connected(false)
+, m_timedOut(false)
+{
+    if (m_context == nullptr)
+        LOG(ERROR) << TAG << "Failed to create the context for " << m_description << " - " << modbus_strerror(errno);
+    setResponseTimeout(responseTimeout);
+}
+
+LibModbusClient::LibModbusClient(const std::string& serialPort, int baudRate, char dataBits, char stopBits,
+                                 more_modbus::LibModbusSerialRtuClient::BitParity bitParity,
+                                 std::chrono::milliseconds responseTimeout)
+: m_context(modbus_new_rtu(serialPort.c_str(), baudRate, parityOf(bitParity), dataBits, stopBits))
+, m_description(serialPort)
+, m_connected(false)
+, m_timedOut(false)
+{
+    if (m_context == nullptr)
+        LOG(ERROR) << TAG << "Failed to create the context for " << m_description << " - " << modbus_strerror(errno);
+    setResponseTimeout(responseTimeout);
+}
+
+LibModbusClient::~LibModbusClient()
+{
+    disconnect();
+    if (m_context != nullptr)
+        modbus_free(m_context);
+}
+
+bool LibModbusClient::connect()
+{
+    if (m_connected)
+        return true;
+    if (m_context == nullptr)
+        return false;
+
+    if (modbus_connect(m_context) == -1)
+    {
+        LOG(DEBUG) << TAG << "Failed to connect to " << m_description << " - " << modbus_strerror(errno);
+        return false;
+    }
+    m_connected = true;
+    return true;
+}
+
+void LibModbusClient::disconnect()
+{
+    if (!m_connected)
+        return;
+
+    modbus_close(m_context);
+    m_connected = false;
+}
+
+bool LibModbusClient::isConnected() const
+{
+    return m_connected;
+}
+
+void LibModbusClient::setResponseTimeout(std::chrono::milliseconds responseTimeout)
+{
+    if (m_context == nullptr)
+        return;
+
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(responseTimeout).count();
+    modbus_set_response_timeout(m_context, static_cast<std::uint32_t>(microseconds / MICROSECONDS_PER_SECOND),
+                                static_cast<std::uint32_t>(microseconds % MICROSECONDS_PER_SECOND));
+}
+
+bool LibModbusClient::hasTimedOut() const
+{
+    return m_timedOut;
+}
+
+bool LibModbusClient::readCoils(int slaveAddress, int address, int count, std::vector<bool>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    auto bits = std::vector<std::uint8_t>(static_cast<std::size_t>(count));
+    if (!check(modbus_read_bits(m_context, address, count, bits.data()), "read coils"))
+        return false;
+    values.assign(bits.cbegin(), bits.cend());
+    return true;
+}
+
+bool LibModbusClient::readInputContacts(int slaveAddress, int address, int count, std::vector<bool>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    auto bits = std::vector<std::uint8_t>(static_cast<std::size_t>(count));
+    if (!check(modbus_read_input_bits(m_context, address, count, bits.data()), "read input contacts"))
+        return false;
+    values.assign(bits.cbegin(), bits.cend());
+    return true;
+}
+
+bool LibModbusClient::readHoldingRegisters(int slaveAddress, int address, int count,
+                                           std::vector<std::uint16_t>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    values.resize(static_cast<std::size_t>(count));
+    return check(modbus_read_registers(m_context, address, count, values.data()), "read holding registers");
+}
+
+bool LibModbusClient::readInputRegisters(int slaveAddress, int address, int count, std::vector<std::uint16_t>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    values.resize(static_cast<std::size_t>(count));
+    return check(modbus_read_input_registers(m_context, address, count, values.data()), "read input registers");
+}
+
+bool LibModbusClient::writeHoldingRegister(int slaveAddress, int address, std::uint16_t value)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    return check(modbus_write_register(m_context, address, value), "write holding register");
+}
+
+bool LibModbusClient::writeHoldingRegisters(int slaveAddress, int address, const std::vector<std::uint16_t>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    return check(modbus_write_registers(m_context, address, static_cast<int>(values.size()), values.data()),
+                 "write holding registers");
+}
+
+bool LibModbusClient::writeCoil(int slaveAddress, int address, bool value)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    return check(modbus_write_bit(m_context, address, value ? 1 : 0), "write coil");
+}
+
+bool LibModbusClient::writeCoils(int slaveAddress, int address, const std::vector<bool>& values)
+{
+    if (!select(slaveAddress))
+        return false;
+
+    const auto bits = std::vector<std::uint8_t>(values.cbegin(), values.cend());
+    return check(modbus_write_bits(m_context, address, static_cast<int>(bits.size()), bits.data()), "write coils");
+}
+
+bool LibModbusClient::select(int slaveAddress)
+{
+    m_timedOut = false;
+    if (!m_connected)
+        return false;
+
+    if (modbus_set_slave(m_context, slaveAddress) == -1)
+    {
+        LOG(ERROR) << TAG << "Invalid slave address " << slaveAddress << ".";
+        return false;
+    }
+    return true;
+}
+
+bool LibModbusClient::check(int result, const char* request)
+{
+    if (result != -1)
+        return true;
+
+    const auto error = errno;
+    LOG(DEBUG) << TAG << "Failed to " << request << " on " << m_description << " - " << modbus_strerror(error);
+    if (error == ETIMEDOUT)
+    {
+        // A response that arrives late must not be taken for the response of the next request
+        m_timedOut = true;
+        modbus_flush(m_context);
+    }
+    else if (error < MODBUS_ENOBASE)
+    {
+        // Anything but a timeout or a faulty response means the connection is broken
+        disconnect();
+    }
+    return false;
+}
+}    // namespace wolkabout::modbus
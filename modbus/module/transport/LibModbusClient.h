@@ -0,0 +1,133 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef WOLKGATEWAYMODBUSMODULE_LIBMODBUSCLIENT_H
+#define WOLKGATEWAYMODBUSMODULE_LIBMODBUSCLIENT_H
+
+#include "more_modbus/modbus/LibModbusSerialRtuClient.h"
+
+#include <modbus/modbus.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Blocking client sending the requests of a single bus through libmodbus.
+ * @details Unlike the MoreModbus clients, its response timeout can be changed before every request, so the
+ *          timeout can follow the latency of the device the request is for. The client is not thread safe, its
+ *          user must make sure only one request is on the bus at a time.
+ */
+class LibModbusClient
+{
+public:
+    /**
+     * Constructor for a client of a TCP/IP bus.
+     *
+     * @param ip The address of the server.
+     * @param port The port of the server.
+     * @param responseTimeout The response timeout used until another one is set.
+     */
+    LibModbusClient(const std::string& ip, int port, std::chrono::milliseconds responseTimeout);
+
+    /**
+     * Constructor for a client of a Serial/RTU bus.
+     *
+     * @param serialPort The path of the serial port.
+     * @param baudRate The baud rate.
+     * @param dataBits The count of data bits.
+     * @param stopBits The count of stop bits.
+     * @param bitParity The parity.
+     * @param responseTimeout The response timeout used until another one is set.
+     */
+    LibModbusClient(const std::string& serialPort, int baudRate, char dataBits, char stopBits,
+                    more_modbus::LibModbusSerialRtuClient::BitParity bitParity,
+                    std::chrono::milliseconds responseTimeout);
+
+    LibModbusClient(const LibModbusClient&) = delete;
+
+    LibModbusClient& operator=(const LibModbusClient&) = delete;
+
+    ~LibModbusClient();
+
+    bool connect();
+
+    void disconnect();
+
+    bool isConnected() const;
+
+    /**
+     * This is the method that sets the response timeout of the following requests.
+     *
+     * @param responseTimeout The response timeout.
+     */
+    void setResponseTimeout(std::chrono::milliseconds responseTimeout);
+
+    /**
+     * This is the method that tells whether the last failed request failed because no response arrived in time.
+     *
+     * @return Whether the last request timed out.
+     */
+    bool hasTimedOut() const;
+
+    bool readCoils(int slaveAddress, int address, int count, std::vector<bool>& values);
+
+    bool readInputContacts(int slaveAddress, int address, int count, std::vector<bool>& values);
+
+    bool readHoldingRegisters(int slaveAddress, int address, int count, std::vector<std::uint16_t>& values);
+
+    bool readInputRegisters(int slaveAddress, int address, int count, std::vector<std::uint16_t>& values);
+
+    bool writeHoldingRegister(int slaveAddress, int address, std::uint16_t value);
+
+    bool writeHoldingRegisters(int slaveAddress, int address, const std::vector<std::uint16_t>& values);
+
+    bool writeCoil(int slaveAddress, int address, bool value);
+
+    bool writeCoils(int slaveAddress, int address, const std::vector<bool>& values);
+
+private:
+    /**
+     * This is a helper method that addresses the following requests to a slave.
+     *
+     * @param slaveAddress The address of the slave.
+     * @return Whether the client is connected, and the slave was set.
+     */
+    bool select(int slaveAddress);
+
+    /**
+     * This is a helper method that checks the result of a request, and handles its failure.
+     *
+     * @param result The value libmodbus returned for the request.
+     * @param request The name of the request, for the log.
+     * @return Whether the request was successful.
+     */
+    bool check(int result, const char* request);
+
+    const std::string TAG = "[LibModbusClient] -> ";
+
+    modbus_t* m_context;
+    std::string m_description;
+    bool m_connected;
+    bool m_timedOut;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_LIBMODBUSCLIENT_H
@@ -0,0 +1,240 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/module/transport/ModbusClientTransport.h"
+
+#include "core/utilities/Logger.h"
+#include "modbus/module/transport/LibModbusClient.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace wolkabout::legacy;
+
+namespace wolkabout::modbus
+{
+namespace
+{
+// The count of latencies that need to be measured before the adaptive timeout is used
+const std::uint32_t MIN_LATENCY_SAMPLES = 20;
+const double LATENCY_PERCENTILE = 99.0;
+// The most coils a single request can write
+const std::size_t MAX_COILS_PER_WRITE = 1968;
+}    // namespace
+
+ModbusClientTransport::ModbusClientTransport(std::shared_ptr<LibModbusClient> modbusClient,
+                                             std::chrono::milliseconds responseTimeout,
+                                             std::unique_ptr<AdaptiveTimeoutConfiguration> adaptiveTimeout)
+: m_modbusClient(std::move(modbusClient))
+, m_busy(false)
+, m_waiting{}
+, m_connected(false)
+, m_responseTimeout(responseTimeout)
+, m_adaptiveTimeout(std::move(adaptiveTimeout))
+{
+}
+
+void ModbusClientTransport::addDevice(const std::shared_ptr<more_modbus::ModbusDevice>&, const std::string&,
+                                      std::uint16_t)
+{
+}
+
+void ModbusClientTransport::start() {}
+
+void ModbusClientTransport::stop()
+{
+    perform(Priority::WRITE, [&] {
+        m_modbusClient->disconnect();
+        m_connected = false;
+        return true;
+    });
+}
+
+bool ModbusClientTransport::isAsynchronous() const
+{
+    return false;
+}
+
+void ModbusClientTransport::read(const more_modbus::ModbusDevice& device, more_modbus::RegisterType registerType,
+                                 std::uint16_t address, std::uint16_t count, Priority priority, ReadCallback callback)
+{
+    auto registers = std::vector<std::uint16_t>{};
+    auto bits = std::vector<bool>{};
+    const auto slaveAddress = device.getSlaveAddress();
+    const auto success = perform(priority, [&] {
+        return send(slaveAddress, [&] {
+            switch (registerType)
+            {
+            case more_modbus::RegisterType::COIL:
+                return m_modbusClient->readCoils(slaveAddress, address, count, bits);
+            case more_modbus::RegisterType::INPUT_CONTACT:
+                return m_modbusClient->readInputContacts(slaveAddress, address, count, bits);
+            case more_modbus::RegisterType::HOLDING_REGISTER:
+                return m_modbusClient->readHoldingRegisters(slaveAddress, address, count, registers);
+            case more_modbus::RegisterType::INPUT_REGISTER:
+                return m_modbusClient->readInputRegisters(slaveAddress, address, count, registers);
+            }
+            return false;
+        });
+    });
+    callback(success, registers, bits);
+}
+
+void ModbusClientTransport::writeRegisters(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                                           const std::vector<std::uint16_t>& values, Priority priority,
+                                           WriteCallback callback)
+{
+    const auto slaveAddress = device.getSlaveAddress();
+    const auto success = perform(priority, [&] {
+        if (values.empty())
+            return false;
+
+        return send(slaveAddress, [&] {
+            if (values.size() == 1)
+                return m_modbusClient->writeHoldingRegister(slaveAddress, address, values.front());
+            return m_modbusClient->writeHoldingRegisters(slaveAddress, address, values);
+        });
+    });
+    callback(success);
+}
+
+void ModbusClientTransport::writeCoil(const more_modbus::ModbusDevice& device, std::uint16_t address, bool value,
+                                      Priority priority, WriteCallback callback)
+{
+    const auto slaveAddress = device.getSlaveAddress();
+    const auto success = perform(priority, [&] {
+        return send(slaveAddress, [&] { return m_modbusClient->writeCoil(slaveAddress, address, value); });
+    });
+    callback(success);
+}
+
+void ModbusClientTransport::writeCoils(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                                       const std::vector<bool>& values, Priority priority, WriteCallback callback)
+{
+    const auto slaveAddress = device.getSlaveAddress();
+    const auto success = perform(priority, [&] {
+        if (values.empty())
+            return false;
+        for (auto first = std::size_t{0}; first < values.size(); first += MAX_COILS_PER_WRITE)
+        {
+            const auto last = std::min(first + MAX_COILS_PER_WRITE, values.size());
+            const auto coils = std::vector<bool>(values.cbegin() + static_cast<std::ptrdiff_t>(first),
+                                                 values.cbegin() + static_cast<std::ptrdiff_t>(last));
+            if (!send(slaveAddress, [&] {
+                    return m_modbusClient->writeCoils(slaveAddress, static_cast<int>(address + first), coils);
+                }))
+                return false;
+        }
+        return true;
+    });
+    callback(success);
+}
+
+bool ModbusClientTransport::perform(Priority priority, const std::function<bool()>& request)
+{
+    const auto lane = static_cast<std::size_t>(priority);
+    {
+        auto lock = std::unique_lock<std::mutex>{m_mutex};
+        ++m_waiting[lane];
+        m_condition.wait(lock, [&] {
+            return !m_busy &&
+                   std::all_of(m_waiting.cbegin(), m_waiting.cbegin() + static_cast<std::ptrdiff_t>(lane),
+                               [](std::size_t waiting) { return waiting == 0; });
+        });
+        --m_waiting[lane];
+        m_busy = true;
+    }
+
+    // The client is used outside of the lock, so the other threads can queue up for the bus in the meantime
+    auto success = false;
+    try
+    {
+        success = request();
+    }
+    catch (const std::exception& exception)
+    {
+        LOG(ERROR) << TAG << "Request failed - '" << exception.what() << "'.";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_busy = false;
+    }
+    m_condition.notify_all();
+    return success;
+}
+
+bool ModbusClientTransport::ensureConnected()
+{
+    if (m_modbusClient->isConnected() || m_modbusClient->connect())
+    {
+        if (!m_connected)
+            LOG(INFO) << TAG << "Modbus client connected.";
+        m_connected = true;
+        return true;
+    }
+
+    if (m_connected)
+        LOG(WARN) << TAG << "Modbus client lost the connection.";
+    m_connected = false;
+    return false;
+}
+
+bool ModbusClientTransport::send(int slaveAddress, const std::function<bool()>& request)
+{
+    if (!ensureConnected())
+        return false;
+    if (m_adaptiveTimeout == nullptr)
+        return request();
+
+    auto& slave = m_slaves[slaveAddress];
+    m_modbusClient->setResponseTimeout(slave.responseTimeout.count() > 0 ? slave.responseTimeout :
+                                                                           m_responseTimeout);
+    const auto sentAt = std::chrono::steady_clock::now();
+    const auto success = request();
+    if (success)
+    {
+        recordLatency(slaveAddress, slave,
+                      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sentAt));
+    }
+    else if (m_modbusClient->hasTimedOut() && slave.responseTimeout.count() > 0)
+    {
+        // Until the next response, so a slave that got slower isn't cut off by the timeout it used to have
+        slave.responseTimeout = std::min(slave.responseTimeout * 2, m_adaptiveTimeout->getMaxTimeout());
+    }
+    return success;
+}
+
+void ModbusClientTransport::recordLatency(int slaveAddress, SlaveLatency& slave,
+                                          std::chrono::microseconds latency) const
+{
+    slave.latency.record(latency);
+    if (slave.latency.getCount() < MIN_LATENCY_SAMPLES)
+        return;
+
+    const auto percentile = static_cast<double>(slave.latency.percentile(LATENCY_PERCENTILE).count());
+    const auto timeout = std::min(
+      std::max(std::chrono::milliseconds{static_cast<std::int64_t>(
+                 std::ceil(percentile * m_adaptiveTimeout->getFactor() / 1000.0))},
+               m_adaptiveTimeout->getMinTimeout()),
+      m_adaptiveTimeout->getMaxTimeout());
+    if (slave.responseTimeout.count() == 0)
+        LOG(DEBUG) << TAG << "Slave " << slaveAddress << " now uses a response timeout of " << timeout.count()
+                   << "ms.";
+    slave.responseTimeout = timeout;
+}
+}    // namespace wolkabout::modbus
@@ -0,0 +1,144 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_MODBUSCLIENTTRANSPORT_H
+#define WOLKGATEWAYMODBUSMODULE_MODBUSCLIENTTRANSPORT_H
+
+#include "modbus/model/AdaptiveTimeoutConfiguration.h"
+#include "modbus/module/transport/LatencyHistogram.h"
+#include "modbus/module/transport/ModbusTransport.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+namespace modbus
+{
+class LibModbusClient;
+
+/**
+ * @brief Synchronous transport, sending the requests through a blocking libmodbus client.
+ * @details Every request is performed in the calling thread, one at a time, and its callback is invoked before
+ *          the call returns. Threads waiting for the bus get it by the priority of their requests.
+ *          A block of coils is written by a single request, or by one request per 1968 coils if it's longer.
+ *          With the adaptive timeout, the latency of every slave is measured, and the client is given the timeout of
+ *          the slave before each request.
+ */
+class ModbusClientTransport : public ModbusTransport
+{
+public:
+    /**
+     * Default constructor for the transport.
+     *
+     * @param modbusClient The client through which all the requests are sent.
+     * @param responseTimeout The response timeout of the bus.
+     * @param adaptiveTimeout The rules deriving the response timeout of every slave from its latency, nullptr if the
+     *                        response timeout of the bus is always used.
+     */
+    ModbusClientTransport(std::shared_ptr<LibModbusClient> modbusClient, std::chrono::milliseconds responseTimeout,
+                          std::unique_ptr<AdaptiveTimeoutConfiguration> adaptiveTimeout = nullptr);
+
+    void addDevice(const std::shared_ptr<more_modbus::ModbusDevice>& device, const std::string& bus,
+                   std::uint16_t maxInFlight) override;
+
+    void start() override;
+
+    void stop() override;
+
+    bool isAsynchronous() const override;
+
+    void read(const more_modbus::ModbusDevice& device, more_modbus::RegisterType registerType, std::uint16_t address,
+              std::uint16_t count, Priority priority, ReadCallback callback) override;
+
+    void writeRegisters(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                        const std::vector<std::uint16_t>& values, Priority priority, WriteCallback callback) override;
+
+    void writeCoil(const more_modbus::ModbusDevice& device, std::uint16_t address, bool value, Priority priority,
+                   WriteCallback callback) override;
+
+    void writeCoils(const more_modbus::ModbusDevice& device, std::uint16_t address, const std::vector<bool>& values,
+                    Priority priority, WriteCallback callback) override;
+
+private:
+    // The measured latency of a slave, and the response timeout derived from it, zero until there are enough samples
+    struct SlaveLatency
+    {
+        LatencyHistogram latency;
+        std::chrono::milliseconds responseTimeout{0};
+    };
+
+    /**
+     * This is a helper method that performs a request once the bus is free, and no request of a higher priority is
+     * waiting for it.
+     *
+     * @param priority The lane of the request.
+     * @param request The function performing the request through the client.
+     * @return Whether the request was successful.
+     */
+    bool perform(Priority priority, const std::function<bool()>& request);
+
+    /**
+     * This is a helper method that makes sure the client is connected. Must be called while holding the bus.
+     *
+     * @return Whether the client is connected.
+     */
+    bool ensureConnected();
+
+    /**
+     * This is a helper method that sends a single request to a slave, with the response timeout of the slave, and
+     * measures its latency. Must be called while holding the bus.
+     *
+     * @param slaveAddress The address of the slave.
+     * @param request The function sending the request through the client.
+     * @return Whether the request was successful.
+     */
+    bool send(int slaveAddress, const std::function<bool()>& request);
+
+    /**
+     * This is a helper method that records the latency of a request, and updates the response timeout of the slave.
+     * Must be called while holding the bus.
+     *
+     * @param slaveAddress The address of the slave.
+     * @param slave The latency of the slave.
+     * @param latency The time from sending the request until the response.
+     */
+    void recordLatency(int slaveAddress, SlaveLatency& slave, std::chrono::microseconds latency) const;
+
+    const std::string TAG = "[ModbusClientTransport] -> ";
+
+    // The client, and the state making sure only one request is on the bus, guarded by the lock
+    std::shared_ptr<LibModbusClient> m_modbusClient;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_busy;
+    std::array<std::size_t, static_cast<std::size_t>(Priority::POLL) + 1> m_waiting;
+    bool m_connected;
+
+    // The response timeouts, and the latencies of the slaves, used only while holding the bus
+    std::chrono::milliseconds m_responseTimeout;
+    std::unique_ptr<AdaptiveTimeoutConfiguration> m_adaptiveTimeout;
+    std::map<int, SlaveLatency> m_slaves;
+};
+}    // namespace modbus
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_MODBUSCLIENTTRANSPORT_H
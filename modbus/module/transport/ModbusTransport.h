@@ -0,0 +1,134 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_MODBUSTRANSPORT_H
+#define WOLKGATEWAYMODBUSMODULE_MODBUSTRANSPORT_H
+
+#include "more_modbus/ModbusDevice.h"
+#include "more_modbus/RegisterMapping.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout::modbus
+{
+/**
+ * @brief Interface of the way requests are sent to Modbus devices.
+ * @details Every request is completed by invoking its callback exactly once, either from the calling thread
+ *          (synchronous transports) or from the thread of the transport (asynchronous transports).
+ *          Requests waiting for the bus are served by their priority, so a write is sent between any two polls.
+ */
+class ModbusTransport
+{
+public:
+    using ReadCallback =
+      std::function<void(bool success, const std::vector<std::uint16_t>& registers, const std::vector<bool>& bits)>;
+    using WriteCallback = std::function<void(bool success)>;
+
+    // The lanes of requests, from the most urgent one
+    enum class Priority
+    {
+        WRITE,
+        FORCED_READ,
+        POLL
+    };
+
+    virtual ~ModbusTransport() = default;
+
+    /**
+     * This is the method that lets the transport know about a device, and the bus it is on.
+     *
+     * @param device The device.
+     * @param bus The name of the bus the device is on.
+     * @param maxInFlight The count of requests the device can have in flight, if the transport can pipeline them.
+     */
+    virtual void addDevice(const std::shared_ptr<more_modbus::ModbusDevice>& device, const std::string& bus,
+                           std::uint16_t maxInFlight) = 0;
+
+    /**
+     * This is the method that starts the transport. Calling it when the transport is running does nothing.
+     */
+    virtual void start() = 0;
+
+    /**
+     * This is the method that stops the transport, and closes its connections.
+     */
+    virtual void stop() = 0;
+
+    /**
+     * This is the method that returns whether the requests are completed from another thread. If so, many requests
+     * can be submitted without waiting for the previous ones to complete.
+     *
+     * @return Whether the transport is asynchronous.
+     */
+    virtual bool isAsynchronous() const = 0;
+
+    /**
+     * This is the method that reads a block of registers/bits of a device.
+     *
+     * @param device The device that is read.
+     * @param registerType The type of the registers, selects the function code.
+     * @param address The first address.
+     * @param count The count of registers/bits.
+     * @param priority The lane of the request.
+     * @param callback The callback invoked with the result.
+     */
+    virtual void read(const more_modbus::ModbusDevice& device, more_modbus::RegisterType registerType,
+                      std::uint16_t address, std::uint16_t count, Priority priority, ReadCallback callback) = 0;
+
+    /**
+     * This is the method that writes holding registers of a device.
+     *
+     * @param device The device that is written.
+     * @param address The first address.
+     * @param values The values of the registers.
+     * @param priority The lane of the request.
+     * @param callback The callback invoked with the result.
+     */
+    virtual void writeRegisters(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                                const std::vector<std::uint16_t>& values, Priority priority,
+                                WriteCallback callback) = 0;
+
+    /**
+     * This is the method that writes a coil of a device.
+     *
+     * @param device The device that is written.
+     * @param address The address of the coil.
+     * @param value The value of the coil.
+     * @param priority The lane of the request.
+     * @param callback The callback invoked with the result.
+     */
+    virtual void writeCoil(const more_modbus::ModbusDevice& device, std::uint16_t address, bool value,
+                           Priority priority, WriteCallback callback) = 0;
+
+    /**
+     * This is the method that writes a block of coils of a device.
+     *
+     * @param device The device that is written.
+     * @param address The address of the first coil.
+     * @param values The values of the coils.
+     * @param priority The lane of the request.
+     * @param callback The callback invoked with the result.
+     */
+    virtual void writeCoils(const more_modbus::ModbusDevice& device, std::uint16_t address,
+                            const std::vector<bool>& values, Priority priority, WriteCallback callback) = 0;
+};
+}    // namespace wolkabout::modbus
+
+#endif    // WOLKGATEWAYMODBUSMODULE_MODBUSTRANSPORT_H
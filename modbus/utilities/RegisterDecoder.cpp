@@ -0,0 +1,123 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/utilities/RegisterDecoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define WOLKGATEWAYMODBUSMODULE_DECODE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WOLKGATEWAYMODBUSMODULE_DECODE_NEON
+#endif
+#endif
+
+namespace wolkabout
+{
+namespace
+{
+// The count of words merged at once, as the words are kept on the stack while they're converted
+const std::size_t CHUNK_SIZE = 64;
+}    // namespace
+
+void RegisterDecoder::decodeUint16(const std::uint16_t* registers, std::size_t count, double* values)
+{
+    for (auto i = std::size_t{0}; i < count; ++i)
+        values[i] = registers[i];
+}
+
+void RegisterDecoder::decodeInt16(const std::uint16_t* registers, std::size_t count, double* values)
+{
+    for (auto i = std::size_t{0}; i < count; ++i)
+        values[i] = static_cast<std::int16_t>(registers[i]);
+}
+
+void RegisterDecoder::decodeUint32(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values)
+{
+    auto words = std::array<std::uint32_t, CHUNK_SIZE>{};
+    for (auto done = std::size_t{0}; done < count; done += CHUNK_SIZE)
+    {
+        const auto size = std::min(CHUNK_SIZE, count - done);
+        mergeWords(registers + 2 * done, size, bigEndian, words.data());
+        for (auto i = std::size_t{0}; i < size; ++i)
+            values[done + i] = words[i];
+    }
+}
+
+void RegisterDecoder::decodeInt32(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values)
+{
+    auto words = std::array<std::uint32_t, CHUNK_SIZE>{};
+    for (auto done = std::size_t{0}; done < count; done += CHUNK_SIZE)
+    {
+        const auto size = std::min(CHUNK_SIZE, count - done);
+        mergeWords(registers + 2 * done, size, bigEndian, words.data());
+        for (auto i = std::size_t{0}; i < size; ++i)
+            values[done + i] = static_cast<std::int32_t>(words[i]);
+    }
+}
+
+void RegisterDecoder::decodeFloat(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values)
+{
+    auto words = std::array<std::uint32_t, CHUNK_SIZE>{};
+    auto floats = std::array<float, CHUNK_SIZE>{};
+    for (auto done = std::size_t{0}; done < count; done += CHUNK_SIZE)
+    {
+        const auto size = std::min(CHUNK_SIZE, count - done);
+        mergeWords(registers + 2 * done, size, bigEndian, words.data());
+        std::memcpy(floats.data(), words.data(), size * sizeof(float));
+        for (auto i = std::size_t{0}; i < size; ++i)
+            values[done + i] = floats[i];
+    }
+}
+
+void RegisterDecoder::mergeWords(const std::uint16_t* registers, std::size_t count, bool bigEndian,
+                                 std::uint32_t* words)
+{
+    auto i = std::size_t{0};
+
+    // On a little endian target, a pair of registers loaded as a 32-bit lane already holds the little endian word,
+    // and the big endian one only needs its halves swapped
+#if defined(WOLKGATEWAYMODBUSMODULE_DECODE_SSE2)
+    for (; i + 4 <= count; i += 4)
+    {
+        auto lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + 2 * i));
+        if (bigEndian)
+            lanes = _mm_or_si128(_mm_slli_epi32(lanes, 16), _mm_srli_epi32(lanes, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i), lanes);
+    }
+#elif defined(WOLKGATEWAYMODBUSMODULE_DECODE_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        auto lanes = vld1q_u16(registers + 2 * i);
+        if (bigEndian)
+            lanes = vrev32q_u16(lanes);
+        vst1q_u32(words + i, vreinterpretq_u32_u16(lanes));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const auto first = static_cast<std::uint32_t>(registers[2 * i]);
+        const auto second = static_cast<std::uint32_t>(registers[2 * i + 1]);
+        words[i] = bigEndian ? (first << 16) | second : (second << 16) | first;
+    }
+}
+}    // namespace wolkabout
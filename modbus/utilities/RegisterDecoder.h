@@ -0,0 +1,97 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_REGISTERDECODER_H
+#define WOLKGATEWAYMODBUSMODULE_REGISTERDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wolkabout
+{
+/**
+ * @brief Collection of methods used to decode a block of consecutive values of the same type out of registers.
+ * @details The 32-bit values are merged out of their two registers several at a time, with SSE2 on x86 and NEON on
+ *          ARM, swapping the words of the big endian values on the way, and only then converted. Other targets merge
+ *          the registers one value at a time. The values are converted into doubles, as the filters of the mappings
+ *          compare them.
+ *          Big endian values hold the high word in the first register, little endian ones in the second.
+ */
+class RegisterDecoder
+{
+public:
+    /**
+     * This is the method that decodes consecutive unsigned 16-bit values.
+     *
+     * @param registers The registers, one per value.
+     * @param count The count of values.
+     * @param values The array into which the values are decoded.
+     */
+    static void decodeUint16(const std::uint16_t* registers, std::size_t count, double* values);
+
+    /**
+     * This is the method that decodes consecutive signed 16-bit values.
+     *
+     * @param registers The registers, one per value.
+     * @param count The count of values.
+     * @param values The array into which the values are decoded.
+     */
+    static void decodeInt16(const std::uint16_t* registers, std::size_t count, double* values);
+
+    /**
+     * This is the method that decodes consecutive unsigned 32-bit values.
+     *
+     * @param registers The registers, two per value.
+     * @param count The count of values.
+     * @param bigEndian Whether the high word of the values is in their first register.
+     * @param values The array into which the values are decoded.
+     */
+    static void decodeUint32(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values);
+
+    /**
+     * This is the method that decodes consecutive signed 32-bit values.
+     *
+     * @param registers The registers, two per value.
+     * @param count The count of values.
+     * @param bigEndian Whether the high word of the values is in their first register.
+     * @param values The array into which the values are decoded.
+     */
+    static void decodeInt32(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values);
+
+    /**
+     * This is the method that decodes consecutive 32-bit floating point values.
+     *
+     * @param registers The registers, two per value.
+     * @param count The count of values.
+     * @param bigEndian Whether the high word of the values is in their first register.
+     * @param values The array into which the values are decoded.
+     */
+    static void decodeFloat(const std::uint16_t* registers, std::size_t count, bool bigEndian, double* values);
+
+private:
+    /**
+     * This is a helper method that merges pairs of registers into 32-bit words.
+     *
+     * @param registers The registers, two per word.
+     * @param count The count of words.
+     * @param bigEndian Whether the high word is in the first register of the pair.
+     * @param words The array into which the words are merged.
+     */
+    static void mergeWords(const std::uint16_t* registers, std::size_t count, bool bigEndian, std::uint32_t* words);
+};
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_REGISTERDECODER_H
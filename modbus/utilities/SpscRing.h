@@ -0,0 +1,100 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WOLKGATEWAYMODBUSMODULE_SPSCRING_H
+#define WOLKGATEWAYMODBUSMODULE_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Bounded lock-free queue, with a single producer thread and a single consumer thread.
+ * @details The capacity is rounded up to a power of two. The producer and the consumer only ever wait for each other
+ *          through the two indexes, which are kept on their own cache lines. A push into a full ring fails, and
+ *          leaves the item with the caller.
+ *
+ * @tparam T The type of the items, needs to be default constructible and movable.
+ */
+template <class T> class SpscRing
+{
+public:
+    /**
+     * Default constructor for the ring.
+     *
+     * @param capacity The count of items the ring can hold, rounded up to a power of two.
+     */
+    explicit SpscRing(std::size_t capacity)
+    : m_items(roundUp(capacity)), m_mask(m_items.size() - 1), m_head(0), m_tail(0)
+    {
+    }
+
+    /**
+     * This is the method that adds an item to the ring. Must only be called by the producer.
+     *
+     * @param item The item.
+     * @return Whether the item was added, false if the ring is full.
+     */
+    bool push(T&& item)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_items.size())
+            return false;
+        m_items[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * This is the method that takes the oldest item out of the ring. Must only be called by the consumer.
+     *
+     * @param item The item that was taken out.
+     * @return Whether an item was taken out, false if the ring is empty.
+     */
+    bool pop(T& item)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        item = std::move(m_items[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t capacity() const { return m_items.size(); }
+
+private:
+    static std::size_t roundUp(std::size_t capacity)
+    {
+        auto size = std::size_t{1};
+        while (size < capacity)
+            size <<= 1;
+        return size;
+    }
+
+    std::vector<T> m_items;
+    std::size_t m_mask;
+
+    // The next item to take out, written by the consumer, and the next item to add, written by the producer
+    alignas(64) std::atomic<std::size_t> m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+};
+}    // namespace wolkabout
+
+#endif    // WOLKGATEWAYMODBUSMODULE_SPSCRING_H
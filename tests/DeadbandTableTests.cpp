@@ -0,0 +1,110 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "modbus/module/polling/DeadbandTable.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <limits>
+#include <vector>
+
+using namespace wolkabout::modbus;
+
+namespace
+{
+const double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+}    // namespace
+
+class DeadbandTableTests : public ::testing::Test
+{
+protected:
+    // Evaluates a single value of the only row, and returns whether it passed
+    bool evaluate(double value)
+    {
+        const auto values = std::vector<double>{value};
+        table.evaluate(values.data(), now);
+        return table.passes(0);
+    }
+
+    DeadbandTable table;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+};
+
+TEST_F(DeadbandTableTests, UnsentRowPasses)
+{
+    table.add(1.0, std::chrono::milliseconds{0}, true);
+
+    EXPECT_TRUE(evaluate(0.0));
+}
+
+TEST_F(DeadbandTableTests, ChangeWithinTheDeadbandIsHeldBack)
+{
+    table.add(1.0, std::chrono::milliseconds{0}, true);
+    table.accept(0, 10.0, now);
+
+    EXPECT_FALSE(evaluate(10.0));
+    EXPECT_FALSE(evaluate(10.5));
+    EXPECT_TRUE(evaluate(11.0));
+    EXPECT_TRUE(evaluate(8.5));
+}
+
+TEST_F(DeadbandTableTests, ValueThatStaysNanIsUnchanged)
+{
+    table.add(1.0, std::chrono::milliseconds{0}, true);
+    table.accept(0, NOT_A_NUMBER, now);
+
+    EXPECT_FALSE(evaluate(NOT_A_NUMBER));
+}
+
+TEST_F(DeadbandTableTests, ValueThatStaysNanIsUnchangedWithoutDeadband)
+{
+    table.add(0.0, std::chrono::milliseconds{0}, true);
+    table.accept(0, NOT_A_NUMBER, now);
+
+    EXPECT_FALSE(evaluate(NOT_A_NUMBER));
+}
+
+TEST_F(DeadbandTableTests, ValueTurningIntoOrOutOfNanPasses)
+{
+    table.add(1.0, std::chrono::milliseconds{0}, true);
+    table.accept(0, 10.0, now);
+    EXPECT_TRUE(evaluate(NOT_A_NUMBER));
+
+    table.accept(0, NOT_A_NUMBER, now);
+    EXPECT_TRUE(evaluate(10.0));
+}
+
+TEST_F(DeadbandTableTests, FrequencyFilterHoldsBackChange)
+{
+    table.add(1.0, std::chrono::milliseconds{1000}, true);
+    table.accept(0, 10.0, now);
+
+    const auto values = std::vector<double>{20.0};
+    EXPECT_TRUE(table.evaluate(values.data(), now + std::chrono::milliseconds{500}));
+    EXPECT_FALSE(table.passes(0));
+    EXPECT_FALSE(table.evaluate(values.data(), now + std::chrono::milliseconds{1000}));
+    EXPECT_TRUE(table.passes(0));
+}
+
+TEST_F(DeadbandTableTests, RowThatIsNotFilteredAlwaysPasses)
+{
+    table.add(1.0, std::chrono::milliseconds{0}, false);
+    table.accept(0, NOT_A_NUMBER, now);
+
+    EXPECT_TRUE(evaluate(NOT_A_NUMBER));
+}
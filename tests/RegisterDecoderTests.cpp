@@ -0,0 +1,154 @@
+/**
+ * Copyright 2022 Wolkabout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "modbus/utilities/RegisterDecoder.h"
+#include "more_modbus/utilities/DataParsers.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace wolkabout;
+using Endian = more_modbus::DataParsers::Endian;
+
+namespace
+{
+// The counts of values, covering the odd ones, the ones that leave a tail after the vector lanes, and the ones that
+// cross the chunks of the decoder
+const std::vector<std::size_t> COUNTS = {1, 2, 3, 4, 5, 7, 63, 64, 65, 129};
+}    // namespace
+
+class RegisterDecoderTests : public ::testing::Test
+{
+protected:
+    // The same registers for every run, with one register more than the values need, so the decoding can start at an
+    // odd offset too
+    static std::vector<std::uint16_t> randomRegisters(std::size_t count)
+    {
+        auto generator = std::mt19937{static_cast<std::mt19937::result_type>(count)};
+        auto distribution = std::uniform_int_distribution<std::uint32_t>{0, 0xFFFF};
+        auto registers = std::vector<std::uint16_t>(count + 1);
+        for (auto& value : registers)
+            value = static_cast<std::uint16_t>(distribution(generator));
+        return registers;
+    }
+
+    static std::vector<std::uint16_t> pairAt(const std::uint16_t* registers, std::size_t index)
+    {
+        return {registers[2 * index], registers[2 * index + 1]};
+    }
+
+    // The random registers make NaNs too, which are only equal as far as both being a NaN
+    static void expectSame(double expected, double actual, std::size_t index)
+    {
+        if (std::isnan(expected))
+            EXPECT_TRUE(std::isnan(actual)) << "at value " << index;
+        else
+            EXPECT_EQ(expected, actual) << "at value " << index;
+    }
+};
+
+TEST_F(RegisterDecoderTests, Uint16TakesTheRegisters)
+{
+    for (const auto count : COUNTS)
+    {
+        const auto registers = randomRegisters(count);
+        auto values = std::vector<double>(count);
+        RegisterDecoder::decodeUint16(registers.data(), count, values.data());
+        for (auto i = std::size_t{0}; i < count; ++i)
+            EXPECT_EQ(static_cast<double>(registers[i]), values[i]) << "at value " << i;
+    }
+}
+
+TEST_F(RegisterDecoderTests, Int16ExtendsTheSign)
+{
+    for (const auto count : COUNTS)
+    {
+        const auto registers = randomRegisters(count);
+        auto values = std::vector<double>(count);
+        RegisterDecoder::decodeInt16(registers.data(), count, values.data());
+        for (auto i = std::size_t{0}; i < count; ++i)
+            EXPECT_EQ(static_cast<double>(static_cast<std::int16_t>(registers[i])), values[i]) << "at value " << i;
+    }
+}
+
+TEST_F(RegisterDecoderTests, Uint32MatchesDataParsers)
+{
+    for (const auto endian : {Endian::BIG, Endian::LITTLE})
+    {
+        for (const auto count : COUNTS)
+        {
+            const auto registers = randomRegisters(2 * count);
+            for (const auto offset : {std::size_t{0}, std::size_t{1}})
+            {
+                const auto source = registers.data() + offset;
+                auto values = std::vector<double>(count);
+                RegisterDecoder::decodeUint32(source, count, endian == Endian::BIG, values.data());
+                for (auto i = std::size_t{0}; i < count; ++i)
+                    expectSame(more_modbus::DataParsers::registersToUint32(pairAt(source, i), endian), values[i], i);
+            }
+        }
+    }
+}
+
+TEST_F(RegisterDecoderTests, Int32MatchesDataParsers)
+{
+    for (const auto endian : {Endian::BIG, Endian::LITTLE})
+    {
+        for (const auto count : COUNTS)
+        {
+            const auto registers = randomRegisters(2 * count);
+            for (const auto offset : {std::size_t{0}, std::size_t{1}})
+            {
+                const auto source = registers.data() + offset;
+                auto values = std::vector<double>(count);
+                RegisterDecoder::decodeInt32(source, count, endian == Endian::BIG, values.data());
+                for (auto i = std::size_t{0}; i < count; ++i)
+                    expectSame(more_modbus::DataParsers::registersToInt32(pairAt(source, i), endian), values[i], i);
+            }
+        }
+    }
+}
+
+TEST_F(RegisterDecoderTests, FloatMatchesDataParsers)
+{
+    for (const auto endian : {Endian::BIG, Endian::LITTLE})
+    {
+        for (const auto count : COUNTS)
+        {
+            const auto registers = randomRegisters(2 * count);
+            for (const auto offset : {std::size_t{0}, std::size_t{1}})
+            {
+                const auto source = registers.data() + offset;
+                auto values = std::vector<double>(count);
+                RegisterDecoder::decodeFloat(source, count, endian == Endian::BIG, values.data());
+                for (auto i = std::size_t{0}; i < count; ++i)
+                    expectSame(more_modbus::DataParsers::registersToFloat(pairAt(source, i), endian), values[i], i);
+            }
+        }
+    }
+}
+
+TEST_F(RegisterDecoderTests, NothingIsWrittenForNoValues)
+{
+    const auto registers = randomRegisters(2);
+    auto values = std::vector<double>{-1.0};
+    RegisterDecoder::decodeFloat(registers.data(), 0, true, values.data());
+    EXPECT_EQ(-1.0, values.front());
+}